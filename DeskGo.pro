@@ -14,23 +14,61 @@ SOURCES += \
     src/ui/fencewindow.cpp \
     src/ui/flowlayout.cpp \
     src/ui/iconwidget.cpp \
+    src/ui/scalediconcache.cpp \
+    src/ui/iconactions.cpp \
+    src/ui/icongridview.cpp \
+    src/ui/snapedgeindex.cpp \
+    src/ui/alignmentoverlay.cpp \
+    src/ui/fencechromecache.cpp \
     src/core/fencemanager.cpp \
     src/core/configmanager.cpp \
     src/platform/blurhelper.cpp \
     src/platform/desktophelper.cpp \
-    src/core/iconhelper.cpp
+    src/core/iconhelper.cpp \
+    src/core/fencejournal.cpp \
+    src/core/logger.cpp \
+    src/core/iconcache.cpp \
+    src/core/alphabounds.cpp \
+    src/core/iconloadscheduler.cpp \
+    src/core/storageindex.cpp \
+    src/core/fileoperationqueue.cpp \
+    src/core/crc32.cpp \
+    src/core/zipwriter.cpp \
+    src/core/backupstore.cpp \
+    src/core/storagegenerations.cpp \
+    src/core/contentmanifest.cpp \
+    src/core/autosnapshots.cpp
 
 # 头文件
 HEADERS += \
     src/ui/fencewindow.h \
     src/ui/flowlayout.h \
     src/ui/iconwidget.h \
+    src/ui/scalediconcache.h \
+    src/ui/iconactions.h \
+    src/ui/icongridview.h \
+    src/ui/snapedgeindex.h \
+    src/ui/alignmentoverlay.h \
+    src/ui/fencechromecache.h \
     src/core/fencemanager.h \
     src/core/configmanager.h \
     src/platform/blurhelper.h \
     src/platform/desktophelper.h \
     src/ui/stylehelper.h \
-    src/core/iconhelper.h
+    src/core/iconhelper.h \
+    src/core/fencejournal.h \
+    src/core/logger.h \
+    src/core/iconcache.h \
+    src/core/alphabounds.h \
+    src/core/iconloadscheduler.h \
+    src/core/storageindex.h \
+    src/core/fileoperationqueue.h \
+    src/core/crc32.h \
+    src/core/zipwriter.h \
+    src/core/backupstore.h \
+    src/core/storagegenerations.h \
+    src/core/contentmanifest.h \
+    src/core/autosnapshots.h
 
 # 资源文件
 RESOURCES += \
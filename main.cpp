@@ -1,5 +1,6 @@
 #include "src/core/fencemanager.h"
 #include "src/core/configmanager.h"
+#include "src/core/logger.h"
 #include <QApplication>
 #include <QDebug>
 #include <QIcon>
@@ -14,6 +15,7 @@
 #include <QDir>
 #include <QLockFile>
 #include <QMessageBox>
+#include <QStandardPaths>
 
 int main(int argc, char *argv[]) {
   // 启用高 DPI 缩放，解决 2K/4K 屏幕文字模糊问题
@@ -32,6 +34,11 @@ int main(int argc, char *argv[]) {
   a.setApplicationVersion("1.7.0");
   a.setOrganizationName("DeskGo");
 
+  // 启动异步日志写入线程（路径依赖上面设置的应用名）
+  Logger::initialize(
+      QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) +
+      "/msix_debug.txt");
+
   QIcon appIcon(":/icons/app.ico");
   if (appIcon.isNull()) {
     appIcon = QIcon(":/icons/app.png");
@@ -96,6 +103,7 @@ int main(int argc, char *argv[]) {
 
   // 显式清理资源，确保在 QApplication 析构前完成
   FenceManager::instance()->shutdown();
+  Logger::shutdown();
 
 #ifdef Q_OS_WIN
   CoUninitialize();
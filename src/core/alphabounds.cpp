@@ -0,0 +1,269 @@
+#include "alphabounds.h"
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ALPHABOUNDS_X86 1
+#define ALPHABOUNDS_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define ALPHABOUNDS_X86 1
+#define ALPHABOUNDS_TARGET(isa)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace {
+
+const std::uint32_t kAlphaMask = 0xFF000000u;
+
+// 行内查找函数：在 [begin, end) 中返回第一个 / 最后一个 alpha 非零像素的下标，没有则返回 -1
+typedef int (*ScanFn)(const std::uint32_t *row, int begin, int end);
+
+struct Kernel {
+    ScanFn first;
+    ScanFn last;
+    const char *name;
+};
+
+int firstScalar(const std::uint32_t *row, int begin, int end)
+{
+    for (int x = begin; x < end; ++x) {
+        if (row[x] & kAlphaMask) {
+            return x;
+        }
+    }
+    return -1;
+}
+
+int lastScalar(const std::uint32_t *row, int begin, int end)
+{
+    for (int x = end - 1; x >= begin; --x) {
+        if (row[x] & kAlphaMask) {
+            return x;
+        }
+    }
+    return -1;
+}
+
+#ifdef ALPHABOUNDS_X86
+
+inline int lowestBit(unsigned int mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline int highestBit(unsigned int mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+// 每个 32 位通道与 alpha 掩码相与后和 0 比较，movemask 得到“alpha 非零”的像素位图
+ALPHABOUNDS_TARGET("sse2")
+inline unsigned int opaqueMask4(const std::uint32_t *pixels)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels));
+    const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(static_cast<int>(kAlphaMask))),
+                                                _mm_setzero_si128());
+    return static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(transparent))) ^ 0xFu;
+}
+
+ALPHABOUNDS_TARGET("sse2")
+int firstSse2(const std::uint32_t *row, int begin, int end)
+{
+    int x = begin;
+    for (; x + 4 <= end; x += 4) {
+        const unsigned int mask = opaqueMask4(row + x);
+        if (mask) {
+            return x + lowestBit(mask);
+        }
+    }
+    return firstScalar(row, x, end);
+}
+
+ALPHABOUNDS_TARGET("sse2")
+int lastSse2(const std::uint32_t *row, int begin, int end)
+{
+    int x = end;
+    for (; x - 4 >= begin; x -= 4) {
+        const unsigned int mask = opaqueMask4(row + x - 4);
+        if (mask) {
+            return x - 4 + highestBit(mask);
+        }
+    }
+    return lastScalar(row, begin, x);
+}
+
+ALPHABOUNDS_TARGET("avx2")
+inline unsigned int opaqueMask8(const std::uint32_t *pixels)
+{
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels));
+    const __m256i transparent = _mm256_cmpeq_epi32(
+        _mm256_and_si256(v, _mm256_set1_epi32(static_cast<int>(kAlphaMask))), _mm256_setzero_si256());
+    return static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(transparent))) ^ 0xFFu;
+}
+
+ALPHABOUNDS_TARGET("avx2")
+int firstAvx2(const std::uint32_t *row, int begin, int end)
+{
+    int x = begin;
+    for (; x + 8 <= end; x += 8) {
+        const unsigned int mask = opaqueMask8(row + x);
+        if (mask) {
+            return x + lowestBit(mask);
+        }
+    }
+    return firstScalar(row, x, end);
+}
+
+ALPHABOUNDS_TARGET("avx2")
+int lastAvx2(const std::uint32_t *row, int begin, int end)
+{
+    int x = end;
+    for (; x - 8 >= begin; x -= 8) {
+        const unsigned int mask = opaqueMask8(row + x - 8);
+        if (mask) {
+            return x - 8 + highestBit(mask);
+        }
+    }
+    return lastScalar(row, begin, x);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false; // 操作系统未保存 YMM 寄存器状态
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool cpuHasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif // ALPHABOUNDS_X86
+
+const Kernel &kernel()
+{
+    static const Kernel selected = []() -> Kernel {
+#ifdef ALPHABOUNDS_X86
+        if (cpuHasAvx2()) {
+            return {firstAvx2, lastAvx2, "avx2"};
+        }
+        if (cpuHasSse2()) {
+            return {firstSse2, lastSse2, "sse2"};
+        }
+#endif
+        return {firstScalar, lastScalar, "scalar"};
+    }();
+    return selected;
+}
+
+inline const std::uint32_t *scanLine(const unsigned char *bits, int bytesPerLine, int y)
+{
+    return reinterpret_cast<const std::uint32_t *>(bits + static_cast<std::ptrdiff_t>(bytesPerLine) * y);
+}
+
+} // namespace
+
+namespace AlphaBounds {
+
+bool find(const unsigned char *bits, int width, int height, int bytesPerLine, Rect *bounds)
+{
+    if (!bits || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const Kernel &k = kernel();
+    int left = width;
+    int right = -1;
+
+    // 自上而下找第一行；该行同时给出左右边界的初始值
+    int top = 0;
+    for (; top < height; ++top) {
+        const std::uint32_t *row = scanLine(bits, bytesPerLine, top);
+        const int first = k.first(row, 0, width);
+        if (first >= 0) {
+            left = first;
+            right = k.last(row, first, width);
+            break;
+        }
+    }
+    if (top == height) {
+        return false;
+    }
+
+    // 自下而上找最后一行（至多回到 top）
+    int bottom = height - 1;
+    for (; bottom > top; --bottom) {
+        const std::uint32_t *row = scanLine(bits, bytesPerLine, bottom);
+        const int first = k.first(row, 0, width);
+        if (first >= 0) {
+            if (first < left) left = first;
+            const int last = k.last(row, first, width);
+            if (last > right) right = last;
+            break;
+        }
+    }
+
+    // 中间各行只需检查当前左边界以左、右边界以右的部分，边界触及图像边缘即可停止
+    for (int y = top + 1; y < bottom && (left > 0 || right < width - 1); ++y) {
+        const std::uint32_t *row = scanLine(bits, bytesPerLine, y);
+        if (left > 0) {
+            const int first = k.first(row, 0, left);
+            if (first >= 0) left = first;
+        }
+        if (right < width - 1) {
+            const int last = k.last(row, right + 1, width);
+            if (last >= 0) right = last;
+        }
+    }
+
+    bounds->left = left;
+    bounds->top = top;
+    bounds->right = right;
+    bounds->bottom = bottom;
+    return true;
+}
+
+const char *implementationName()
+{
+    return kernel().name;
+}
+
+} // namespace AlphaBounds
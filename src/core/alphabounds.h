@@ -0,0 +1,30 @@
+#ifndef ALPHABOUNDS_H
+#define ALPHABOUNDS_H
+
+#include <cstdint>
+
+/**
+ * @brief 非透明像素包围盒查找
+ * 直接在 ARGB32 / ARGB32_Premultiplied 扫描行上工作（每像素 32 位，alpha 位于高字节）。
+ * 先从上、下两端找到首个含不透明像素的行，再只在这两行之间从左、右两端向内收缩，
+ * 不必扫描整幅图像。运行时检测 CPU：AVX2 每次比较 8 个像素，SSE2 每次 4 个，
+ * 其他平台使用标量实现，三者结果一致。
+ */
+namespace AlphaBounds {
+
+struct Rect {
+    int left = 0;
+    int top = 0;
+    int right = -1;   // 含
+    int bottom = -1;  // 含
+};
+
+// 返回 false 表示图像全透明或为空；bytesPerLine 可包含行尾填充
+bool find(const unsigned char *bits, int width, int height, int bytesPerLine, Rect *bounds);
+
+// 当前使用的实现："avx2" / "sse2" / "scalar"
+const char *implementationName();
+
+} // namespace AlphaBounds
+
+#endif // ALPHABOUNDS_H
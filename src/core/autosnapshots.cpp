@@ -0,0 +1,359 @@
+#include "autosnapshots.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int kManifestVersion = 1;
+const char *kManifestFileName = "snapshot.json";
+const char *kPartialSuffix = ".partial";
+const char *kIdFormat = "yyyyMMdd_HHmmss";
+const int kIdLength = 15;
+const char *kStorageDirName = "fences_storage";
+
+struct FileStamp {
+    qint64 size = 0;
+    qint64 modified = 0;
+
+    bool operator==(const FileStamp &other) const { return size == other.size && modified == other.modified; }
+    bool operator!=(const FileStamp &other) const { return !(*this == other); }
+};
+
+// 快照内路径（fences_storage/...）-> 拍快照时存储文件的大小和修改时间
+typedef QHash<QString, FileStamp> FileStamps;
+
+QDateTime idTime(const QString &id)
+{
+    return QDateTime::fromString(id.left(kIdLength), kIdFormat);
+}
+
+QString contentHash(const QByteArray &data)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+}
+
+bool createHardLink(const QString &existingPath, const QString &linkPath)
+{
+#ifdef Q_OS_WIN
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(linkPath).utf16()),
+                           reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(existingPath).utf16()),
+                           nullptr) != 0;
+#else
+    return ::link(QFile::encodeName(existingPath).constData(), QFile::encodeName(linkPath).constData()) == 0;
+#endif
+}
+
+FileStamps scanStorage(const QString &storageDir)
+{
+    FileStamps stamps;
+    const QDir root(storageDir);
+    QDirIterator it(storageDir, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        FileStamp stamp;
+        stamp.size = it.fileInfo().size();
+        stamp.modified = it.fileInfo().lastModified().toMSecsSinceEpoch();
+        stamps.insert(QString("%1/%2").arg(kStorageDirName, root.relativeFilePath(it.filePath())), stamp);
+    }
+    return stamps;
+}
+
+bool readManifest(const QString &snapshotDir, QJsonObject *manifest, FileStamps *stamps)
+{
+    QFile file(snapshotDir + "/" + kManifestFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    if (!document.isObject() || document.object().value("version").toInt() != kManifestVersion) {
+        return false;
+    }
+
+    *manifest = document.object();
+    const QJsonObject files = manifest->value("files").toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        const QJsonArray values = it.value().toArray();
+        FileStamp stamp;
+        stamp.size = qint64(values.at(0).toDouble());
+        stamp.modified = qint64(values.at(1).toDouble());
+        stamps->insert(it.key(), stamp);
+    }
+    return true;
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+} // namespace
+
+AutoSnapshots::AutoSnapshots(const QString &rootPath)
+    : m_rootPath(QDir::cleanPath(rootPath))
+{
+}
+
+QString AutoSnapshots::snapshotPath(const QString &id) const
+{
+    return m_rootPath + "/" + id;
+}
+
+QStringList AutoSnapshots::snapshotIds() const
+{
+    QStringList ids;
+    const QStringList names = QDir(m_rootPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString &name : names) {
+        if (!name.endsWith(kPartialSuffix) && idTime(name).isValid()) {
+            ids.append(name);
+        }
+    }
+    // id 以时间戳开头，按名称倒序即从新到旧
+    std::reverse(ids.begin(), ids.end());
+    return ids;
+}
+
+QList<AutoSnapshots::Snapshot> AutoSnapshots::snapshots() const
+{
+    QList<Snapshot> result;
+    for (const QString &id : snapshotIds()) {
+        Snapshot snapshot;
+        snapshot.id = id;
+        snapshot.created = idTime(id);
+        result.append(snapshot);
+    }
+    return result;
+}
+
+bool AutoSnapshots::create(const QByteArray &fencesJson, const QString &settingsPath, const QString &storageDir,
+                           const std::function<bool()> &consistent,
+                           QString *snapshotId, Stats *stats, bool *unchanged, QString *errorMessage)
+{
+    if (unchanged) {
+        *unchanged = false;
+    }
+    if (!QDir().mkpath(m_rootPath)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法创建目录：%1").arg(QDir::toNativeSeparators(m_rootPath));
+        }
+        return false;
+    }
+
+    QByteArray settingsData;
+    QFile settingsFile(settingsPath);
+    if (settingsFile.open(QIODevice::ReadOnly)) {
+        settingsData = settingsFile.readAll();
+    }
+    const QString fencesHash = contentHash(fencesJson);
+    const QString settingsHash = contentHash(settingsData);
+    const FileStamps current = scanStorage(storageDir);
+
+    // 上一份快照：没有变化时不创建，未变的存储文件链接到其中的同一文件
+    const QStringList ids = snapshotIds();
+    const QString previousDir = ids.isEmpty() ? QString() : snapshotPath(ids.first());
+    QJsonObject previousManifest;
+    FileStamps previous;
+    if (!previousDir.isEmpty() && readManifest(previousDir, &previousManifest, &previous)
+        && previousManifest.value("fencesHash").toString() == fencesHash
+        && previousManifest.value("settingsHash").toString() == settingsHash
+        && previous == current) {
+        if (unchanged) {
+            *unchanged = true;
+        }
+        return true;
+    }
+
+    QString id = QDateTime::currentDateTime().toString(kIdFormat);
+    while (QFileInfo::exists(snapshotPath(id))) {
+        id += "_";
+    }
+    const QString partialDir = snapshotPath(id) + kPartialSuffix;
+    QDir(partialDir).removeRecursively();
+
+    auto fail = [&partialDir, errorMessage](const QString &message) {
+        QDir(partialDir).removeRecursively();
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+
+    if (!QDir().mkpath(partialDir + "/" + kStorageDirName)) {
+        return fail(QString("无法创建目录：%1").arg(QDir::toNativeSeparators(partialDir)));
+    }
+    if (!writeFile(partialDir + "/fencing_config.json", fencesJson)) {
+        return fail(QString("写入快照失败：%1").arg(QDir::toNativeSeparators(partialDir)));
+    }
+    if (!settingsData.isEmpty() && !writeFile(partialDir + "/user_settings.ini", settingsData)) {
+        return fail(QString("写入快照失败：%1").arg(QDir::toNativeSeparators(partialDir)));
+    }
+
+    Stats result;
+    QJsonObject files;
+    const QString storagePrefix = QString(kStorageDirName) + "/";
+    for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+        const QString &name = it.key();
+        const QString targetPath = partialDir + "/" + name;
+        QDir().mkpath(QFileInfo(targetPath).absolutePath());
+
+        // 链接失败（非 NTFS、跨卷或链接数达到上限）时退回复制
+        bool linked = false;
+        if (previous.contains(name) && previous.value(name) == it.value()) {
+            linked = createHardLink(previousDir + "/" + name, targetPath);
+        }
+        if (linked) {
+            ++result.linkedFiles;
+        } else {
+            const QString sourcePath = storageDir + "/" + name.mid(storagePrefix.size());
+            if (!QFile::copy(sourcePath, targetPath)) {
+                return fail(QString("复制文件失败：%1").arg(QDir::toNativeSeparators(sourcePath)));
+            }
+            result.copiedBytes += it.value().size;
+        }
+        ++result.fileCount;
+        files.insert(name, QJsonArray{double(it.value().size), double(it.value().modified)});
+    }
+
+    QJsonObject manifest;
+    manifest["version"] = kManifestVersion;
+    manifest["fencesHash"] = fencesHash;
+    manifest["settingsHash"] = settingsHash;
+    manifest["files"] = files;
+    if (!writeFile(partialDir + "/" + kManifestFileName, QJsonDocument(manifest).toJson(QJsonDocument::Compact))) {
+        return fail(QString("写入快照清单失败：%1").arg(QDir::toNativeSeparators(partialDir)));
+    }
+
+    if (consistent && !consistent()) {
+        return fail("拍摄期间图标文件发生了变动，已放弃本次快照");
+    }
+
+    // 目录完整后才改名生效，中断留下的 .partial 由 prune() 清理
+    if (!QDir().rename(partialDir, snapshotPath(id))) {
+        return fail(QString("无法移动目录：%1").arg(QDir::toNativeSeparators(partialDir)));
+    }
+
+    if (snapshotId) {
+        *snapshotId = id;
+    }
+    if (stats) {
+        *stats = result;
+    }
+    return true;
+}
+
+QStringList AutoSnapshots::expiredIds(const QStringList &ids, const Retention &retention)
+{
+    QSet<QString> kept;
+    if (!ids.isEmpty()) {
+        kept.insert(ids.first());
+    }
+
+    // 每档依次遍历：遇到新的时间段就保留该段最新的一份，段数用完即停
+    auto keepNewestPerPeriod = [&ids, &kept](int periods, const std::function<QString(const QDateTime &)> &periodOf) {
+        QSet<QString> seen;
+        for (const QString &id : ids) {
+            if (seen.size() >= periods) {
+                break;
+            }
+            const QString period = periodOf(idTime(id));
+            if (!seen.contains(period)) {
+                seen.insert(period);
+                kept.insert(id);
+            }
+        }
+    };
+    keepNewestPerPeriod(retention.hourly, [](const QDateTime &time) { return time.toString("yyyyMMddHH"); });
+    keepNewestPerPeriod(retention.daily, [](const QDateTime &time) { return time.toString("yyyyMMdd"); });
+    keepNewestPerPeriod(retention.weekly, [](const QDateTime &time) {
+        int year = 0;
+        const int week = time.date().weekNumber(&year);
+        return QString("%1-%2").arg(year).arg(week);
+    });
+
+    QStringList expired;
+    for (const QString &id : ids) {
+        if (!kept.contains(id)) {
+            expired.append(id);
+        }
+    }
+    return expired;
+}
+
+int AutoSnapshots::prune(const Retention &retention)
+{
+    int removed = 0;
+    for (const QString &id : expiredIds(snapshotIds(), retention)) {
+        // 删除一份快照只去掉其中的链接，仍被其他快照链接的文件内容保留
+        if (QDir(snapshotPath(id)).removeRecursively()) {
+            ++removed;
+        }
+    }
+
+    const QStringList partials = QDir(m_rootPath).entryList({QString("*") + kPartialSuffix}, QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : partials) {
+        QDir(snapshotPath(name)).removeRecursively();
+    }
+    return removed;
+}
+
+bool AutoSnapshots::copyTo(const QString &snapshotId, const QString &targetDir, const Progress &progress, QString *errorMessage) const
+{
+    const QString sourceDir = snapshotPath(snapshotId);
+    const QDir root(sourceDir);
+
+    QStringList names;
+    qint64 totalBytes = 0;
+    QDirIterator it(sourceDir, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QString name = root.relativeFilePath(it.filePath());
+        if (name == kManifestFileName) {
+            continue;
+        }
+        names.append(name);
+        totalBytes += it.fileInfo().size();
+    }
+    if (names.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = QString("快照不存在或为空：%1").arg(snapshotId);
+        }
+        return false;
+    }
+
+    qint64 doneBytes = 0;
+    for (const QString &name : qAsConst(names)) {
+        const QString sourcePath = sourceDir + "/" + name;
+        const QString targetPath = QDir::cleanPath(targetDir + "/" + name);
+        QDir().mkpath(QFileInfo(targetPath).absolutePath());
+        QFile::remove(targetPath);
+        if (!QFile::copy(sourcePath, targetPath)) {
+            if (errorMessage) {
+                *errorMessage = QString("复制文件失败：%1").arg(QDir::toNativeSeparators(sourcePath));
+            }
+            return false;
+        }
+        doneBytes += QFileInfo(sourcePath).size();
+        if (progress && !progress(doneBytes, totalBytes)) {
+            if (errorMessage) {
+                *errorMessage = "已取消";
+            }
+            return false;
+        }
+    }
+    return true;
+}
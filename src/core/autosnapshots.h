@@ -0,0 +1,73 @@
+#ifndef AUTOSNAPSHOTS_H
+#define AUTOSNAPSHOTS_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+/**
+ * @brief 定时自动快照（硬链接轮转）
+ * 每份快照是 <root>/<id>/ 下一个完整的备份目录（fencing_config.json、user_settings.ini、fences_storage/），
+ * 取出后即可交给还原流程。大小和修改时间与上一份快照记录一致的存储文件以硬链接指向上一份快照中的同一文件，
+ * 不复制内容，因此数据没怎么变化时一份快照几乎不占空间和时间。
+ * 硬链接只在快照之间建立，不链接正在使用的存储文件：围栏中的文档被原地编辑时不会波及已有快照。
+ * 快照先在 <id>.partial 中建好，完成后改名生效。
+ * 保留策略按小时、天、周分档，只根据快照名中的时间计算，与快照中的文件数无关。
+ */
+class AutoSnapshots
+{
+public:
+    // progress(已处理字节, 总字节)，在调用线程中回调；返回 false 取消
+    typedef std::function<bool(qint64, qint64)> Progress;
+
+    // 每档保留最近若干个时间段（小时/天/ISO 周）中各自最新的一份
+    struct Retention {
+        int hourly = 24;
+        int daily = 7;
+        int weekly = 4;
+    };
+
+    struct Snapshot {
+        QString id;
+        QDateTime created;
+    };
+
+    struct Stats {
+        int fileCount = 0;
+        int linkedFiles = 0;  // 以硬链接沿用上一份快照的文件数
+        qint64 copiedBytes = 0;
+    };
+
+    explicit AutoSnapshots(const QString &rootPath);
+
+    QString rootPath() const { return m_rootPath; }
+
+    // fencesJson 为当前布局（内存中的最新状态，不依赖增量日志是否已合并），storageDir 为当前代存储目录。
+    // 与上一份快照相比没有任何变化时不创建快照，unchanged 置为 true。
+    // consistent 在快照建好、改名生效前调用，返回 false（拍摄期间存储目录有变动，与 fencesJson 可能不一致）时放弃本次快照
+    bool create(const QByteArray &fencesJson, const QString &settingsPath, const QString &storageDir,
+                const std::function<bool()> &consistent,
+                QString *snapshotId, Stats *stats, bool *unchanged, QString *errorMessage);
+
+    // 按创建时间从新到旧
+    QList<Snapshot> snapshots() const;
+
+    // 删除保留策略之外的快照和中断留下的 .partial 目录；会删除整棵目录树，应在后台线程调用
+    int prune(const Retention &retention);
+    // ids 按从新到旧排列，返回保留策略之外的 id；最新一份总是保留
+    static QStringList expiredIds(const QStringList &ids, const Retention &retention);
+
+    // 把快照复制（而非链接）到 targetDir，还原后的存储文件与快照互不影响
+    bool copyTo(const QString &snapshotId, const QString &targetDir, const Progress &progress, QString *errorMessage) const;
+
+private:
+    QStringList snapshotIds() const;
+    QString snapshotPath(const QString &id) const;
+
+    QString m_rootPath;
+};
+
+#endif // AUTOSNAPSHOTS_H
@@ -0,0 +1,545 @@
+#include "backupstore.h"
+#include "contentmanifest.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+const int kManifestVersion = 1;
+const char *kObjectsDirName = "objects";
+const char *kSnapshotsDirName = "snapshots";
+
+QString chunkHash(const QByteArray &chunk)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(chunk, QCryptographicHash::Sha256).toHex());
+}
+
+// 快照内路径必须是相对路径且不能跳出还原目录
+bool isSafeEntryName(const QString &name)
+{
+    const QString cleaned = QDir::cleanPath(name);
+    return !cleaned.isEmpty() && !QDir::isAbsolutePath(cleaned)
+        && cleaned != ".." && !cleaned.startsWith("../") && !cleaned.contains(':');
+}
+
+QJsonArray snapshotFiles(const QJsonObject &manifest)
+{
+    return manifest.value("files").toArray();
+}
+
+struct ChunkCheck {
+    bool intact = false;
+    qint64 size = 0;
+    QString error;
+};
+
+} // namespace
+
+BackupStore::BackupStore(const QString &rootPath)
+    : m_rootPath(QDir::cleanPath(rootPath))
+{
+}
+
+void BackupStore::addFile(const QString &name, const QString &sourcePath)
+{
+    PendingEntry entry;
+    entry.name = name;
+    entry.sourcePath = sourcePath;
+    m_pending.append(entry);
+}
+
+void BackupStore::addData(const QString &name, const QByteArray &data)
+{
+    PendingEntry entry;
+    entry.name = name;
+    entry.data = data;
+    m_pending.append(entry);
+}
+
+QString BackupStore::objectPath(const QString &hash) const
+{
+    return QString("%1/%2/%3/%4").arg(m_rootPath, kObjectsDirName, hash.left(2), hash);
+}
+
+QString BackupStore::snapshotPath(const QString &id) const
+{
+    return QString("%1/%2/%3.json").arg(m_rootPath, kSnapshotsDirName, id);
+}
+
+bool BackupStore::readSnapshot(const QString &id, QJsonObject *manifest, QString *errorMessage) const
+{
+    QFile file(snapshotPath(id));
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法读取快照：%1").arg(id);
+        }
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()
+        || document.object().value("version").toInt() != kManifestVersion) {
+        if (errorMessage) {
+            *errorMessage = QString("快照清单已损坏：%1").arg(id);
+        }
+        return false;
+    }
+
+    *manifest = document.object();
+    return true;
+}
+
+bool BackupStore::storeChunk(const QByteArray &chunk, QString *hash, bool *stored, QString *errorMessage)
+{
+    *hash = chunkHash(chunk);
+    *stored = false;
+
+    const QString path = objectPath(*hash);
+    if (QFile::exists(path)) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(chunk) != chunk.size() || !file.commit()) {
+        if (errorMessage) {
+            *errorMessage = QString("写入备份分块失败：%1").arg(QDir::toNativeSeparators(path));
+        }
+        return false;
+    }
+
+    *stored = true;
+    return true;
+}
+
+bool BackupStore::readChunk(const QString &hash, QByteArray *chunk, QString *errorMessage) const
+{
+    QFile file(objectPath(hash));
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = QString("缺少备份分块：%1").arg(hash);
+        }
+        return false;
+    }
+
+    *chunk = file.readAll();
+    if (chunkHash(*chunk) != hash) {
+        if (errorMessage) {
+            *errorMessage = QString("备份分块已损坏：%1").arg(hash);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool BackupStore::commit(const Progress &progress, QString *snapshotId, Stats *stats, QString *errorMessage)
+{
+    const QVector<PendingEntry> pending = m_pending;
+    m_pending.clear();
+
+    if (!QDir().mkpath(m_rootPath + "/" + kObjectsDirName) || !QDir().mkpath(m_rootPath + "/" + kSnapshotsDirName)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法创建备份库目录：%1").arg(QDir::toNativeSeparators(m_rootPath));
+        }
+        return false;
+    }
+
+    // 上一份快照中各文件的记录，大小和修改时间未变的文件直接沿用
+    QHash<QString, QJsonObject> previousFiles;
+    const QStringList existing = snapshotIds();
+    QJsonObject previousManifest;
+    if (!existing.isEmpty() && readSnapshot(existing.first(), &previousManifest, nullptr)) {
+        for (const QJsonValue &value : snapshotFiles(previousManifest)) {
+            const QJsonObject fileObject = value.toObject();
+            previousFiles.insert(fileObject.value("name").toString(), fileObject);
+        }
+    }
+
+    Stats result;
+    QVector<QFileInfo> infos(pending.size());
+    for (int i = 0; i < pending.size(); ++i) {
+        if (!pending.at(i).sourcePath.isEmpty()) {
+            infos[i] = QFileInfo(pending.at(i).sourcePath);
+            result.totalBytes += infos.at(i).size();
+        } else {
+            result.totalBytes += pending.at(i).data.size();
+        }
+    }
+
+    qint64 doneBytes = 0;
+    QJsonArray files;
+    for (int i = 0; i < pending.size(); ++i) {
+        const PendingEntry &entry = pending.at(i);
+        QJsonObject fileObject;
+        fileObject["name"] = entry.name;
+
+        if (!entry.sourcePath.isEmpty()) {
+            const QFileInfo &info = infos.at(i);
+            // 修改时间在读取前取得：读取期间文件被改写时，下次备份会重新读取
+            const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+            const QJsonObject previous = previousFiles.value(entry.name);
+            // 没有文件哈希的旧记录重新读取一次，之后的快照即可沿用
+            if (!previous.isEmpty() && previous.contains("sha256")
+                && qint64(previous.value("size").toDouble()) == info.size()
+                && qint64(previous.value("modified").toDouble()) == modified) {
+                files.append(previous);
+                ++result.reusedFiles;
+                doneBytes += info.size();
+                if (progress && !progress(doneBytes, result.totalBytes)) {
+                    if (errorMessage) {
+                        *errorMessage = "已取消";
+                    }
+                    return false;
+                }
+                continue;
+            }
+
+            QFile source(entry.sourcePath);
+            if (!source.open(QIODevice::ReadOnly)) {
+                if (errorMessage) {
+                    *errorMessage = QString("无法读取文件：%1").arg(QDir::toNativeSeparators(entry.sourcePath));
+                }
+                return false;
+            }
+
+            QJsonArray chunks;
+            qint64 size = 0;
+            QCryptographicHash fileHash(QCryptographicHash::Sha256);
+            while (true) {
+                const QByteArray chunk = source.read(kChunkSize);
+                if (chunk.isEmpty()) {
+                    break;
+                }
+                fileHash.addData(chunk);
+                QString hash;
+                bool stored = false;
+                if (!storeChunk(chunk, &hash, &stored, errorMessage)) {
+                    return false;
+                }
+                if (stored) {
+                    ++result.storedChunks;
+                    result.storedBytes += chunk.size();
+                }
+                chunks.append(hash);
+                size += chunk.size();
+                doneBytes += chunk.size();
+                if (progress && !progress(doneBytes, result.totalBytes)) {
+                    if (errorMessage) {
+                        *errorMessage = "已取消";
+                    }
+                    return false;
+                }
+            }
+            if (source.error() != QFileDevice::NoError) {
+                if (errorMessage) {
+                    *errorMessage = QString("读取文件失败：%1").arg(QDir::toNativeSeparators(entry.sourcePath));
+                }
+                return false;
+            }
+
+            fileObject["size"] = double(size);
+            fileObject["modified"] = double(modified);
+            fileObject["sha256"] = QString::fromLatin1(fileHash.result().toHex());
+            fileObject["chunks"] = chunks;
+        } else {
+            QJsonArray chunks;
+            for (qint64 offset = 0; offset < entry.data.size(); offset += kChunkSize) {
+                const QByteArray chunk = entry.data.mid(int(offset), int(kChunkSize));
+                QString hash;
+                bool stored = false;
+                if (!storeChunk(chunk, &hash, &stored, errorMessage)) {
+                    return false;
+                }
+                if (stored) {
+                    ++result.storedChunks;
+                    result.storedBytes += chunk.size();
+                }
+                chunks.append(hash);
+            }
+            doneBytes += entry.data.size();
+            fileObject["size"] = double(entry.data.size());
+            fileObject["sha256"] = ContentManifest::hashData(entry.data);
+            fileObject["chunks"] = chunks;
+        }
+
+        files.append(fileObject);
+    }
+    result.fileCount = files.size();
+
+    // 清单最后写入：分块都已落盘后快照才可见
+    const QDateTime created = QDateTime::currentDateTime();
+    QString id = created.toString("yyyyMMdd_HHmmss_zzz");
+    while (QFile::exists(snapshotPath(id))) {
+        id += "_";
+    }
+
+    QJsonObject manifest;
+    manifest["version"] = kManifestVersion;
+    manifest["created"] = created.toString(Qt::ISODateWithMs);
+    manifest["chunkSize"] = double(kChunkSize);
+    manifest["fileCount"] = result.fileCount;
+    manifest["totalBytes"] = double(result.totalBytes);
+    manifest["files"] = files;
+
+    QSaveFile manifestFile(snapshotPath(id));
+    const QByteArray manifestData = QJsonDocument(manifest).toJson(QJsonDocument::Compact);
+    if (!manifestFile.open(QIODevice::WriteOnly) || manifestFile.write(manifestData) != manifestData.size()
+        || !manifestFile.commit()) {
+        if (errorMessage) {
+            *errorMessage = QString("写入快照清单失败：%1").arg(QDir::toNativeSeparators(snapshotPath(id)));
+        }
+        return false;
+    }
+
+    if (snapshotId) {
+        *snapshotId = id;
+    }
+    if (stats) {
+        *stats = result;
+    }
+    return true;
+}
+
+QStringList BackupStore::snapshotIds() const
+{
+    QStringList ids;
+    const QStringList names = QDir(m_rootPath + "/" + kSnapshotsDirName).entryList({"*.json"}, QDir::Files, QDir::Name);
+    for (const QString &name : names) {
+        ids.append(name.left(name.size() - 5));
+    }
+    // id 以时间戳开头，按名称倒序即从新到旧
+    std::reverse(ids.begin(), ids.end());
+    return ids;
+}
+
+QList<BackupStore::Snapshot> BackupStore::snapshots() const
+{
+    QList<Snapshot> result;
+    for (const QString &id : snapshotIds()) {
+        QJsonObject manifest;
+        if (!readSnapshot(id, &manifest, nullptr)) {
+            continue;
+        }
+        Snapshot snapshot;
+        snapshot.id = id;
+        snapshot.created = QDateTime::fromString(manifest.value("created").toString(), Qt::ISODateWithMs);
+        snapshot.fileCount = manifest.value("fileCount").toInt();
+        snapshot.totalBytes = qint64(manifest.value("totalBytes").toDouble());
+        result.append(snapshot);
+    }
+    return result;
+}
+
+bool BackupStore::restore(const QString &snapshotId, const QString &targetDir, const Progress &progress, QString *errorMessage) const
+{
+    QJsonObject manifest;
+    if (!readSnapshot(snapshotId, &manifest, errorMessage)) {
+        return false;
+    }
+
+    const qint64 totalBytes = qint64(manifest.value("totalBytes").toDouble());
+    qint64 doneBytes = 0;
+    for (const QJsonValue &value : snapshotFiles(manifest)) {
+        const QJsonObject fileObject = value.toObject();
+        const QString name = fileObject.value("name").toString();
+        if (!isSafeEntryName(name)) {
+            if (errorMessage) {
+                *errorMessage = QString("快照中包含非法路径：%1").arg(name);
+            }
+            return false;
+        }
+
+        const QString targetPath = QDir::cleanPath(targetDir + "/" + name);
+        QDir().mkpath(QFileInfo(targetPath).absolutePath());
+        QSaveFile target(targetPath);
+        if (!target.open(QIODevice::WriteOnly)) {
+            if (errorMessage) {
+                *errorMessage = QString("无法写入文件：%1").arg(QDir::toNativeSeparators(targetPath));
+            }
+            return false;
+        }
+
+        for (const QJsonValue &hashValue : fileObject.value("chunks").toArray()) {
+            QByteArray chunk;
+            if (!readChunk(hashValue.toString(), &chunk, errorMessage)) {
+                target.cancelWriting();
+                return false;
+            }
+            if (target.write(chunk) != chunk.size()) {
+                target.cancelWriting();
+                if (errorMessage) {
+                    *errorMessage = QString("写入文件失败：%1").arg(QDir::toNativeSeparators(targetPath));
+                }
+                return false;
+            }
+            doneBytes += chunk.size();
+            if (progress && !progress(doneBytes, totalBytes)) {
+                target.cancelWriting();
+                if (errorMessage) {
+                    *errorMessage = "已取消";
+                }
+                return false;
+            }
+        }
+
+        if (!target.commit()) {
+            if (errorMessage) {
+                *errorMessage = QString("写入文件失败：%1").arg(QDir::toNativeSeparators(targetPath));
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BackupStore::verify(const QString &snapshotId, const Progress &progress, QStringList *problems, QString *errorMessage) const
+{
+    QJsonObject manifest;
+    if (!readSnapshot(snapshotId, &manifest, errorMessage)) {
+        return false;
+    }
+    const QJsonArray files = snapshotFiles(manifest);
+
+    // 每个不同的分块只校验一次，在专用线程池中并行读取和计算哈希，按文件顺序取结果
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    QHash<QString, QFuture<ChunkCheck>> checks;
+    for (const QJsonValue &value : files) {
+        for (const QJsonValue &hashValue : value.toObject().value("chunks").toArray()) {
+            const QString hash = hashValue.toString();
+            if (checks.contains(hash)) {
+                continue;
+            }
+            checks.insert(hash, QtConcurrent::run(&pool, [this, hash]() {
+                ChunkCheck check;
+                QByteArray chunk;
+                check.intact = readChunk(hash, &chunk, &check.error);
+                check.size = chunk.size();
+                return check;
+            }));
+        }
+    }
+
+    const qint64 totalBytes = qint64(manifest.value("totalBytes").toDouble());
+    qint64 doneBytes = 0;
+    for (const QJsonValue &value : files) {
+        const QJsonObject fileObject = value.toObject();
+        const QString name = fileObject.value("name").toString();
+        const qint64 expectedSize = qint64(fileObject.value("size").toDouble());
+        qint64 size = 0;
+        bool intact = true;
+
+        for (const QJsonValue &hashValue : fileObject.value("chunks").toArray()) {
+            const ChunkCheck check = checks.value(hashValue.toString()).result();
+            if (!check.intact) {
+                if (problems) {
+                    problems->append(QString("%1：%2").arg(name, check.error));
+                }
+                intact = false;
+                break;
+            }
+            size += check.size;
+            doneBytes += check.size;
+            if (progress && !progress(doneBytes, totalBytes)) {
+                pool.clear();
+                pool.waitForDone();
+                if (errorMessage) {
+                    *errorMessage = "已取消";
+                }
+                return false;
+            }
+        }
+
+        if (intact && size != expectedSize && problems) {
+            problems->append(QString("%1：大小不符（应为 %2 字节，实际 %3 字节）").arg(name).arg(expectedSize).arg(size));
+        }
+    }
+    return true;
+}
+
+bool BackupStore::contentManifest(const QString &snapshotId, ContentManifest *manifest, QString *errorMessage) const
+{
+    QJsonObject snapshot;
+    if (!readSnapshot(snapshotId, &snapshot, errorMessage)) {
+        return false;
+    }
+
+    for (const QJsonValue &value : snapshotFiles(snapshot)) {
+        const QJsonObject fileObject = value.toObject();
+        if (!fileObject.contains("sha256")) {
+            if (errorMessage) {
+                *errorMessage = QString("快照 %1 创建时尚未记录文件哈希，请先创建一份新的增量备份").arg(snapshotId);
+            }
+            return false;
+        }
+        manifest->add(fileObject.value("name").toString(),
+                      qint64(fileObject.value("size").toDouble()),
+                      fileObject.value("sha256").toString());
+    }
+    return true;
+}
+
+bool BackupStore::prune(int keepCount, int *removedSnapshots, qint64 *freedBytes, QString *errorMessage)
+{
+    if (removedSnapshots) {
+        *removedSnapshots = 0;
+    }
+    if (freedBytes) {
+        *freedBytes = 0;
+    }
+
+    const QList<Snapshot> all = snapshots();
+    for (int i = qMax(1, keepCount); i < all.size(); ++i) {
+        const QString path = snapshotPath(all.at(i).id);
+        if (!QFile::remove(path)) {
+            if (errorMessage) {
+                *errorMessage = QString("无法删除快照：%1").arg(QDir::toNativeSeparators(path));
+            }
+            return false;
+        }
+        if (removedSnapshots) {
+            ++(*removedSnapshots);
+        }
+    }
+
+    // 标记：剩余快照引用的全部分块；任何一份清单读不出来时不清理，避免误删
+    QSet<QString> referenced;
+    for (const QString &id : snapshotIds()) {
+        QJsonObject manifest;
+        if (!readSnapshot(id, &manifest, errorMessage)) {
+            return false;
+        }
+        for (const QJsonValue &value : snapshotFiles(manifest)) {
+            for (const QJsonValue &hashValue : value.toObject().value("chunks").toArray()) {
+                referenced.insert(hashValue.toString());
+            }
+        }
+    }
+
+    // 清除：未被引用的分块（包括写入中断留下的临时文件）
+    QDirIterator it(m_rootPath + "/" + kObjectsDirName, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        if (referenced.contains(it.fileName())) {
+            continue;
+        }
+        const qint64 size = it.fileInfo().size();
+        if (QFile::remove(it.filePath()) && freedBytes) {
+            *freedBytes += size;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef BACKUPSTORE_H
+#define BACKUPSTORE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+class ContentManifest;
+
+/**
+ * @brief 本地内容寻址增量备份库
+ * 文件按固定大小分块，每块以 SHA-256 命名存入 objects/，相同内容只存一份；
+ * 每次备份只写一份列出各文件分块哈希的快照清单（snapshots/<id>.json）。
+ * 文件大小和修改时间与上一份快照一致时直接沿用其分块列表、不读取内容，
+ * 因此数据未变化时一次备份只需遍历目录并写一个几 KB 的清单。
+ * 清单还记录每个文件整体的 SHA-256（读取分块时一并计算），可转换为 ContentManifest 检查当前数据。
+ * 不再被任何快照引用的分块由 prune() 清理。
+ */
+class BackupStore
+{
+public:
+    static const qint64 kChunkSize = 4 * 1024 * 1024;
+
+    // progress(已处理字节, 总字节)，在调用线程中回调；返回 false 取消
+    typedef std::function<bool(qint64, qint64)> Progress;
+
+    struct Snapshot {
+        QString id;
+        QDateTime created;
+        int fileCount = 0;
+        qint64 totalBytes = 0;
+    };
+
+    struct Stats {
+        int fileCount = 0;
+        int reusedFiles = 0;   // 沿用上一份快照、未读取内容的文件数
+        int storedChunks = 0;  // 本次新写入的分块数
+        qint64 totalBytes = 0;
+        qint64 storedBytes = 0;
+    };
+
+    explicit BackupStore(const QString &rootPath);
+
+    QString rootPath() const { return m_rootPath; }
+
+    // 待写入下一份快照的条目，name 为快照内路径，以 / 分隔
+    void addFile(const QString &name, const QString &sourcePath);
+    void addData(const QString &name, const QByteArray &data);
+
+    // 把已添加的条目写成一份新快照
+    bool commit(const Progress &progress, QString *snapshotId, Stats *stats, QString *errorMessage);
+
+    // 按创建时间从新到旧
+    QList<Snapshot> snapshots() const;
+
+    // 按快照内的目录结构还原到 targetDir，读取时逐块校验哈希
+    bool restore(const QString &snapshotId, const QString &targetDir, const Progress &progress, QString *errorMessage) const;
+
+    // 在线程池中并行重新计算快照引用的每个分块的哈希；problems 收集缺失或内容不符的文件
+    bool verify(const QString &snapshotId, const Progress &progress, QStringList *problems, QString *errorMessage) const;
+
+    // 快照中各文件的大小和 SHA-256；早于文件哈希记录的快照返回 false
+    bool contentManifest(const QString &snapshotId, ContentManifest *manifest, QString *errorMessage) const;
+
+    // 只保留最新的 keepCount 份快照，并删除不再被引用的分块
+    bool prune(int keepCount, int *removedSnapshots, qint64 *freedBytes, QString *errorMessage);
+
+private:
+    struct PendingEntry {
+        QString name;
+        QString sourcePath; // 为空时使用 data
+        QByteArray data;
+    };
+
+    QStringList snapshotIds() const;
+    QString objectPath(const QString &hash) const;
+    QString snapshotPath(const QString &id) const;
+    bool readSnapshot(const QString &id, QJsonObject *manifest, QString *errorMessage) const;
+    bool storeChunk(const QByteArray &chunk, QString *hash, bool *stored, QString *errorMessage);
+    bool readChunk(const QString &hash, QByteArray *chunk, QString *errorMessage) const;
+
+    QString m_rootPath;
+    QVector<PendingEntry> m_pending;
+};
+
+#endif // BACKUPSTORE_H
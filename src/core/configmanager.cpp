@@ -1,14 +1,19 @@
 #include "configmanager.h"
+#include "logger.h"
+#include "storagegenerations.h"
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QSaveFile>
 #include <QStandardPaths>
-#include <QTextStream>
+#include <QUuid>
 #include <QtConcurrent>
 
+// 增量日志超过该大小时在后台压缩回主快照
+static const qint64 kJournalCompactThreshold = 256 * 1024;
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -21,13 +26,16 @@ static bool copyDirectory(const QString &src, const QString &dst) {
     return false;
   QDir().mkpath(dst);
 
+  bool ok = true;
+
   // 处理文件
   for (const QString &fileName : srcDir.entryList(QDir::Files)) {
     QString srcPath = src + "/" + fileName;
     QString dstPath = dst + "/" + fileName;
     if (QFile::exists(dstPath))
       QFile::remove(dstPath);
-    QFile::copy(srcPath, dstPath);
+    if (!QFile::copy(srcPath, dstPath))
+      ok = false;
   }
 
   // 处理子目录
@@ -35,7 +43,21 @@ static bool copyDirectory(const QString &src, const QString &dst) {
        srcDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
     QString srcPath = src + "/" + dirName;
     QString dstPath = dst + "/" + dirName;
-    copyDirectory(srcPath, dstPath);
+    if (!copyDirectory(srcPath, dstPath))
+      ok = false;
+  }
+  return ok;
+}
+
+// 先复制到目标旁的暂存文件再改名，中途崩溃不会留下半个目标文件
+static bool copyFileAtomically(const QString &src, const QString &dst) {
+  const QString staging = dst + ".staging";
+  QFile::remove(staging);
+  if (!QFile::copy(src, staging))
+    return false;
+  if (!QFile::rename(staging, dst)) {
+    QFile::remove(staging);
+    return false;
   }
   return true;
 }
@@ -60,22 +82,6 @@ static bool isMsixPackage() {
   return false;
 }
 
-QMutex ConfigManager::s_logMutex;
-
-void ConfigManager::writeLog(const QString &msg) {
-  QMutexLocker locker(&s_logMutex);
-  QString appDataPath =
-      QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
-  QDir().mkpath(appDataPath);
-  QFile file(appDataPath + "/msix_debug.txt");
-  if (file.open(QIODevice::Append | QIODevice::Text)) {
-    QTextStream out(&file);
-    out << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz ")
-        << msg << "\n";
-    file.close();
-  }
-}
-
 const IID IID_IAsyncInfo = {0x00000036,
                             0x0000,
                             0x0000,
@@ -246,6 +252,10 @@ static IStartupTask_Raw *GetMsixStartupTask(const QString &taskIdToFind) {
 }
 #endif
 
+void ConfigManager::writeLog(const QString &msg) {
+  LOG_INFO(Logger::Config, msg);
+}
+
 ConfigManager *ConfigManager::instance() {
   static ConfigManager instance;
   return &instance;
@@ -273,14 +283,26 @@ ConfigManager::ConfigManager(QObject *parent)
 
   m_settingsPath = appDataPath + "/user_settings.ini";
   m_fencesPath = appDataPath + "/fencing_config.json";
-  m_fencesStoragePath = appDataPath + "/fences_storage";
+  QString storageError;
+  m_fencesStoragePath =
+      StorageGenerations::currentPath(appDataPath, &storageError);
+  if (m_fencesStoragePath.isEmpty()) {
+    // 指针损坏：使用最新一代，旧代目录保留（垃圾回收同样会跳过）
+    m_fencesStoragePath = StorageGenerations::latestPath(appDataPath);
+    ConfigManager::writeLog(storageError + ", using " + m_fencesStoragePath);
+  }
+  m_journal.setPath(appDataPath + "/fencing_config.journal");
+  m_iconCachePath = appDataPath + "/icon_cache.pack";
+  m_fileOperationsJournalPath = appDataPath + "/file_operations.journal";
+  m_backupStorePath = appDataPath + "/backup_store";
+  m_autoSnapshotPath = appDataPath + "/auto_snapshots";
 
   // 迁移逻辑：AppData 为空且程序目录有旧配置时执行
   if (!QFile::exists(m_settingsPath) && QFile::exists(oldSettings)) {
-    QFile::copy(oldSettings, m_settingsPath);
+    copyFileAtomically(oldSettings, m_settingsPath);
   }
   if (!QFile::exists(m_fencesPath) && QFile::exists(oldFences)) {
-    QFile::copy(oldFences, m_fencesPath);
+    copyFileAtomically(oldFences, m_fencesPath);
   }
 
   // 迁移 fences_storage 目录
@@ -293,13 +315,30 @@ ConfigManager::ConfigManager(QObject *parent)
       ConfigManager::writeLog(
           "Detected empty storage in AppData, starting migration from " +
           oldStorage);
-      copyDirectory(oldStorage, m_fencesStoragePath);
+      // 完整复制到暂存目录后再一次切换为新一代，中途失败或崩溃时当前存储目录不受影响，
+      // 下次启动重新迁移，残留的暂存目录由垃圾回收删除
+      QString error;
+      const QString staging =
+          StorageGenerations::createStaging(appDataPath, &error);
+      QString generation;
+      if (!staging.isEmpty() && copyDirectory(oldStorage, staging) &&
+          StorageGenerations::commit(appDataPath, staging, &generation,
+                                     &error)) {
+        m_fencesStoragePath = generation;
+      } else {
+        ConfigManager::writeLog("Storage migration failed: " +
+                                (error.isEmpty() ? "copy failed" : error));
+      }
     }
   }
 
   // 确保存储目录存在
   QDir().mkpath(m_fencesStoragePath);
 
+  // 删除被替换下来的旧代存储目录和中断留下的暂存目录
+  QtConcurrent::run(
+      [appDataPath]() { StorageGenerations::collectGarbage(appDataPath); });
+
   m_settings = new QSettings(m_settingsPath, QSettings::IniFormat, this);
 
   qDebug() << "[ConfigManager] Settings path:" << m_settingsPath;
@@ -394,6 +433,26 @@ void ConfigManager::setIconTextVisible(bool visible) {
   }
 }
 
+int ConfigManager::iconPixmapCacheKB() const {
+  QMutexLocker locker(&m_stateMutex);
+  return m_iconPixmapCacheKB;
+}
+
+int ConfigManager::iconVirtualizeThreshold() const {
+  QMutexLocker locker(&m_stateMutex);
+  return m_iconVirtualizeThreshold;
+}
+
+int ConfigManager::snapGridSize() const {
+  QMutexLocker locker(&m_stateMutex);
+  return m_snapGridSize;
+}
+
+int ConfigManager::autoSnapshotIntervalMinutes() const {
+  QMutexLocker locker(&m_stateMutex);
+  return m_autoSnapshotIntervalMinutes;
+}
+
 bool ConfigManager::layoutLocked() const {
   QMutexLocker locker(&m_stateMutex);
   return m_layoutLocked;
@@ -434,24 +493,33 @@ void ConfigManager::setWindowMaximized(bool maximized) {
   m_windowMaximized = maximized;
 }
 
+QString ConfigManager::fencesStoragePath() const {
+  QMutexLocker locker(&m_stateMutex);
+  return m_fencesStoragePath;
+}
+
+void ConfigManager::setFencesStoragePath(const QString &path) {
+  QMutexLocker locker(&m_stateMutex);
+  m_fencesStoragePath = path;
+}
+
 QJsonObject ConfigManager::fencesData() const {
   QMutexLocker locker(&m_stateMutex);
   return m_fencesData;
 }
 
-void ConfigManager::setFencesData(const QJsonObject &data) {
-  bool changed = false;
+void ConfigManager::setFencesData(
+    const QJsonObject &data, const QHash<QString, quint64> &fenceRevisions) {
+  // 调用方（FenceManager::saveFences）已按围栏版本号做过变化检测，
+  // 这里不再对整棵 JSON 树做深比较，只递增版本号
   {
     QMutexLocker locker(&m_stateMutex);
-    changed = (m_fencesData != data);
-    if (changed) {
-      m_fencesData = data;
-      m_fencesDirty = true;
-    }
-  }
-  if (changed) {
-    requestSave();
+    m_fencesData = data;
+    m_fenceRevisions = fenceRevisions;
+    m_fencesDirty = true;
+    ++m_fencesRevision;
   }
+  requestSave();
 }
 
 void ConfigManager::requestSave() {
@@ -492,7 +560,20 @@ bool ConfigManager::waitForIdleAndForceSync() {
   return forceSync();
 }
 
-bool ConfigManager::syncInternal(bool ignoreSaveDisabled) {
+bool ConfigManager::compact() {
+  return syncInternal(false, true);
+}
+
+void ConfigManager::scheduleCompaction() {
+  if (m_compactionPending.exchange(true))
+    return;
+  QtConcurrent::run([this]() {
+    this->compact();
+    m_compactionPending = false;
+  });
+}
+
+bool ConfigManager::syncInternal(bool ignoreSaveDisabled, bool compact) {
   QMutexLocker syncLocker(&m_syncMutex);
 
   QString settingsPath;
@@ -506,6 +587,8 @@ bool ConfigManager::syncInternal(bool ignoreSaveDisabled) {
   bool windowMaximized = false;
   QJsonObject fencesData;
   bool fencesDirty = false;
+  quint64 fencesRevision = 0;
+  QHash<QString, quint64> fenceRevisions;
 
   {
     QMutexLocker stateLocker(&m_stateMutex);
@@ -525,6 +608,8 @@ bool ConfigManager::syncInternal(bool ignoreSaveDisabled) {
     windowMaximized = m_windowMaximized;
     fencesData = m_fencesData;
     fencesDirty = m_fencesDirty;
+    fencesRevision = m_fencesRevision;
+    fenceRevisions = m_fenceRevisions;
   }
 
   QSettings localSettings(settingsPath, QSettings::IniFormat);
@@ -541,38 +626,94 @@ bool ConfigManager::syncInternal(bool ignoreSaveDisabled) {
     return false;
   }
 
-  if (fencesDirty) {
-    QSaveFile fencesFile(fencesPath);
-    if (fencesFile.open(QIODevice::WriteOnly)) {
-      QJsonDocument doc(fencesData);
-      QByteArray jsonData = doc.toJson(QJsonDocument::Indented);
-      if (fencesFile.write(jsonData) != jsonData.size()) {
-        qDebug()
-            << "[ConfigManager] Sync FATAL: short write when saving fences file";
-        fencesFile.cancelWriting();
-        return false;
+  if (fencesDirty || (compact && m_journalRecordCount > 0)) {
+    // 没有关联快照（首次保存）或显式压缩时写完整快照，其余情况只追加增量
+    bool writeSnapshot = compact || m_journalId.isEmpty();
+    QList<QJsonObject> records;
+    if (!writeSnapshot) {
+      // 版本号与上次写盘时相同的围栏内容必然相同，只对其余围栏做深比较
+      QSet<QString> unchangedIds;
+      for (auto it = fenceRevisions.constBegin(); it != fenceRevisions.constEnd();
+           ++it) {
+        const auto persisted = m_persistedFenceRevisions.constFind(it.key());
+        if (persisted != m_persistedFenceRevisions.constEnd() &&
+            persisted.value() == it.value()) {
+          unchangedIds.insert(it.key());
+        }
       }
-      if (!fencesFile.commit()) {
-        qDebug() << "[ConfigManager] Sync FATAL: failed to commit fences file";
-        return false;
+      if (!FenceJournal::diff(m_persistedFencesData, fencesData, &records,
+                              unchangedIds)) {
+        writeSnapshot = true;
       }
-      {
-        QMutexLocker stateLocker(&m_stateMutex);
-        if (m_fencesData == fencesData) {
-          m_fencesDirty = false;
-        }
+    }
+
+    if (!writeSnapshot && !records.isEmpty()) {
+      // 日志不存在或与快照不匹配时先重建日志头
+      if (!m_journalReady)
+        m_journalReady = m_journal.reset(m_journalId);
+      if (m_journalReady && m_journal.append(records)) {
+        m_journalRecordCount += records.size();
+      } else {
+        LOG_WARN(Logger::Config, "[ConfigManager] Journal append failed, "
+                                 "falling back to full snapshot");
+        writeSnapshot = true;
       }
-      qDebug() << "[ConfigManager] Sync success via QSaveFile";
-    } else {
-      qDebug()
-          << "[ConfigManager] Sync FATAL: failed to open fences file for writing";
+    }
+
+    if (writeSnapshot && !writeFencesSnapshot(fencesPath, fencesData))
       return false;
+
+    m_persistedFencesData = fencesData;
+    m_persistedFenceRevisions = fenceRevisions;
+    {
+      QMutexLocker stateLocker(&m_stateMutex);
+      if (m_fencesRevision == fencesRevision) {
+        m_fencesDirty = false;
+      }
     }
+
+    if (!writeSnapshot && m_journal.size() > kJournalCompactThreshold)
+      scheduleCompaction();
   }
 
   return true;
 }
 
+bool ConfigManager::writeFencesSnapshot(const QString &fencesPath,
+                                        const QJsonObject &fencesData) {
+  // 每个快照携带新的 journalId，旧日志随即失效；
+  // 即使在重建日志前崩溃，加载时也会因 id 不匹配而忽略旧日志
+  const QString journalId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+  QJsonObject snapshot = fencesData;
+  snapshot["journalId"] = journalId;
+
+  QSaveFile fencesFile(fencesPath);
+  if (!fencesFile.open(QIODevice::WriteOnly)) {
+    LOG_WARN(Logger::Config,
+             "[ConfigManager] Sync FATAL: failed to open fences file for writing");
+    return false;
+  }
+  QJsonDocument doc(snapshot);
+  QByteArray jsonData = doc.toJson(QJsonDocument::Indented);
+  if (fencesFile.write(jsonData) != jsonData.size()) {
+    LOG_WARN(Logger::Config,
+             "[ConfigManager] Sync FATAL: short write when saving fences file");
+    fencesFile.cancelWriting();
+    return false;
+  }
+  if (!fencesFile.commit()) {
+    LOG_WARN(Logger::Config,
+             "[ConfigManager] Sync FATAL: failed to commit fences file");
+    return false;
+  }
+
+  m_journalId = journalId;
+  m_journalRecordCount = 0;
+  m_journalReady = m_journal.reset(journalId);
+  LOG_INFO(Logger::Config, "[ConfigManager] Sync success via QSaveFile");
+  return true;
+}
+
 ConfigManager::LoadResult ConfigManager::tryLoadJson(const QString &path) {
   QFile file(path);
   if (!file.exists()) {
@@ -592,7 +733,7 @@ ConfigManager::LoadResult ConfigManager::tryLoadJson(const QString &path) {
     return LoadResult::ParseError;
   }
 
-  const QJsonObject object = doc.object();
+  QJsonObject object = doc.object();
 
   // 显式校验 fences 键存在且类型为数组；
   // QJsonValue::toArray() 在错误类型下会静默返回空数组，导致结构损坏的文件被当作 EmptyData
@@ -601,13 +742,107 @@ ConfigManager::LoadResult ConfigManager::tryLoadJson(const QString &path) {
     return LoadResult::ParseError;
   }
 
+  {
+    // journalId 只用于关联增量日志，不属于围栏数据本身
+    QMutexLocker syncLocker(&m_syncMutex);
+    const QString journalId = object.take("journalId").toString();
+    int appliedCount = 0;
+    const FenceJournal::ReplayResult replayResult =
+        m_journal.replay(journalId, &object, &appliedCount);
+
+    switch (replayResult) {
+    case FenceJournal::ReplayResult::Replayed:
+    case FenceJournal::ReplayResult::Recovered:
+      writeLog(QString("[load] Journal replayed: %1 records%2")
+                   .arg(appliedCount)
+                   .arg(replayResult == FenceJournal::ReplayResult::Recovered
+                            ? ", torn tail truncated"
+                            : ""));
+      break;
+    case FenceJournal::ReplayResult::Stale:
+      LOG_INFO(Logger::Config,
+               "[ConfigManager] Ignoring stale journal: " + m_journal.path());
+      break;
+    case FenceJournal::ReplayResult::IOError:
+      writeLog("[load] Failed to read journal: " + m_journal.path());
+      break;
+    case FenceJournal::ReplayResult::NoJournal:
+      break;
+    }
+
+    m_journalId = journalId;
+    m_journalReady = (replayResult == FenceJournal::ReplayResult::Replayed ||
+                      replayResult == FenceJournal::ReplayResult::Recovered);
+    m_journalRecordCount = appliedCount;
+    m_persistedFencesData = object;
+    m_persistedFenceRevisions.clear();
+  }
+
   {
     QMutexLocker locker(&m_stateMutex);
     m_fencesData = object;
   }
 
-  return fencesVal.toArray().isEmpty() ? LoadResult::EmptyData
-                                       : LoadResult::Success;
+  return object.value("fences").toArray().isEmpty() ? LoadResult::EmptyData
+                                                    : LoadResult::Success;
+}
+
+// 调用方须持有 m_stateMutex
+void ConfigManager::readSettings() {
+  m_autoStart = m_settings->value("General/AutoStart", false).toBool();
+  m_minimizeToTray =
+      m_settings->value("General/MinimizeToTray", true).toBool();
+  m_theme = m_settings->value("General/Theme", "dark").toString();
+  m_iconTextVisible =
+      m_settings->value("General/IconTextVisible", true).toBool();
+  m_iconPixmapCacheKB =
+      m_settings->value("Icons/PixmapCacheKB", 16 * 1024).toInt();
+  m_iconVirtualizeThreshold =
+      m_settings->value("Icons/VirtualizeThreshold", 400).toInt();
+  m_snapGridSize = m_settings->value("Snap/GridSize", 0).toInt();
+  m_autoSnapshotIntervalMinutes =
+      m_settings->value("Backup/AutoSnapshotMinutes", 60).toInt();
+  m_layoutLocked =
+      m_settings->value("General/LayoutLocked", false).toBool();
+  m_windowGeometry = m_settings->value("Window/Geometry", QRect()).toRect();
+  m_windowMaximized = m_settings->value("Window/Maximized", false).toBool();
+}
+
+void ConfigManager::reloadSettings() {
+  if (!m_settings)
+    return;
+
+  // QSettings::sync() 会重新读取在磁盘上被替换的文件
+  m_settings->sync();
+
+  QString oldTheme;
+  bool oldIconTextVisible = true;
+  bool oldLayoutLocked = false;
+  QString theme;
+  bool iconTextVisible = true;
+  bool layoutLocked = false;
+  {
+    QMutexLocker locker(&m_stateMutex);
+    oldTheme = m_theme;
+    oldIconTextVisible = m_iconTextVisible;
+    oldLayoutLocked = m_layoutLocked;
+
+    // 开机自启以本机注册表为准，不随备份还原
+    const bool autoStart = m_autoStart.load();
+    readSettings();
+    m_autoStart = autoStart;
+
+    theme = m_theme;
+    iconTextVisible = m_iconTextVisible;
+    layoutLocked = m_layoutLocked;
+  }
+
+  if (theme != oldTheme)
+    emit themeChanged(theme);
+  if (iconTextVisible != oldIconTextVisible)
+    emit iconTextVisibleChanged(iconTextVisible);
+  if (layoutLocked != oldLayoutLocked)
+    emit layoutLockedChanged(layoutLocked);
 }
 
 void ConfigManager::load() {
@@ -616,16 +851,7 @@ void ConfigManager::load() {
 
   {
     QMutexLocker locker(&m_stateMutex);
-    m_autoStart = m_settings->value("General/AutoStart", false).toBool();
-    m_minimizeToTray =
-        m_settings->value("General/MinimizeToTray", true).toBool();
-    m_theme = m_settings->value("General/Theme", "dark").toString();
-    m_iconTextVisible =
-        m_settings->value("General/IconTextVisible", true).toBool();
-    m_layoutLocked =
-        m_settings->value("General/LayoutLocked", false).toBool();
-    m_windowGeometry = m_settings->value("Window/Geometry", QRect()).toRect();
-    m_windowMaximized = m_settings->value("Window/Maximized", false).toBool();
+    readSettings();
     m_fencesData = QJsonObject();
     m_lastLoadResult = LoadResult::NotExist;
   }
@@ -1,6 +1,8 @@
 #ifndef CONFIGMANAGER_H
 #define CONFIGMANAGER_H
 
+#include "fencejournal.h"
+#include <QHash>
 #include <QJsonObject>
 #include <QMutex>
 #include <QMutexLocker>
@@ -43,6 +45,17 @@ public:
   bool iconTextVisible() const;
   void setIconTextVisible(bool visible);
 
+  // 缩放图标共享缓存的内存预算（KB，仅从配置文件 Icons/PixmapCacheKB 读取）
+  int iconPixmapCacheKB() const;
+  // 围栏图标数达到该值时改用单控件虚拟化网格（仅从配置文件 Icons/VirtualizeThreshold 读取）
+  int iconVirtualizeThreshold() const;
+
+  // 拖动/调整围栏时吸附的网格间距（像素，仅从配置文件 Snap/GridSize 读取，<= 0 关闭）
+  int snapGridSize() const;
+
+  // 自动快照的间隔（分钟，仅从配置文件 Backup/AutoSnapshotMinutes 读取，<= 0 关闭）
+  int autoSnapshotIntervalMinutes() const;
+
   // 布局锁定
   bool layoutLocked() const;
   void setLayoutLocked(bool locked);
@@ -56,10 +69,30 @@ public:
 
   // 围栏数据
   QJsonObject fencesData() const;
-  void setFencesData(const QJsonObject &data);
+  // fenceRevisions 为各围栏（按 id）的序列化版本号，写日志时据此跳过未变化的围栏；
+  // 不提供时（如还原备份）对全部围栏做深比较
+  void setFencesData(const QJsonObject &data,
+                     const QHash<QString, quint64> &fenceRevisions = {});
+
+  // 存储路径：当前代的 fences_storage 目录，与配置文件在同目录下（见 StorageGenerations）
+  QString fencesStoragePath() const;
+  // 切换到新一代存储目录后调用（在线还原备份）
+  void setFencesStoragePath(const QString &path);
+
+  // 围栏增量日志路径（与 fencing_config.json 同目录）
+  QString fencesJournalPath() const { return m_journal.path(); }
+
+  // 图标缓存包路径（与 fences_storage 同目录）
+  QString iconCachePath() const { return m_iconCachePath; }
 
-  // 存储路径：fences_storage 与配置文件在同目录下
-  QString fencesStoragePath() const { return m_fencesStoragePath; }
+  // 图标文件移动日志路径（与 fences_storage 同目录）
+  QString fileOperationsJournalPath() const { return m_fileOperationsJournalPath; }
+
+  // 增量备份库目录（与 fences_storage 同目录）
+  QString backupStorePath() const { return m_backupStorePath; }
+
+  // 自动快照目录（与 fences_storage 同目录，硬链接要求同一卷）
+  QString autoSnapshotPath() const { return m_autoSnapshotPath; }
 
   // 真正的保存（防抖调用此方法）
   void doSave();
@@ -69,13 +102,16 @@ public:
   bool forceSync();
   bool waitForIdleAndForceSync();
 
+  // 将增量日志合并回 fencing_config.json 主快照（备份前调用，保证快照完整）
+  bool compact();
+
   // 阻止任何未完成或将来的写盘操作，丢弃所有更改（restore 专用）
   void stopSave();
 
   // 恢复被 stopSave() 禁止的写盘能力（restore 失败时调用）
   void resumeSave();
 
-  // 日志记录
+  // 日志记录（Info 级别，Config 分类；热路径请使用 logger.h 中的 LOG_* 宏）
   static void writeLog(const QString &msg);
 
   // 加载/请求防抖保存
@@ -83,6 +119,9 @@ public:
   void load();
   LoadResult lastLoadResult() const;
 
+  // user_settings.ini 被外部替换后（在线还原备份）重新读取，有变化的设置照常发出通知
+  void reloadSettings();
+
 signals:
   void autoStartChanged(bool enabled);
   void themeChanged(const QString &theme);
@@ -96,26 +135,49 @@ private:
 
   bool updateAutoStartRegistry(bool enabled);
   LoadResult tryLoadJson(const QString &path);
-  bool syncInternal(bool ignoreSaveDisabled);
+  void readSettings();
+  bool syncInternal(bool ignoreSaveDisabled, bool compact = false);
+  bool writeFencesSnapshot(const QString &fencesPath,
+                           const QJsonObject &fencesData);
+  void scheduleCompaction();
 
   QSettings *m_settings;
   QTimer *m_saveDebounceTimer;
   QString m_settingsPath;
   QString m_fencesPath;
   QString m_fencesStoragePath;
+  QString m_iconCachePath;
+  QString m_fileOperationsJournalPath;
+  QString m_backupStorePath;
+  QString m_autoSnapshotPath;
 
   bool m_saveDisabled = false;
   std::atomic<bool> m_autoStart{false};
   bool m_minimizeToTray = true;
   QString m_theme = "dark";
   bool m_iconTextVisible = true;
+  int m_iconPixmapCacheKB = 16 * 1024;
+  int m_iconVirtualizeThreshold = 400;
+  int m_snapGridSize = 0;
+  int m_autoSnapshotIntervalMinutes = 60;
   bool m_layoutLocked = false;
   QRect m_windowGeometry;
   bool m_windowMaximized = false;
   QJsonObject m_fencesData;
   bool m_fencesDirty = false;
+  quint64 m_fencesRevision = 0; // 每次 setFencesData 递增，用于 O(1) 判断写盘期间是否有新改动
+  QHash<QString, quint64> m_fenceRevisions; // m_fencesData 中各围栏的序列化版本号
   LoadResult m_lastLoadResult = LoadResult::NotExist;
-  static QMutex s_logMutex;
+
+  // 以下日志状态均受 m_syncMutex 保护
+  FenceJournal m_journal;
+  QString m_journalId;
+  bool m_journalReady = false;
+  int m_journalRecordCount = 0;
+  QJsonObject m_persistedFencesData; // 主快照 + 日志对应的磁盘状态
+  QHash<QString, quint64> m_persistedFenceRevisions; // 上述状态中各围栏的序列化版本号
+  std::atomic<bool> m_compactionPending{false};
+
   mutable QMutex m_stateMutex;
   QMutex m_syncMutex;
 };
@@ -0,0 +1,269 @@
+#include "contentmanifest.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <atomic>
+
+const char *const ContentManifest::kFileName = "content_manifest.json";
+
+namespace {
+
+const int kManifestVersion = 1;
+const qint64 kReadChunkSize = 1024 * 1024;
+
+struct FileCheck {
+    bool exists = false;
+    qint64 size = 0;
+    QString sha256;  // 读取失败或取消时为空
+};
+
+// 各工作线程共享的进度：由读取文件的线程直接回调，每累计约千分之一的总字节（进度对话框的精度）回调一次；
+// 回调返回 false 时置取消标志，其余线程读完当前块即返回
+struct SharedProgress {
+    const ContentManifest::Progress *callback = nullptr;
+    qint64 total = 0;
+    qint64 step = 1;
+    std::atomic<qint64> processed{0};
+    std::atomic<qint64> nextReport{0};
+    std::atomic<bool> cancelled{false};
+
+    void add(qint64 bytes)
+    {
+        const qint64 done = processed += bytes;
+        qint64 next = nextReport.load();
+        // 同一档只由一个线程回调
+        if (done < next || !nextReport.compare_exchange_strong(next, done + step)) {
+            return;
+        }
+        if (callback && *callback && !(*callback)(done, total)) {
+            cancelled = true;
+        }
+    }
+};
+
+// 工作线程：分块读取并计算哈希，progress 为空时只计算哈希
+FileCheck checkFile(const QString &path, SharedProgress *progress)
+{
+    FileCheck check;
+    QFile file(path);
+    if (!file.exists()) {
+        return check;
+    }
+    check.exists = true;
+    if ((progress && progress->cancelled) || !file.open(QIODevice::ReadOnly)) {
+        return check;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    while (!(progress && progress->cancelled)) {
+        const QByteArray chunk = file.read(kReadChunkSize);
+        if (chunk.isEmpty()) {
+            break;
+        }
+        hash.addData(chunk);
+        check.size += chunk.size();
+        if (progress) {
+            progress->add(chunk.size());
+        }
+    }
+    if (file.error() == QFileDevice::NoError && file.atEnd()) {
+        check.sha256 = QString::fromLatin1(hash.result().toHex());
+    }
+    return check;
+}
+
+// 清单内路径必须是相对路径且不能跳出检查目录
+bool isSafeEntryName(const QString &name)
+{
+    const QString cleaned = QDir::cleanPath(name);
+    return !cleaned.isEmpty() && !QDir::isAbsolutePath(cleaned)
+        && cleaned != ".." && !cleaned.startsWith("../") && !cleaned.contains(':');
+}
+
+} // namespace
+
+double ContentManifest::Report::megabytesPerSecond() const
+{
+    return elapsedMs > 0 ? totalBytes / (1024.0 * 1024.0) / (elapsedMs / 1000.0) : 0.0;
+}
+
+void ContentManifest::add(const QString &name, qint64 size, const QString &sha256)
+{
+    Entry entry;
+    entry.name = name;
+    entry.size = size;
+    entry.sha256 = sha256;
+    m_entries.append(entry);
+}
+
+QByteArray ContentManifest::toJson() const
+{
+    QJsonArray files;
+    for (const Entry &entry : m_entries) {
+        QJsonObject fileObject;
+        fileObject["name"] = entry.name;
+        fileObject["size"] = double(entry.size);
+        fileObject["sha256"] = entry.sha256;
+        files.append(fileObject);
+    }
+
+    QJsonObject root;
+    root["version"] = kManifestVersion;
+    root["algorithm"] = "sha256";
+    root["files"] = files;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool ContentManifest::fromJson(const QByteArray &json, ContentManifest *manifest, QString *errorMessage)
+{
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    const QJsonObject root = document.object();
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()
+        || root.value("version").toInt() != kManifestVersion || root.value("algorithm").toString() != "sha256") {
+        if (errorMessage) {
+            *errorMessage = "内容清单已损坏或版本不受支持";
+        }
+        return false;
+    }
+
+    manifest->m_entries.clear();
+    for (const QJsonValue &value : root.value("files").toArray()) {
+        const QJsonObject fileObject = value.toObject();
+        manifest->add(fileObject.value("name").toString(),
+                      qint64(fileObject.value("size").toDouble()),
+                      fileObject.value("sha256").toString());
+    }
+    return true;
+}
+
+bool ContentManifest::load(const QString &path, ContentManifest *manifest, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法读取文件：%1").arg(QDir::toNativeSeparators(path));
+        }
+        return false;
+    }
+    return fromJson(file.readAll(), manifest, errorMessage);
+}
+
+QString ContentManifest::hashData(const QByteArray &data)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+}
+
+QString ContentManifest::hashFile(const QString &path, qint64 *size, QString *errorMessage)
+{
+    const FileCheck check = checkFile(path, nullptr);
+    if (check.sha256.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = QString("无法读取文件：%1").arg(QDir::toNativeSeparators(path));
+        }
+        return QString();
+    }
+    if (size) {
+        *size = check.size;
+    }
+    return check.sha256;
+}
+
+bool ContentManifest::verify(const QString &rootDir, const QString &prefix, const Progress &progress,
+                             Report *report, QString *errorMessage) const
+{
+    const QString namePrefix = prefix.isEmpty() ? QString() : prefix + "/";
+    QVector<Entry> selected;
+    QSet<QString> expectedNames; // 去掉前缀后的小写路径
+    qint64 totalBytes = 0;
+    for (const Entry &entry : m_entries) {
+        if (!entry.name.startsWith(namePrefix)) {
+            continue;
+        }
+        Entry relative = entry;
+        relative.name = entry.name.mid(namePrefix.size());
+        if (!isSafeEntryName(relative.name)) {
+            if (errorMessage) {
+                *errorMessage = QString("内容清单中包含非法路径：%1").arg(entry.name);
+            }
+            return false;
+        }
+        expectedNames.insert(QDir::cleanPath(relative.name).toLower());
+        totalBytes += entry.size;
+        selected.append(relative);
+    }
+
+    SharedProgress shared;
+    shared.callback = &progress;
+    shared.total = totalBytes;
+    shared.step = qMax<qint64>(1, totalBytes / 1000);
+
+    // 每个文件一个任务，在专用线程池中并行读取和计算哈希；计时只包括这一段
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    QVector<QFuture<FileCheck>> futures;
+    futures.reserve(selected.size());
+    for (const Entry &entry : qAsConst(selected)) {
+        futures.append(QtConcurrent::run(&pool, checkFile, QDir::cleanPath(rootDir + "/" + entry.name), &shared));
+    }
+    pool.waitForDone();
+    const qint64 elapsedMs = elapsed.elapsed();
+
+    if (shared.cancelled) {
+        if (errorMessage) {
+            *errorMessage = "已取消";
+        }
+        return false;
+    }
+    if (progress) {
+        progress(totalBytes, totalBytes);
+    }
+
+    Report result;
+    for (int i = 0; i < selected.size(); ++i) {
+        const Entry &entry = selected.at(i);
+        const FileCheck check = futures.at(i).result();
+        if (!check.exists) {
+            result.missing.append(namePrefix + entry.name);
+            continue;
+        }
+        ++result.fileCount;
+        result.totalBytes += check.size;
+        if (check.size != entry.size || check.sha256.compare(entry.sha256, Qt::CaseInsensitive) != 0) {
+            result.mismatched.append(namePrefix + entry.name);
+        }
+    }
+
+    // 清单之外的文件（检查整个备份时清单文件本身除外）
+    const QDir root(rootDir);
+    QDirIterator it(rootDir, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QString relativeName = QDir::cleanPath(root.relativeFilePath(it.filePath()));
+        if (prefix.isEmpty() && relativeName == kFileName) {
+            continue;
+        }
+        if (!expectedNames.contains(relativeName.toLower())) {
+            result.unexpected.append(namePrefix + relativeName);
+        }
+    }
+
+    result.elapsedMs = elapsedMs;
+    if (report) {
+        *report = result;
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef CONTENTMANIFEST_H
+#define CONTENTMANIFEST_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief 备份内容清单
+ * 记录每个文件的大小和 SHA-256。.zip 备份写入时由 ZipWriter 在压缩线程中顺带计算，
+ * 作为 content_manifest.json 存入归档；增量快照清单中的 sha256 字段也可转换为本清单。
+ * verify() 在线程池中并行重新计算哈希，检查解压后的备份或当前的图标存储目录。
+ */
+class ContentManifest
+{
+public:
+    static const char *const kFileName;
+
+    // progress(已处理字节, 总字节)；返回 false 取消
+    typedef std::function<bool(qint64, qint64)> Progress;
+
+    struct Entry {
+        QString name;     // 清单内路径，以 / 分隔
+        qint64 size = 0;
+        QString sha256;   // 十六进制小写
+    };
+
+    struct Report {
+        int fileCount = 0;
+        qint64 totalBytes = 0;
+        qint64 elapsedMs = 0;
+        QStringList mismatched;  // 大小或内容与清单不符
+        QStringList missing;     // 清单中有、磁盘上没有
+        QStringList unexpected;  // 磁盘上有、清单中没有
+
+        bool isClean() const { return mismatched.isEmpty() && missing.isEmpty() && unexpected.isEmpty(); }
+        double megabytesPerSecond() const;
+    };
+
+    void add(const QString &name, qint64 size, const QString &sha256);
+    const QVector<Entry> &entries() const { return m_entries; }
+    bool isEmpty() const { return m_entries.isEmpty(); }
+
+    QByteArray toJson() const;
+    static bool fromJson(const QByteArray &json, ContentManifest *manifest, QString *errorMessage);
+    static bool load(const QString &path, ContentManifest *manifest, QString *errorMessage);
+
+    // 按清单检查 rootDir 下的文件。prefix 非空时只检查名称以 prefix/ 开头的条目，
+    // 对应的文件位于 rootDir 下去掉该前缀的位置（用于直接检查图标存储目录）。
+    // progress 由读取文件的工作线程直接回调，须线程安全；elapsedMs 只计读取和计算哈希的时间
+    bool verify(const QString &rootDir, const QString &prefix, const Progress &progress,
+                Report *report, QString *errorMessage) const;
+
+    static QString hashData(const QByteArray &data);
+    // 分块读取计算，内存占用与文件大小无关；失败时返回空串
+    static QString hashFile(const QString &path, qint64 *size, QString *errorMessage);
+
+private:
+    QVector<Entry> m_entries;
+};
+
+#endif // CONTENTMANIFEST_H
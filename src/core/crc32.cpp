@@ -0,0 +1,33 @@
+#include "crc32.h"
+
+namespace {
+
+struct Table {
+    quint32 entries[256];
+
+    Table()
+    {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+} // namespace
+
+quint32 Crc32::update(quint32 crc, const char *data, qint64 size)
+{
+    // 局部静态对象的初始化是线程安全的，备份时多个工作线程会同时调用
+    static const Table table;
+
+    crc ^= 0xFFFFFFFFu;
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
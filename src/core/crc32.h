@@ -0,0 +1,22 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+/**
+ * @brief CRC-32（IEEE 802.3，与 zlib / ZIP 相同的多项式）
+ * 增量计算：crc 从 0 开始，依次传入每段数据的返回值即可。
+ */
+namespace Crc32 {
+
+quint32 update(quint32 crc, const char *data, qint64 size);
+
+inline quint32 compute(const QByteArray &data)
+{
+    return update(0, data.constData(), data.size());
+}
+
+} // namespace Crc32
+
+#endif // CRC32_H
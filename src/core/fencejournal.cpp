@@ -0,0 +1,577 @@
+#include "fencejournal.h"
+#include "crc32.h"
+#include "logger.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+#include <QStringList>
+#include <QtEndian>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int kFrameHeaderSize = 8;
+const quint32 kMaxRecordSize = 16 * 1024 * 1024;
+const int kJournalVersion = 1;
+
+// 单个围栏的图标增量超过该比例时改为整体替换，避免日志比快照还大
+const int kMinIconOpsBeforeReset = 8;
+
+QByteArray encodeFrame(const QJsonObject &record)
+{
+    const QByteArray payload = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    QByteArray frame;
+    frame.resize(kFrameHeaderSize);
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), frame.data());
+    qToLittleEndian<quint32>(Crc32::compute(payload), frame.data() + 4);
+    frame.append(payload);
+    return frame;
+}
+
+// 从 offset 处解析一条记录；数据不完整或校验失败时返回 false 且不移动 offset
+bool decodeFrame(const QByteArray &bytes, qint64 *offset, QJsonObject *record)
+{
+    const qint64 remaining = bytes.size() - *offset;
+    if (remaining < kFrameHeaderSize) {
+        return false;
+    }
+
+    const char *base = bytes.constData() + *offset;
+    const quint32 length = qFromLittleEndian<quint32>(base);
+    const quint32 checksum = qFromLittleEndian<quint32>(base + 4);
+    if (length == 0 || length > kMaxRecordSize || length > remaining - kFrameHeaderSize) {
+        return false;
+    }
+
+    const QByteArray payload = QByteArray::fromRawData(base + kFrameHeaderSize, static_cast<int>(length));
+    if (Crc32::compute(payload) != checksum) {
+        return false;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    *record = doc.object();
+    *offset += kFrameHeaderSize + length;
+    return true;
+}
+
+// QFile::flush 只刷新 Qt 缓冲区，这里再把数据刷到磁盘，保证记录在返回前已持久化
+bool syncToDisk(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()));
+    return handle != INVALID_HANDLE_VALUE && FlushFileBuffers(handle);
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+int indexOfFence(const QJsonArray &fences, const QString &id)
+{
+    for (int i = 0; i < fences.size(); ++i) {
+        if (fences.at(i).toObject().value("id").toString() == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QString iconKey(const QJsonValue &icon)
+{
+    return icon.toObject().value("path").toString();
+}
+
+QJsonObject makeRecord(const QString &op, const QString &fenceId)
+{
+    QJsonObject record;
+    record["op"] = op;
+    if (!fenceId.isEmpty()) {
+        record["id"] = fenceId;
+    }
+    return record;
+}
+
+void diffFenceProperties(const QString &fenceId, const QJsonObject &oldFence, const QJsonObject &newFence,
+                         QList<QJsonObject> *records)
+{
+    QJsonObject props;
+    QJsonArray unset;
+
+    for (auto it = newFence.constBegin(); it != newFence.constEnd(); ++it) {
+        if (it.key() == "icons") {
+            continue;
+        }
+        if (oldFence.value(it.key()) != it.value()) {
+            props.insert(it.key(), it.value());
+        }
+    }
+    for (auto it = oldFence.constBegin(); it != oldFence.constEnd(); ++it) {
+        if (it.key() != "icons" && !newFence.contains(it.key())) {
+            unset.append(it.key());
+        }
+    }
+
+    if (props.isEmpty() && unset.isEmpty()) {
+        return;
+    }
+
+    QJsonObject record = makeRecord("fence.set", fenceId);
+    if (!props.isEmpty()) {
+        record["props"] = props;
+    }
+    if (!unset.isEmpty()) {
+        record["unset"] = unset;
+    }
+    records->append(record);
+}
+
+void diffFenceIcons(const QString &fenceId, const QJsonArray &oldIcons, const QJsonArray &newIcons,
+                    QList<QJsonObject> *records)
+{
+    if (oldIcons == newIcons) {
+        return;
+    }
+
+    QJsonObject resetRecord = makeRecord("icons.reset", fenceId);
+    resetRecord["icons"] = newIcons;
+
+    // 以 path 作为图标身份；出现重复 path 时无法可靠定位，直接整体替换
+    QSet<QString> newKeys;
+    for (const QJsonValue &icon : newIcons) {
+        const QString key = iconKey(icon);
+        if (key.isEmpty() || newKeys.contains(key)) {
+            records->append(resetRecord);
+            return;
+        }
+        newKeys.insert(key);
+    }
+
+    QStringList working;
+    QSet<QString> oldKeys;
+    for (const QJsonValue &icon : oldIcons) {
+        const QString key = iconKey(icon);
+        if (key.isEmpty() || oldKeys.contains(key)) {
+            records->append(resetRecord);
+            return;
+        }
+        oldKeys.insert(key);
+        working.append(key);
+    }
+
+    QList<QJsonObject> ops;
+    QJsonArray current = oldIcons;
+
+    // 1. 先删除已不存在的图标（倒序，保证索引稳定）
+    for (int i = working.size() - 1; i >= 0; --i) {
+        if (!newKeys.contains(working.at(i))) {
+            QJsonObject record = makeRecord("icon.remove", fenceId);
+            record["index"] = i;
+            ops.append(record);
+            working.removeAt(i);
+            current.removeAt(i);
+        }
+    }
+
+    // 2. 按目标顺序逐位放置：插入新图标、移动已有图标、更新发生变化的图标
+    for (int j = 0; j < newIcons.size(); ++j) {
+        const QJsonObject target = newIcons.at(j).toObject();
+        const QString key = target.value("path").toString();
+        const int k = working.indexOf(key, j);
+
+        if (k < 0) {
+            QJsonObject record = makeRecord("icon.insert", fenceId);
+            record["index"] = j;
+            record["icon"] = target;
+            ops.append(record);
+            working.insert(j, key);
+            current.insert(j, target);
+            continue;
+        }
+
+        if (k != j) {
+            QJsonObject record = makeRecord("icon.move", fenceId);
+            record["from"] = k;
+            record["to"] = j;
+            ops.append(record);
+            working.move(k, j);
+            current.insert(j, current.takeAt(k));
+        }
+
+        if (current.at(j).toObject() != target) {
+            QJsonObject record = makeRecord("icon.set", fenceId);
+            record["index"] = j;
+            record["icon"] = target;
+            ops.append(record);
+            current.replace(j, target);
+        }
+    }
+
+    if (ops.size() > qMax(kMinIconOpsBeforeReset, newIcons.size() / 2)) {
+        records->append(resetRecord);
+    } else {
+        records->append(ops);
+    }
+}
+
+} // namespace
+
+FenceJournal::FenceJournal(const QString &path)
+    : m_path(path)
+{
+}
+
+qint64 FenceJournal::size() const
+{
+    const QFileInfo info(m_path);
+    return info.exists() ? info.size() : 0;
+}
+
+bool FenceJournal::reset(const QString &journalId)
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        LOG_WARN(Logger::Config, "[FenceJournal] reset: failed to open " + m_path);
+        return false;
+    }
+
+    QJsonObject header = makeRecord("header", QString());
+    header["journalId"] = journalId;
+    header["version"] = kJournalVersion;
+
+    const QByteArray frame = encodeFrame(header);
+    if (file.write(frame) != frame.size() || !syncToDisk(file)) {
+        LOG_WARN(Logger::Config, "[FenceJournal] reset: failed to write header to " + m_path);
+        file.close();
+        QFile::remove(m_path);
+        return false;
+    }
+    return true;
+}
+
+bool FenceJournal::append(const QList<QJsonObject> &records)
+{
+    if (records.isEmpty()) {
+        return true;
+    }
+
+    QFile file(m_path);
+    if (!file.exists() || !file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+
+    // 一批记录合并为一次写入，尽量减少系统调用和刷盘次数
+    QByteArray buffer;
+    for (const QJsonObject &record : records) {
+        buffer.append(encodeFrame(record));
+    }
+
+    const qint64 startSize = file.size();
+    if (file.write(buffer) != buffer.size() || !syncToDisk(file)) {
+        LOG_WARN(Logger::Config, "[FenceJournal] append: short write, rolling back to " +
+                                     QString::number(startSize));
+        file.resize(startSize);
+        return false;
+    }
+    return true;
+}
+
+FenceJournal::ReplayResult FenceJournal::replay(const QString &journalId, QJsonObject *fencesData,
+                                                int *appliedCount)
+{
+    if (appliedCount) {
+        *appliedCount = 0;
+    }
+
+    QFile file(m_path);
+    if (!file.exists()) {
+        return ReplayResult::NoJournal;
+    }
+    if (!file.open(QIODevice::ReadWrite)) {
+        return ReplayResult::IOError;
+    }
+
+    const QByteArray bytes = file.readAll();
+    qint64 offset = 0;
+
+    QJsonObject header;
+    if (journalId.isEmpty() || !decodeFrame(bytes, &offset, &header) ||
+        header.value("op").toString() != "header" ||
+        header.value("journalId").toString() != journalId) {
+        return ReplayResult::Stale;
+    }
+
+    QJsonObject working = *fencesData;
+    qint64 lastGoodOffset = offset;
+    int applied = 0;
+
+    while (offset < bytes.size()) {
+        QJsonObject record;
+        if (!decodeFrame(bytes, &offset, &record)) {
+            break;
+        }
+        if (!apply(record, &working)) {
+            LOG_WARN(Logger::Config, "[FenceJournal] replay: record does not match snapshot, stopping at " +
+                                     record.value("op").toString());
+            break;
+        }
+        lastGoodOffset = offset;
+        ++applied;
+    }
+
+    *fencesData = working;
+    if (appliedCount) {
+        *appliedCount = applied;
+    }
+
+    if (lastGoodOffset < bytes.size()) {
+        // 尾部记录残缺（写入过程中断电/崩溃），截断到最后一条完整记录
+        LOG_WARN(Logger::Config, QString("[FenceJournal] Torn tail detected, truncating %1 -> %2 bytes")
+                                     .arg(bytes.size())
+                                     .arg(lastGoodOffset));
+        if (!file.resize(lastGoodOffset)) {
+            return ReplayResult::IOError;
+        }
+        return ReplayResult::Recovered;
+    }
+    return ReplayResult::Replayed;
+}
+
+FenceJournal::ReplayResult FenceJournal::read(const QString &journalId, QList<QJsonObject> *records)
+{
+    records->clear();
+
+    QFile file(m_path);
+    if (!file.exists()) {
+        return ReplayResult::NoJournal;
+    }
+    if (!file.open(QIODevice::ReadWrite)) {
+        return ReplayResult::IOError;
+    }
+
+    const QByteArray bytes = file.readAll();
+    qint64 offset = 0;
+
+    QJsonObject header;
+    if (journalId.isEmpty() || !decodeFrame(bytes, &offset, &header) ||
+        header.value("op").toString() != "header" ||
+        header.value("journalId").toString() != journalId) {
+        return ReplayResult::Stale;
+    }
+
+    QJsonObject record;
+    while (decodeFrame(bytes, &offset, &record)) {
+        records->append(record);
+    }
+
+    if (offset < bytes.size()) {
+        LOG_WARN(Logger::Config, QString("[FenceJournal] Torn tail detected in %1, truncating %2 -> %3 bytes")
+                                     .arg(m_path)
+                                     .arg(bytes.size())
+                                     .arg(offset));
+        if (!file.resize(offset)) {
+            return ReplayResult::IOError;
+        }
+        return ReplayResult::Recovered;
+    }
+    return ReplayResult::Replayed;
+}
+
+bool FenceJournal::remove()
+{
+    return !QFile::exists(m_path) || QFile::remove(m_path);
+}
+
+bool FenceJournal::diff(const QJsonObject &oldData, const QJsonObject &newData, QList<QJsonObject> *records,
+                        const QSet<QString> &unchangedIds)
+{
+    // 目前只为 fences 数组生成增量，其他顶层键变化时改写完整快照
+    for (auto it = newData.constBegin(); it != newData.constEnd(); ++it) {
+        if (it.key() != "fences" && oldData.value(it.key()) != it.value()) {
+            return false;
+        }
+    }
+    for (auto it = oldData.constBegin(); it != oldData.constEnd(); ++it) {
+        if (it.key() != "fences" && !newData.contains(it.key())) {
+            return false;
+        }
+    }
+
+    const QJsonArray oldFences = oldData.value("fences").toArray();
+    const QJsonArray newFences = newData.value("fences").toArray();
+
+    QHash<QString, int> oldIndex;
+    for (int i = 0; i < oldFences.size(); ++i) {
+        const QString id = oldFences.at(i).toObject().value("id").toString();
+        if (id.isEmpty() || oldIndex.contains(id)) {
+            return false;
+        }
+        oldIndex.insert(id, i);
+    }
+
+    QStringList newOrder;
+    QSet<QString> newIds;
+    for (const QJsonValue &value : newFences) {
+        const QString id = value.toObject().value("id").toString();
+        if (id.isEmpty() || newIds.contains(id)) {
+            return false;
+        }
+        newIds.insert(id);
+        newOrder.append(id);
+    }
+
+    QStringList working;
+    for (const QJsonValue &value : oldFences) {
+        const QString id = value.toObject().value("id").toString();
+        if (!newIds.contains(id)) {
+            records->append(makeRecord("fence.remove", id));
+        } else {
+            working.append(id);
+        }
+    }
+
+    for (const QJsonValue &value : newFences) {
+        const QJsonObject newFence = value.toObject();
+        const QString id = newFence.value("id").toString();
+        const auto oldIt = oldIndex.constFind(id);
+
+        if (oldIt == oldIndex.constEnd()) {
+            QJsonObject record = makeRecord("fence.put", id);
+            record["fence"] = newFence;
+            records->append(record);
+            working.append(id);
+            continue;
+        }
+
+        if (unchangedIds.contains(id)) {
+            continue;
+        }
+        const QJsonObject oldFence = oldFences.at(oldIt.value()).toObject();
+        if (oldFence == newFence) {
+            continue;
+        }
+        diffFenceProperties(id, oldFence, newFence, records);
+        diffFenceIcons(id, oldFence.value("icons").toArray(), newFence.value("icons").toArray(), records);
+    }
+
+    if (working != newOrder) {
+        QJsonObject record = makeRecord("fence.order", QString());
+        record["ids"] = QJsonArray::fromStringList(newOrder);
+        records->append(record);
+    }
+    return true;
+}
+
+bool FenceJournal::apply(const QJsonObject &record, QJsonObject *fencesData)
+{
+    const QString op = record.value("op").toString();
+    const QString id = record.value("id").toString();
+    QJsonArray fences = fencesData->value("fences").toArray();
+
+    if (op == "fence.order") {
+        const QJsonArray ids = record.value("ids").toArray();
+        QJsonArray ordered;
+        for (const QJsonValue &value : ids) {
+            const int index = indexOfFence(fences, value.toString());
+            if (index < 0) {
+                return false;
+            }
+            ordered.append(fences.takeAt(index));
+        }
+        // 未在排序列表中出现的围栏保持原有相对顺序追加在末尾
+        for (const QJsonValue &value : fences) {
+            ordered.append(value);
+        }
+        fencesData->insert("fences", ordered);
+        return true;
+    }
+
+    if (op == "fence.put") {
+        const QJsonObject fence = record.value("fence").toObject();
+        const int index = indexOfFence(fences, id);
+        if (index >= 0) {
+            fences.replace(index, fence);
+        } else {
+            fences.append(fence);
+        }
+        fencesData->insert("fences", fences);
+        return true;
+    }
+
+    const int fenceIndex = indexOfFence(fences, id);
+    if (fenceIndex < 0) {
+        return false;
+    }
+
+    if (op == "fence.remove") {
+        fences.removeAt(fenceIndex);
+        fencesData->insert("fences", fences);
+        return true;
+    }
+
+    QJsonObject fence = fences.at(fenceIndex).toObject();
+
+    if (op == "fence.set") {
+        const QJsonObject props = record.value("props").toObject();
+        for (auto it = props.constBegin(); it != props.constEnd(); ++it) {
+            fence.insert(it.key(), it.value());
+        }
+        for (const QJsonValue &key : record.value("unset").toArray()) {
+            fence.remove(key.toString());
+        }
+    } else {
+        QJsonArray icons = fence.value("icons").toArray();
+
+        if (op == "icons.reset") {
+            icons = record.value("icons").toArray();
+        } else if (op == "icon.insert") {
+            const int index = record.value("index").toInt(-1);
+            if (index < 0 || index > icons.size()) {
+                return false;
+            }
+            icons.insert(index, record.value("icon"));
+        } else if (op == "icon.remove") {
+            const int index = record.value("index").toInt(-1);
+            if (index < 0 || index >= icons.size()) {
+                return false;
+            }
+            icons.removeAt(index);
+        } else if (op == "icon.move") {
+            const int from = record.value("from").toInt(-1);
+            const int to = record.value("to").toInt(-1);
+            if (from < 0 || from >= icons.size() || to < 0 || to >= icons.size()) {
+                return false;
+            }
+            icons.insert(to, icons.takeAt(from));
+        } else if (op == "icon.set") {
+            const int index = record.value("index").toInt(-1);
+            if (index < 0 || index >= icons.size()) {
+                return false;
+            }
+            icons.replace(index, record.value("icon"));
+        } else {
+            return false;
+        }
+
+        fence.insert("icons", icons);
+    }
+
+    fences.replace(fenceIndex, fence);
+    fencesData->insert("fences", fences);
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef FENCEJOURNAL_H
+#define FENCEJOURNAL_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+/**
+ * @brief 围栏布局预写日志
+ * 以追加方式记录单个围栏的增量变更（几何、标题、图标插入/删除/排序），
+ * 由 ConfigManager 定期压缩回 fencing_config.json 主快照。
+ *
+ * 文件格式：每条记录为 [uint32 长度][uint32 CRC32][紧凑 JSON]，小端序。
+ * 第一条记录为 header，携带与主快照一致的 journalId；
+ * id 不匹配的日志视为已被压缩过的旧日志，直接忽略。
+ */
+class FenceJournal
+{
+public:
+    enum class ReplayResult {
+        NoJournal,   // 日志不存在
+        Stale,       // 日志与主快照不匹配（或头部损坏），已忽略
+        Replayed,    // 完整重放
+        Recovered,   // 重放成功，但截断了损坏的尾部记录
+        IOError
+    };
+
+    explicit FenceJournal(const QString &path = QString());
+
+    void setPath(const QString &path) { m_path = path; }
+    QString path() const { return m_path; }
+
+    // 当前日志文件大小（字节），不存在时为 0
+    qint64 size() const;
+
+    // 清空日志并写入新的 header（主快照提交之后调用）
+    bool reset(const QString &journalId);
+
+    // 追加一批增量记录并落盘
+    bool append(const QList<QJsonObject> &records);
+
+    // 将日志中的记录依次应用到 fencesData 上；尾部残缺的记录会被截断
+    ReplayResult replay(const QString &journalId, QJsonObject *fencesData, int *appliedCount = nullptr);
+
+    // 不解释记录内容，按顺序读出 header 之后的全部记录（供其他使用同一格式的日志复用）；
+    // 尾部残缺的记录同样会被截断
+    ReplayResult read(const QString &journalId, QList<QJsonObject> *records);
+
+    bool remove();
+
+    // 计算 oldData -> newData 的增量记录；无法表示为增量时返回 false（调用方应改写完整快照）。
+    // unchangedIds 为调用方按围栏版本号确认未变化的围栏，跳过对它们的深比较
+    static bool diff(const QJsonObject &oldData, const QJsonObject &newData, QList<QJsonObject> *records,
+                     const QSet<QString> &unchangedIds = QSet<QString>());
+
+    // 将单条记录应用到 fencesData 上；记录与数据不一致时返回 false
+    static bool apply(const QJsonObject &record, QJsonObject *fencesData);
+
+private:
+    QString m_path;
+};
+
+#endif // FENCEJOURNAL_H
@@ -1,7 +1,18 @@
 #include "fencemanager.h"
 #include "../ui/fencewindow.h"
+#include "../ui/scalediconcache.h"
 #include "configmanager.h"
+#include "fileoperationqueue.h"
 #include "iconhelper.h"
+#include "iconcache.h"
+#include "iconloadscheduler.h"
+#include "logger.h"
+#include "storageindex.h"
+#include "storagegenerations.h"
+#include "zipwriter.h"
+#include "backupstore.h"
+#include "contentmanifest.h"
+#include "autosnapshots.h"
 #include "../platform/blurhelper.h"
 
 #include <QApplication>
@@ -25,6 +36,13 @@
 #include <QDebug>
 #include <QSaveFile>
 #include <QTemporaryDir>
+#include <QScopedValueRollback>
+#include <QProgressDialog>
+#include <QInputDialog>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QtConcurrent>
+#include <atomic>
 #include <QWidgetAction>
 #include <QEvent>
 #include <QMouseEvent>
@@ -43,12 +61,31 @@
 namespace {
 const char *kBackupManifestFileName = "external_icon_manifest.json";
 const char *kBackupExternalDirName = "external_icons";
+// 自动快照的检查间隔：到期但正忙时最多推迟这么久
+const int kAutoSnapshotCheckIntervalMs = 60 * 1000;
 
 QString normalizeNativePath(const QString &path)
 {
     return QDir::toNativeSeparators(QDir::cleanPath(path));
 }
 
+// 布局中引用的全部图标文件（绝对路径）
+QStringList referencedIconPaths(const QJsonObject &fencesData)
+{
+    QStringList paths;
+    for (const QJsonValue &fenceValue : fencesData.value("fences").toArray()) {
+        const QJsonObject fenceObject = fenceValue.toObject();
+        const QString fenceId = fenceObject.value("id").toString();
+        for (const QJsonValue &iconValue : fenceObject.value("icons").toArray()) {
+            const QString savedPath = iconValue.toObject().value("path").toString();
+            if (!savedPath.isEmpty()) {
+                paths.append(normalizeNativePath(IconHelper::fromStoragePath(savedPath, fenceId)));
+            }
+        }
+    }
+    return paths;
+}
+
 bool shouldTreatEntryAsFile(const QFileInfo &entry)
 {
     const QString suffix = entry.suffix().toLower();
@@ -84,46 +121,6 @@ bool copyFileReplacing(const QString &sourcePath, const QString &targetPath, QSt
     return true;
 }
 
-bool copyDirectoryRecursively(const QString &sourceDirPath, const QString &targetDirPath, QString *errorMessage)
-{
-    QDir sourceDir(normalizeNativePath(sourceDirPath));
-    if (!sourceDir.exists()) {
-        if (errorMessage) {
-            *errorMessage = QString("源目录不存在：%1").arg(sourceDir.absolutePath());
-        }
-        return false;
-    }
-
-    QDir targetDir(normalizeNativePath(targetDirPath));
-    if (!targetDir.exists() && !QDir().mkpath(targetDir.absolutePath())) {
-        if (errorMessage) {
-            *errorMessage = QString("无法创建目录：%1").arg(targetDir.absolutePath());
-        }
-        return false;
-    }
-
-    const QFileInfoList entries = sourceDir.entryInfoList(
-        QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs | QDir::Hidden | QDir::System);
-
-    for (const QFileInfo &entry : entries) {
-        const QString sourcePath = entry.absoluteFilePath();
-        const QString targetPath = normalizeNativePath(targetDir.absoluteFilePath(entry.fileName()));
-
-        if (entry.isDir() && !shouldTreatEntryAsFile(entry)) {
-            if (!copyDirectoryRecursively(sourcePath, targetPath, errorMessage)) {
-                return false;
-            }
-            continue;
-        }
-
-        if (!copyFileReplacing(sourcePath, targetPath, errorMessage)) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
 bool writeJsonObjectToFile(const QString &path, const QJsonObject &jsonObject, QString *errorMessage)
 {
     QSaveFile file(normalizeNativePath(path));
@@ -205,12 +202,32 @@ QString uniqueStorageFileName(const QString &directoryPath, const QString &prefe
     return candidate;
 }
 
-bool prepareBackupBundle(const QString &appDataDir, const QString &bundleDir, QString *errorMessage, int *bundledExternalCount, int *missingExternalCount)
+// 递归把目录下的文件加入归档（.lnk/.url 与符号链接按文件处理，不进入目录）
+// Writer 为 ZipWriter（.zip 导出）或 BackupStore（增量快照），两者条目接口相同
+template <typename Writer>
+void addDirectoryToArchive(Writer *writer, const QString &sourceDirPath, const QString &archivePrefix)
+{
+    const QFileInfoList entries = QDir(sourceDirPath).entryInfoList(
+        QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs | QDir::Hidden | QDir::System, QDir::Name);
+
+    for (const QFileInfo &entry : entries) {
+        const QString archiveName = archivePrefix + "/" + entry.fileName();
+        if (entry.isDir() && !shouldTreatEntryAsFile(entry)) {
+            addDirectoryToArchive(writer, entry.absoluteFilePath(), archiveName);
+            continue;
+        }
+        writer->addFile(archiveName, entry.absoluteFilePath());
+    }
+}
+
+// 把备份内容直接登记为归档条目（源文件原地读取，不再复制到临时目录）：
+// fencing_config.json、fences_storage/、user_settings.ini，以及布局引用的存储目录之外的图标文件
+template <typename Writer>
+bool addBackupEntries(const QString &appDataDir, Writer *writer, QString *errorMessage, int *bundledExternalCount, int *missingExternalCount)
 {
     const QString normalizedAppDataDir = normalizeNativePath(appDataDir);
-    const QString normalizedBundleDir = normalizeNativePath(bundleDir);
     const QString fencesJsonPath = normalizeNativePath(normalizedAppDataDir + "/fencing_config.json");
-    const QString fencesStoragePath = normalizeNativePath(normalizedAppDataDir + "/fences_storage");
+    const QString fencesStoragePath = normalizeNativePath(ConfigManager::instance()->fencesStoragePath());
     const QString userSettingsPath = normalizeNativePath(normalizedAppDataDir + "/user_settings.ini");
 
     if (bundledExternalCount) {
@@ -220,19 +237,14 @@ bool prepareBackupBundle(const QString &appDataDir, const QString &bundleDir, QS
         *missingExternalCount = 0;
     }
 
-    if (QFile::exists(fencesJsonPath) &&
-        !copyFileReplacing(fencesJsonPath, normalizedBundleDir + "/fencing_config.json", errorMessage)) {
-        return false;
+    if (QFile::exists(fencesJsonPath)) {
+        writer->addFile("fencing_config.json", fencesJsonPath);
     }
-
-    if (QDir(fencesStoragePath).exists() &&
-        !copyDirectoryRecursively(fencesStoragePath, normalizedBundleDir + "/fences_storage", errorMessage)) {
-        return false;
+    if (QDir(fencesStoragePath).exists()) {
+        addDirectoryToArchive(writer, fencesStoragePath, "fences_storage");
     }
-
-    if (QFile::exists(userSettingsPath) &&
-        !copyFileReplacing(userSettingsPath, normalizedBundleDir + "/user_settings.ini", errorMessage)) {
-        return false;
+    if (QFile::exists(userSettingsPath)) {
+        writer->addFile("user_settings.ini", userSettingsPath);
     }
 
     QJsonObject fencesData;
@@ -249,6 +261,7 @@ bool prepareBackupBundle(const QString &appDataDir, const QString &bundleDir, QS
         : storageRoot + QDir::separator();
     const QJsonArray fencesArray = fencesData.value("fences").toArray();
     QJsonArray manifestArray;
+    QSet<QString> bundledPaths;
 
     for (const QJsonValue &fenceValue : fencesArray) {
         const QJsonObject fenceObject = fenceValue.toObject();
@@ -279,10 +292,11 @@ bool prepareBackupBundle(const QString &appDataDir, const QString &bundleDir, QS
                 resolvedPath.toUtf8(), QCryptographicHash::Sha1).toHex();
             const QString bundleFileName = QString("%1_%2").arg(QString::fromLatin1(hash.left(12)), fileInfo.fileName());
             const QString bundleRelativePath = QString("%1/%2").arg(kBackupExternalDirName, bundleFileName);
-            const QString bundleAbsolutePath = normalizeNativePath(normalizedBundleDir + "/" + bundleRelativePath);
 
-            if (!copyFileReplacing(resolvedPath, bundleAbsolutePath, errorMessage)) {
-                return false;
+            // 同一文件被多个围栏引用时归档中只存一份
+            if (!bundledPaths.contains(bundleRelativePath)) {
+                bundledPaths.insert(bundleRelativePath);
+                writer->addFile(bundleRelativePath, resolvedPath);
             }
 
             QJsonObject manifestObject;
@@ -305,7 +319,8 @@ bool prepareBackupBundle(const QString &appDataDir, const QString &bundleDir, QS
     QJsonObject manifestRoot;
     manifestRoot["version"] = 1;
     manifestRoot["externalIcons"] = manifestArray;
-    return writeJsonObjectToFile(normalizedBundleDir + "/" + kBackupManifestFileName, manifestRoot, errorMessage);
+    writer->addData(kBackupManifestFileName, QJsonDocument(manifestRoot).toJson(QJsonDocument::Indented));
+    return true;
 }
 
 bool materializeBundledIconsIntoStorage(const QString &bundleRootDir, QString *errorMessage)
@@ -387,6 +402,179 @@ bool materializeBundledIconsIntoStorage(const QString &bundleRootDir, QString *e
     fencesData["fences"] = fencesArray;
     return writeJsonObjectToFile(fencesJsonPath, fencesData, errorMessage);
 }
+
+// 用 sourcePath 的内容整体替换 targetPath：经 QSaveFile 写临时文件后改名，中途失败或崩溃时旧文件保持完整
+bool replaceFileAtomically(const QString &sourcePath, const QString &targetPath, QString *errorMessage)
+{
+    const QString normalizedSource = normalizeNativePath(sourcePath);
+    const QString normalizedTarget = normalizeNativePath(targetPath);
+
+    QFile source(normalizedSource);
+    if (!source.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法读取文件：%1").arg(normalizedSource);
+        }
+        return false;
+    }
+    const QByteArray data = source.readAll();
+
+    QDir().mkpath(QFileInfo(normalizedTarget).absolutePath());
+    QSaveFile target(normalizedTarget);
+    if (!target.open(QIODevice::WriteOnly) || target.write(data) != data.size() || !target.commit()) {
+        if (errorMessage) {
+            *errorMessage = QString("无法写入文件：%1").arg(normalizedTarget);
+        }
+        return false;
+    }
+    return true;
+}
+
+QString formatBytes(qint64 bytes)
+{
+    if (bytes >= 1024 * 1024) {
+        return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    if (bytes >= 1024) {
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QString("%1 字节").arg(bytes);
+}
+
+// 在后台线程执行耗时的备份任务，期间显示可取消的模态进度框。
+// task 收到的进度回调可在任意线程调用，返回 false 表示用户已取消
+bool runWithProgress(const QString &title, const QString &label,
+                     const std::function<bool(const std::function<bool(qint64, qint64)> &)> &task,
+                     bool *cancelledOut = nullptr)
+{
+    // 千分比，避免字节数超过 int 范围
+    QProgressDialog progressDialog(label, "取消", 0, 1000);
+    progressDialog.setWindowTitle(title);
+    progressDialog.setWindowModality(Qt::ApplicationModal);
+    progressDialog.setMinimumDuration(300);
+    progressDialog.setAutoClose(false);
+    progressDialog.setAutoReset(false);
+
+    std::atomic<bool> cancelled{false};
+    QObject::connect(&progressDialog, &QProgressDialog::canceled, [&cancelled]() { cancelled = true; });
+
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::run([&task, &cancelled, &progressDialog]() {
+        return task([&cancelled, &progressDialog](qint64 done, qint64 total) {
+            const int value = total > 0 ? int(done * 1000 / total) : 1000;
+            QMetaObject::invokeMethod(&progressDialog, [&progressDialog, value]() {
+                progressDialog.setValue(value);
+            }, Qt::QueuedConnection);
+            return !cancelled;
+        });
+    }));
+    loop.exec();
+    progressDialog.close();
+
+    if (cancelledOut) {
+        *cancelledOut = cancelled;
+    }
+    return watcher.result();
+}
+
+// 用 PowerShell 的 Expand-Archive 把 .zip 解压到 targetDir
+bool extractZipArchive(const QString &zipPath, const QString &targetDir, QString *errorMessage)
+{
+    QString psCmd = QString(
+        "Expand-Archive -Path '%1' -DestinationPath '%2' -Force"
+    ).arg(zipPath, normalizeNativePath(targetDir));
+
+    QProcess proc;
+    proc.setProgram("powershell.exe");
+    proc.setArguments({"-NonInteractive", "-NoProfile", "-Command", psCmd});
+    proc.start();
+    proc.waitForFinished(30000);
+
+    if (proc.exitCode() != 0) {
+        if (errorMessage) {
+            *errorMessage = QString::fromUtf8(proc.readAllStandardError());
+        }
+        return false;
+    }
+    return true;
+}
+
+// 在进度框下按内容清单检查 rootDir，见 ContentManifest::verify
+bool verifyWithProgress(const QString &title, const ContentManifest &manifest, const QString &rootDir,
+                        const QString &prefix, ContentManifest::Report *report, bool *cancelled, QString *errorMessage)
+{
+    return runWithProgress(title, "正在校验文件内容…",
+        [&manifest, &rootDir, &prefix, report, errorMessage](const ContentManifest::Progress &progress) {
+            return manifest.verify(rootDir, prefix, progress, report, errorMessage);
+        }, cancelled);
+}
+
+QString describeVerifyReport(const ContentManifest::Report &report)
+{
+    QString text = QString("共校验 %1 个文件（%2），用时 %3 秒，%4 MB/s。")
+        .arg(report.fileCount)
+        .arg(formatBytes(report.totalBytes))
+        .arg(report.elapsedMs / 1000.0, 0, 'f', 1)
+        .arg(report.megabytesPerSecond(), 0, 'f', 1);
+
+    auto appendNames = [&text](const QString &label, const QStringList &names) {
+        if (names.isEmpty()) {
+            return;
+        }
+        const int shown = qMin(names.size(), 10);
+        text += QString("\n\n%1（%2 个）：\n%3").arg(label).arg(names.size()).arg(QStringList(names.mid(0, shown)).join("\n"));
+        if (names.size() > shown) {
+            text += QString("\n……另有 %1 项").arg(names.size() - shown);
+        }
+    };
+    appendNames("内容不符", report.mismatched);
+    appendNames("缺失", report.missing);
+    appendNames("清单之外的文件", report.unexpected);
+    return text;
+}
+
+// 列表选择对话框，返回所选行号，取消时返回 -1。
+// 显示文本可能重复（同一秒内的快照），加上序号后按行号取回条目
+int chooseRow(const QString &title, const QString &label, const QStringList &labels)
+{
+    QStringList items;
+    for (int i = 0; i < labels.size(); ++i) {
+        items.append(QString("%1. %2").arg(i + 1).arg(labels.at(i)));
+    }
+    bool ok = false;
+    const QString item = QInputDialog::getItem(nullptr, title, label, items, 0, false, &ok);
+    return ok ? items.indexOf(item) : -1;
+}
+
+// 让用户从增量备份库中选择一份快照，取消时返回空字符串
+QString chooseSnapshot(const BackupStore &store, const QString &title, const QString &label)
+{
+    const QList<BackupStore::Snapshot> snapshots = store.snapshots();
+    if (snapshots.isEmpty()) {
+        QMessageBox::information(nullptr, title, "增量备份库中还没有快照。");
+        return QString();
+    }
+
+    QStringList items;
+    for (const BackupStore::Snapshot &snapshot : snapshots) {
+        items.append(QString("%1（%2 个文件，%3）")
+            .arg(snapshot.created.toString("yyyy-MM-dd HH:mm:ss"))
+            .arg(snapshot.fileCount)
+            .arg(formatBytes(snapshot.totalBytes)));
+    }
+
+    const int row = chooseRow(title, label, items);
+    return row < 0 ? QString() : snapshots.at(row).id;
+}
+
+// 围栏数据所在目录（fencing_config.json、fences_storage 所在的 AppData 目录）
+QString appDataDirectory()
+{
+    QDir storageDir(ConfigManager::instance()->fencesStoragePath());
+    storageDir.cdUp();
+    return storageDir.absolutePath();
+}
 }
 
 FenceManager* FenceManager::instance()
@@ -409,9 +597,18 @@ FenceManager::~FenceManager()
 
 void FenceManager::initialize()
 {
+    // 先映射图标缓存，围栏恢复时即可直接命中
+    IconCache::instance()->open(ConfigManager::instance()->iconCachePath());
+    ScaledIconCache::instance()->setBudget(ConfigManager::instance()->iconPixmapCacheKB());
+
+    // 上次退出前未确认的图标文件移动，按已保存的布局前滚或回滚，之后再加载围栏
+    FileOperationQueue::instance()->setJournalPath(ConfigManager::instance()->fileOperationsJournalPath());
+    FileOperationQueue::instance()->recover(referencedIconPaths(ConfigManager::instance()->fencesData()));
+
     setupTrayIcon();
     loadFences();
     showAllFences();
+    setupAutoSnapshots();
 
     // ── 监听显示器配置变化 ──────────────────────────────────────────
     // 连接已存在屏幕的几何变化信号
@@ -437,6 +634,14 @@ void FenceManager::shutdown()
 {
     if (m_isShutdown) return;
 
+    // 不再拍新的自动快照；正在创建的一份在全局线程池中继续，程序退出时线程池会等它完成
+    if (m_autoSnapshotTimer) {
+        m_autoSnapshotTimer->stop();
+    }
+
+    // 未开始的文件移动直接丢弃，执行中的等它完成；已完成但未写入布局的由下次启动时恢复
+    FileOperationQueue::instance()->shutdown();
+
     // 先停止所有围栏的保存定时器，并立即触发保存
     for (FenceWindow *fence : m_fences) {
         if (fence) {
@@ -452,6 +657,9 @@ void FenceManager::shutdown()
     // 等待一小段时间，确保所有信号都被处理
     QCoreApplication::processEvents();
 
+    // 停止后台图标加载，之后才能安全写出图标缓存
+    IconLoadScheduler::instance()->shutdown();
+
     // 关闭所有围栏
     for (FenceWindow *fence : m_fences) {
         if (fence) {
@@ -470,6 +678,9 @@ void FenceManager::shutdown()
     
     // 强制同步所有配置到磁盘
     ConfigManager::instance()->sync();
+
+    // 写出本次新提取的图标并压缩失效条目
+    IconCache::instance()->save();
 }
 
 void FenceManager::setupTrayIcon()
@@ -707,12 +918,42 @@ void FenceManager::setupTrayIcon()
 
     QAction *backupAction  = dataMenu->addAction("备份围栏");
     QAction *restoreAction = dataMenu->addAction("还原围栏");
+    QAction *verifyAction  = dataMenu->addAction("校验备份文件");
     connect(backupAction,  &QAction::triggered, this, [this]() {
         QTimer::singleShot(10, this, [this]() { onBackupFencesRequested(); });
     });
     connect(restoreAction, &QAction::triggered, this, [this]() {
         QTimer::singleShot(10, this, [this]() { onRestoreFencesRequested(); });
     });
+    connect(verifyAction,  &QAction::triggered, this, [this]() {
+        QTimer::singleShot(10, this, [this]() { onVerifyBackupRequested(); });
+    });
+
+    dataMenu->addSeparator();
+    QAction *snapshotAction        = dataMenu->addAction("增量备份");
+    QAction *snapshotRestoreAction = dataMenu->addAction("从快照还原");
+    QAction *snapshotVerifyAction  = dataMenu->addAction("校验快照");
+    QAction *storageVerifyAction   = dataMenu->addAction("校验图标存储");
+    QAction *snapshotPruneAction   = dataMenu->addAction("清理旧快照");
+    QAction *autoSnapshotAction    = dataMenu->addAction("从自动快照还原");
+    connect(snapshotAction, &QAction::triggered, this, [this]() {
+        QTimer::singleShot(10, this, [this]() { onSnapshotBackupRequested(); });
+    });
+    connect(snapshotRestoreAction, &QAction::triggered, this, [this]() {
+        QTimer::singleShot(10, this, [this]() { onSnapshotRestoreRequested(); });
+    });
+    connect(snapshotVerifyAction, &QAction::triggered, this, [this]() {
+        QTimer::singleShot(10, this, [this]() { onSnapshotVerifyRequested(); });
+    });
+    connect(storageVerifyAction, &QAction::triggered, this, [this]() {
+        QTimer::singleShot(10, this, [this]() { onStorageVerifyRequested(); });
+    });
+    connect(snapshotPruneAction, &QAction::triggered, this, [this]() {
+        QTimer::singleShot(10, this, [this]() { onSnapshotPruneRequested(); });
+    });
+    connect(autoSnapshotAction, &QAction::triggered, this, [this]() {
+        QTimer::singleShot(10, this, [this]() { onAutoSnapshotRestoreRequested(); });
+    });
 
 #ifdef Q_OS_WIN
     connect(dataMenu, &QMenu::aboutToShow, this, [dataMenu]() {
@@ -832,17 +1073,8 @@ bool FenceManager::eventFilter(QObject *watched, QEvent *event)
 FenceWindow* FenceManager::createFence(const QString &title)
 {
     FenceWindow *fence = new FenceWindow(title);
-    fence->setWindowIcon(m_trayIcon->icon()); // 设置窗口图标
     fence->move(getNewFencePosition());
-    
-    connect(fence, &FenceWindow::deleteRequested, 
-            this, &FenceManager::onFenceDeleteRequested);
-    connect(fence, &FenceWindow::geometryChanged, 
-            this, &FenceManager::saveFences);
-    connect(fence, &FenceWindow::titleChanged,
-            this, &FenceManager::saveFences);
-    connect(fence, &FenceWindow::collapsedChanged,
-            this, &FenceManager::saveFences);
+    attachFence(fence);
     
     m_fences.append(fence);
     fence->show();
@@ -856,7 +1088,7 @@ void FenceManager::removeFence(FenceWindow *fence)
     if (ConfigManager::instance()->layoutLocked()) return;
 
     if (fence && m_fences.contains(fence)) {
-        // 先归还所有图标到桌面
+        // 先归还所有图标到桌面（包括仍在移入途中的文件），之后不再有该围栏的文件操作
         fence->restoreAllIcons();
 
         // 删除该围栏在 fences_storage 下的存储目录（图标快捷方式等）
@@ -881,19 +1113,32 @@ void FenceManager::saveFences()
 
     for (FenceWindow *fence : m_fences) {
         if (fence && fence->isRestoringFromJson()) {
-            ConfigManager::writeLog("[saveFences] Skipped while fence is still restoring from JSON: " + fence->title());
+            LOG_DEBUG(Logger::Config, "[saveFences] Skipped while fence is still restoring from JSON: " + fence->title());
             return;
         }
     }
 
-    QJsonArray fencesArray;
+    // 每个围栏都缓存了自己的序列化结果；围栏顺序与版本号都未变化时无需重新组装
+    QVector<QPair<FenceWindow*, quint64>> revisions;
+    revisions.reserve(m_fences.size());
     for (FenceWindow *fence : m_fences) {
-        fencesArray.append(fence->toJson());
+        revisions.append(qMakePair(fence, fence->serializationRevision()));
+    }
+    if (revisions == m_savedRevisions) {
+        return;
+    }
+
+    QJsonArray fencesArray;
+    QHash<QString, quint64> fenceRevisions;
+    for (const auto &entry : qAsConst(revisions)) {
+        fencesArray.append(entry.first->toJson());
+        fenceRevisions.insert(entry.first->id(), entry.second);
     }
 
     QJsonObject data;
     data["fences"] = fencesArray;
-    ConfigManager::instance()->setFencesData(data);
+    ConfigManager::instance()->setFencesData(data, fenceRevisions);
+    m_savedRevisions = revisions;
 }
 
 void FenceManager::loadFences()
@@ -912,18 +1157,7 @@ void FenceManager::loadFences()
         }
         
         // 关键：恢复时同样要设置图标
-        if (m_trayIcon) {
-            fence->setWindowIcon(m_trayIcon->icon());
-        }
-        
-        connect(fence, &FenceWindow::deleteRequested, 
-                this, &FenceManager::onFenceDeleteRequested);
-        connect(fence, &FenceWindow::geometryChanged, 
-                this, &FenceManager::saveFences);
-        connect(fence, &FenceWindow::titleChanged,
-                this, &FenceManager::saveFences);
-        connect(fence, &FenceWindow::collapsedChanged,
-                this, &FenceManager::saveFences);
+        attachFence(fence);
         
         // 连接首次显示完成信号
         connect(fence, &FenceWindow::firstShowCompleted, this, [fence]() {
@@ -1012,13 +1246,13 @@ void FenceManager::onExitRequested()
 // ─────────────────────────────────────────────────────────────────
 // 围栏数据备份
 // 将 fencing_config.json、fences_storage 以及围栏引用的外部图标文件打包为 .zip
-// 依赖 Windows PowerShell Compress-Archive（无需第三方库）
+// 由 ZipWriter 在后台线程中直接从源文件流式写入，不再复制到临时目录
 // ─────────────────────────────────────────────────────────────────
 void FenceManager::onBackupFencesRequested()
 {
-    // 先强制保存当前数据，确保备份的是最新状态
+    // 先强制保存当前数据，并把增量日志合并回主快照，确保备份的是最新状态
     saveFences();
-    ConfigManager::instance()->sync();
+    ConfigManager::instance()->compact();
 
     // 弹出保存对话框
     QString defaultName = QString("DeskGo_backup_%1.zip")
@@ -1033,43 +1267,28 @@ void FenceManager::onBackupFencesRequested()
     if (savePath.isEmpty()) return;
     if (!savePath.endsWith(".zip", Qt::CaseInsensitive)) savePath += ".zip";
 
-    // 删除已存在的目标文件
-    if (QFile::exists(savePath)) QFile::remove(savePath);
-
-    QString configPath    = ConfigManager::instance()->fencesStoragePath();
-    // fencesStoragePath: ...AppData/Local/DeskGo/fences_storage
-    // fencing_config.json 在其上一级
-    QDir storageDir(configPath);
-    storageDir.cdUp();
-    QString appDataDir = storageDir.absolutePath(); // .../AppData/Local/DeskGo
-
-    QTemporaryDir bundleDir;
-    if (!bundleDir.isValid()) {
-        QMessageBox::critical(nullptr, "备份失败", "无法创建临时备份目录。");
-        return;
-    }
+    const QString appDataDir = appDataDirectory(); // .../AppData/Local/DeskGo
 
+    // 归档先写到临时文件，成功后才替换目标文件；末尾附带各条目 SHA-256 的内容清单，还原和校验时据此检查
+    ZipWriter writer(savePath);
+    writer.setContentManifestName(ContentManifest::kFileName);
     QString prepareError;
     int bundledExternalCount = 0;
     int missingExternalCount = 0;
-    if (!prepareBackupBundle(appDataDir, bundleDir.path(), &prepareError, &bundledExternalCount, &missingExternalCount)) {
+    if (!addBackupEntries(appDataDir, &writer, &prepareError, &bundledExternalCount, &missingExternalCount)) {
         QMessageBox::critical(nullptr, "备份失败",
             QString("准备备份数据时出错：\n%1").arg(prepareError.isEmpty() ? "未知错误" : prepareError));
         return;
     }
 
-    const QString bundleRoot = normalizeNativePath(bundleDir.path());
-    QString psCmd = QString(
-        "Compress-Archive -Path '%1\\*' -DestinationPath '%2' -Force"
-    ).arg(bundleRoot, savePath);
-
-    QProcess proc;
-    proc.setProgram("powershell.exe");
-    proc.setArguments({"-NonInteractive", "-NoProfile", "-Command", psCmd});
-    proc.start();
-    proc.waitForFinished(30000); // 最多等 30 秒
+    QString writeError;
+    bool cancelled = false;
+    const bool ok = runWithProgress("备份围栏数据", "正在备份围栏数据…",
+        [&writer, &writeError](const ZipWriter::Progress &progress) {
+            return writer.write(progress, &writeError);
+        }, &cancelled);
 
-    if (proc.exitCode() == 0 && QFile::exists(savePath)) {
+    if (ok) {
         QString message = "围栏数据已成功备份。";
         if (bundledExternalCount > 0) {
             message += QString("\n已额外打包 %1 个围栏引用的外部图标文件。").arg(bundledExternalCount);
@@ -1078,19 +1297,22 @@ void FenceManager::onBackupFencesRequested()
             message += QString("\n另有 %1 个外部图标文件当前已丢失，无法收入本次备份。").arg(missingExternalCount);
         }
         QMessageBox::information(nullptr, "备份成功", message);
-    } else {
-        QString errMsg = QString::fromUtf8(proc.readAllStandardError());
+    } else if (!cancelled) {
         QMessageBox::critical(nullptr, "备份失败",
-            QString("备份围栏数据时出错：\n%1").arg(errMsg.isEmpty() ? "未知错误" : errMsg));
+            QString("备份围栏数据时出错：\n%1").arg(writeError.isEmpty() ? "未知错误" : writeError));
     }
 }
 
 // ─────────────────────────────────────────────────────────────────
 // 围栏数据还原
-// 从 .zip 中解压、补齐外部图标文件并覆盖 AppData 目录下的围栏数据，然后重启应用
+// 从 .zip 中解压、补齐外部图标文件，替换 AppData 目录下的围栏数据并在线套用，不再重启应用
 // ─────────────────────────────────────────────────────────────────
 void FenceManager::onRestoreFencesRequested()
 {
+    // 正在拍的自动快照先结束，还原后的垃圾回收才不会删掉它正在读取的存储目录；还原结束前不再拍新的
+    const QScopedValueRollback<bool> restoring(m_restoreInProgress, true);
+    m_autoSnapshotTask.waitForFinished();
+
     QString zipPath = QFileDialog::getOpenFileName(
         nullptr,
         "还原围栏数据",
@@ -1107,27 +1329,18 @@ void FenceManager::onRestoreFencesRequested()
     int ret = QMessageBox::warning(
         nullptr,
         "确认还原",
-        "还原操作将覆盖当前所有围栏数据，应用随后将自动重启。\n\n确定要继续吗？",
+        "还原操作将覆盖当前所有围栏数据。\n\n确定要继续吗？",
         QMessageBox::Yes | QMessageBox::No,
         QMessageBox::No
     );
     if (ret != QMessageBox::Yes) return;
 
-    QString configPath    = ConfigManager::instance()->fencesStoragePath();
-    QDir storageDir(configPath);
-    storageDir.cdUp();
-    QString appDataDir = storageDir.absolutePath();
-
-    // 先删除旧数据
-    QString oldJson    = appDataDir + "/fencing_config.json";
-    QString oldStorage = appDataDir + "/fences_storage";
-    QString oldSettings = appDataDir + "/user_settings.ini";
-
     // 关键修复：阻止应用内正在进行的任何异步保存写入动作
     // 否则它们可能会在 Expand-Archive 解压之后被写入，覆盖掉我们刚刚还原好的数据！
     ConfigManager::instance()->stopSave();
 
-    QTemporaryDir extractDir;
+    // 临时目录与 fences_storage 放在同一目录下，还原时存储目录才能直接改名替换
+    QTemporaryDir extractDir(appDataDirectory() + "/restore-XXXXXX");
     if (!extractDir.isValid()) {
         ConfigManager::instance()->resumeSave();
         QMessageBox::critical(nullptr, "还原失败", "无法创建临时还原目录。");
@@ -1135,35 +1348,122 @@ void FenceManager::onRestoreFencesRequested()
     }
 
     // 先解压到临时目录，校验并补齐外部图标文件后再整体覆盖正式数据目录
-    QString psCmd = QString(
-        "Expand-Archive -Path '%1' -DestinationPath '%2' -Force"
-    ).arg(zipPath, normalizeNativePath(extractDir.path()));
+    QString extractError;
+    if (!extractZipArchive(zipPath, extractDir.path(), &extractError)) {
+        ConfigManager::instance()->resumeSave();
+        QMessageBox::critical(nullptr, "还原失败",
+            QString("还原围栏数据时出错：\n%1").arg(extractError.isEmpty() ? "未知错误" : extractError));
+        return;
+    }
 
-    QProcess proc;
-    proc.setProgram("powershell.exe");
-    proc.setArguments({"-NonInteractive", "-NoProfile", "-Command", psCmd});
-    proc.start();
-    proc.waitForFinished(30000);
+    // 带内容清单的备份先逐个文件核对哈希，有损坏时不覆盖当前数据；旧备份没有清单，直接还原
+    const QString manifestPath = normalizeNativePath(extractDir.path() + "/" + ContentManifest::kFileName);
+    if (QFile::exists(manifestPath)) {
+        ContentManifest manifest;
+        ContentManifest::Report report;
+        QString verifyError;
+        bool cancelled = false;
+        const bool verified = ContentManifest::load(manifestPath, &manifest, &verifyError)
+            && verifyWithProgress("还原围栏数据", manifest, extractDir.path(), QString(), &report, &cancelled, &verifyError);
+        if (!verified || !report.mismatched.isEmpty() || !report.missing.isEmpty()) {
+            ConfigManager::instance()->resumeSave();
+            if (!verified && !cancelled) {
+                QMessageBox::critical(nullptr, "还原失败",
+                    QString("校验备份内容时出错：\n%1").arg(verifyError.isEmpty() ? "未知错误" : verifyError));
+            } else if (verified) {
+                report.unexpected.clear();
+                QMessageBox::critical(nullptr, "还原失败",
+                    "备份文件已损坏，当前数据未做任何改动。\n\n" + describeVerifyReport(report));
+            }
+            return;
+        }
+    }
 
-    if (proc.exitCode() != 0) {
+    restoreFromBackupDirectory(extractDir.path());
+}
+
+// ─────────────────────────────────────────────────────────────────
+// 校验 .zip 备份：解压到临时目录后按其中的内容清单并行重新计算每个文件的 SHA-256
+// ─────────────────────────────────────────────────────────────────
+void FenceManager::onVerifyBackupRequested()
+{
+    QString zipPath = QFileDialog::getOpenFileName(
+        nullptr,
+        "校验备份文件",
+        QStandardPaths::writableLocation(QStandardPaths::DesktopLocation),
+        "备份文件 (*.zip)"
+    );
+    if (zipPath.isEmpty()) return;
+
+    QTemporaryDir extractDir(appDataDirectory() + "/verify-XXXXXX");
+    QString extractError;
+    if (!extractDir.isValid() || !extractZipArchive(zipPath, extractDir.path(), &extractError)) {
+        QMessageBox::critical(nullptr, "校验失败",
+            QString("解压备份文件时出错：\n%1").arg(extractError.isEmpty() ? "未知错误" : extractError));
+        return;
+    }
+
+    ContentManifest manifest;
+    QString verifyError;
+    const QString manifestPath = normalizeNativePath(extractDir.path() + "/" + ContentManifest::kFileName);
+    if (!QFile::exists(manifestPath)) {
+        QMessageBox::information(nullptr, "校验备份文件", "该备份由旧版本创建，没有内容清单，无法校验。");
+        return;
+    }
+    if (!ContentManifest::load(manifestPath, &manifest, &verifyError)) {
+        QMessageBox::critical(nullptr, "校验失败", verifyError);
+        return;
+    }
+
+    ContentManifest::Report report;
+    bool cancelled = false;
+    if (!verifyWithProgress("校验备份文件", manifest, extractDir.path(), QString(), &report, &cancelled, &verifyError)) {
+        if (!cancelled) {
+            QMessageBox::critical(nullptr, "校验失败",
+                QString("校验备份文件时出错：\n%1").arg(verifyError.isEmpty() ? "未知错误" : verifyError));
+        }
+        return;
+    }
+
+    if (report.isClean()) {
+        QMessageBox::information(nullptr, "校验完成", "备份文件完整，所有文件均与内容清单一致。\n" + describeVerifyReport(report));
+    } else {
+        QMessageBox::warning(nullptr, "校验完成", "备份文件与内容清单不一致。\n\n" + describeVerifyReport(report));
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────
+// 用已解压（或从增量备份库取出）的备份目录替换当前围栏数据，并在线套用到正在运行的围栏
+// 备份目录须与 AppData 位于同一卷：备份中的存储目录直接改名为新一代存储目录，再切换指针（见 StorageGenerations）
+// 调用前须已 stopSave()；无论成功失败都在此恢复保存
+// ─────────────────────────────────────────────────────────────────
+void FenceManager::restoreFromBackupDirectory(const QString &bundleDir)
+{
+    const QString appDataDir = appDataDirectory();
+    const QString liveStorage = normalizeNativePath(ConfigManager::instance()->fencesStoragePath());
+    const QString liveSettings = normalizeNativePath(appDataDir + "/user_settings.ini");
+
+    auto fail = [](const QString &message) {
         ConfigManager::instance()->resumeSave();
-        QString errMsg = QString::fromUtf8(proc.readAllStandardError());
-        QMessageBox::critical(nullptr, "还原失败",
-            QString("还原围栏数据时出错：\n%1").arg(errMsg.isEmpty() ? "未知错误" : errMsg));
+        QMessageBox::critical(nullptr, "还原失败", message);
+    };
+
+    // 正在移动的图标文件会写入即将被替换的存储目录
+    if (!FileOperationQueue::instance()->isIdle()) {
+        ConfigManager::instance()->resumeSave();
+        QMessageBox::warning(nullptr, "还原围栏数据", "图标文件仍在移动中，请稍后再还原。");
         return;
     }
 
     QString patchError;
-    if (!materializeBundledIconsIntoStorage(extractDir.path(), &patchError)) {
-        ConfigManager::instance()->resumeSave();
-        QMessageBox::critical(nullptr, "还原失败",
-            QString("整理备份中的图标文件时出错：\n%1").arg(patchError.isEmpty() ? "未知错误" : patchError));
+    if (!materializeBundledIconsIntoStorage(bundleDir, &patchError)) {
+        fail(QString("整理备份中的图标文件时出错：\n%1").arg(patchError.isEmpty() ? "未知错误" : patchError));
         return;
     }
 
-    const QString extractedJson = normalizeNativePath(extractDir.path() + "/fencing_config.json");
-    const QString extractedStorage = normalizeNativePath(extractDir.path() + "/fences_storage");
-    const QString extractedSettings = normalizeNativePath(extractDir.path() + "/user_settings.ini");
+    const QString extractedJson = normalizeNativePath(bundleDir + "/fencing_config.json");
+    const QString extractedStorage = normalizeNativePath(bundleDir + "/fences_storage");
+    const QString extractedSettings = normalizeNativePath(bundleDir + "/user_settings.ini");
 
     // 验证关键文件存在
     bool jsonOk    = QFile::exists(extractedJson);
@@ -1177,75 +1477,483 @@ void FenceManager::onRestoreFencesRequested()
         return;
     }
 
-    if (QFile::exists(oldJson) && !QFile::remove(oldJson)) {
-        ConfigManager::instance()->resumeSave();
-        QMessageBox::critical(nullptr, "还原失败", QString("无法删除旧配置文件：\n%1").arg(oldJson));
+    QString deployError;
+    QJsonObject restoredData;
+    if (jsonOk && !readJsonObjectFromFile(extractedJson, &restoredData, &deployError)) {
+        fail(QString("读取备份中的围栏配置失败：\n%1").arg(deployError.isEmpty() ? "未知错误" : deployError));
         return;
     }
-    if (QDir(oldStorage).exists() && !QDir(oldStorage).removeRecursively()) {
-        ConfigManager::instance()->resumeSave();
-        QMessageBox::critical(nullptr, "还原失败", QString("无法删除旧图标存储目录：\n%1").arg(oldStorage));
+    // journalId 只关联备份时的增量日志，新快照写盘时会重新生成
+    restoredData.remove("journalId");
+    if (!restoredData.value("fences").isArray()) {
+        restoredData["fences"] = QJsonArray();
+    }
+
+    // 替换存储目录期间不能有待定的保存
+    for (FenceWindow *fence : m_fences) {
+        if (fence) fence->stopSaveTimer();
+    }
+
+    // 备份中的存储目录整体成为新一代：一次改名加一次指针改写，任何时刻崩溃都只会看到完整的旧代或新代
+    if (!storageOk && !QDir().mkpath(extractedStorage)) {
+        fail(QString("无法创建目录：%1").arg(extractedStorage));
         return;
     }
-    if (QFile::exists(oldSettings) && !QFile::remove(oldSettings)) {
-        ConfigManager::instance()->resumeSave();
-        QMessageBox::critical(nullptr, "还原失败", QString("无法删除旧设置文件：\n%1").arg(oldSettings));
+    QString newStorage;
+    if (!StorageGenerations::commit(appDataDir, extractedStorage, &newStorage, &deployError)) {
+        fail(QString("切换图标存储目录失败：\n%1").arg(deployError.isEmpty() ? "未知错误" : deployError));
         return;
     }
+    ConfigManager::instance()->setFencesStoragePath(newStorage);
+    StorageIndex::instance()->invalidate();
 
-    QString deployError;
-    if (jsonOk && !copyFileReplacing(extractedJson, oldJson, &deployError)) {
-        ConfigManager::instance()->resumeSave();
-        QMessageBox::critical(nullptr, "还原失败",
-            QString("写入围栏配置失败：\n%1").arg(deployError.isEmpty() ? "未知错误" : deployError));
+    // 保留下来的图标仍指向旧代目录，改写到新目录后按路径比对才能原地保留
+    for (FenceWindow *fence : m_fences) {
+        if (fence) fence->rebaseStoragePaths(liveStorage, newStorage);
+    }
+
+    // 设置文件替换失败不影响已还原的围栏，只提示
+    bool settingsOk = true;
+    if (QFile::exists(extractedSettings)) {
+        settingsOk = replaceFileAtomically(extractedSettings, liveSettings, &deployError);
+        if (settingsOk) {
+            ConfigManager::instance()->reloadSettings();
+        }
+    }
+
+    applyRestoredFences(restoredData);
+
+    // 还原后的布局作为新的主快照写盘，旧增量日志随之失效
+    ConfigManager::instance()->setFencesData(restoredData);
+    ConfigManager::instance()->resumeSave();
+    ConfigManager::instance()->compact();
+
+    // 被替换下的旧代存储目录在后台删除
+    QtConcurrent::run([appDataDir]() { StorageGenerations::collectGarbage(appDataDir); });
+
+    if (settingsOk) {
+        QMessageBox::information(nullptr, "还原成功", "围栏数据已成功还原。");
+    } else {
+        QMessageBox::warning(nullptr, "还原完成",
+            QString("围栏数据已还原，但设置文件写入失败：\n%1").arg(deployError.isEmpty() ? "未知错误" : deployError));
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────
+// 在线还原：按围栏 id 比对当前与还原后的布局，只新建、删除或原地更新有差异的围栏
+// 未变化的围栏及其已加载的图标保持不动
+// ─────────────────────────────────────────────────────────────────
+void FenceManager::applyRestoredFences(const QJsonObject &data)
+{
+    QHash<QString, FenceWindow*> currentById;
+    for (FenceWindow *fence : m_fences) {
+        currentById.insert(fence->id(), fence);
+    }
+
+    QList<FenceWindow*> restoredFences;
+    int created = 0;
+    int updated = 0;
+    int unchanged = 0;
+    for (const QJsonValue &value : data.value("fences").toArray()) {
+        const QJsonObject fenceObj = value.toObject();
+        FenceWindow *fence = currentById.take(fenceObj.value("id").toString());
+
+        // 图标仍在加载的围栏直接重建，避免与未完成的占位图标交错
+        if (fence && fence->isRestoringFromJson()) {
+            fence->close();
+            fence->deleteLater();
+            fence = nullptr;
+        }
+
+        if (!fence) {
+            fence = FenceWindow::fromJson(fenceObj);
+            attachFence(fence);
+            if (!m_fencesVisible) {
+                fence->setUserHidden(true);
+                fence->hide();
+            }
+            ++created;
+        } else if (fence->toJson() != fenceObj) {
+            fence->applyJson(fenceObj);
+            ++updated;
+        } else {
+            ++unchanged;
+        }
+        restoredFences.append(fence);
+    }
+
+    // 备份中没有的围栏：存储目录已随替换移走，只关闭窗口
+    for (FenceWindow *fence : qAsConst(currentById)) {
+        fence->stopSaveTimer();
+        fence->close();
+        fence->deleteLater();
+    }
+
+    m_fences = restoredFences;
+    m_savedRevisions.clear();
+
+    LOG_INFO(Logger::Fence, QString("[restore] Applied backup in place: %1 created, %2 updated, %3 unchanged, %4 removed")
+                                .arg(created)
+                                .arg(updated)
+                                .arg(unchanged)
+                                .arg(currentById.size()));
+}
+
+void FenceManager::attachFence(FenceWindow *fence)
+{
+    if (m_trayIcon) {
+        fence->setWindowIcon(m_trayIcon->icon());
+    }
+
+    connect(fence, &FenceWindow::deleteRequested,
+            this, &FenceManager::onFenceDeleteRequested);
+    connect(fence, &FenceWindow::geometryChanged,
+            this, &FenceManager::saveFences);
+    connect(fence, &FenceWindow::titleChanged,
+            this, &FenceManager::saveFences);
+    connect(fence, &FenceWindow::collapsedChanged,
+            this, &FenceManager::saveFences);
+}
+
+// ─────────────────────────────────────────────────────────────────
+// 增量快照备份
+// 内容相同的文件只在备份库中存一份，未变化的数据再次备份只写一份快照清单
+// ─────────────────────────────────────────────────────────────────
+void FenceManager::onSnapshotBackupRequested()
+{
+    saveFences();
+    ConfigManager::instance()->compact();
+
+    BackupStore store(ConfigManager::instance()->backupStorePath());
+    QString prepareError;
+    int bundledExternalCount = 0;
+    int missingExternalCount = 0;
+    if (!addBackupEntries(appDataDirectory(), &store, &prepareError, &bundledExternalCount, &missingExternalCount)) {
+        QMessageBox::critical(nullptr, "备份失败",
+            QString("准备备份数据时出错：\n%1").arg(prepareError.isEmpty() ? "未知错误" : prepareError));
         return;
     }
-    if (storageOk && !copyDirectoryRecursively(extractedStorage, oldStorage, &deployError)) {
+
+    QString commitError;
+    BackupStore::Stats stats;
+    bool cancelled = false;
+    const bool ok = runWithProgress("增量备份", "正在写入增量快照…",
+        [&store, &stats, &commitError](const BackupStore::Progress &progress) {
+            return store.commit(progress, nullptr, &stats, &commitError);
+        }, &cancelled);
+
+    if (ok) {
+        QString message = QString("增量快照已创建。\n共 %1 个文件（%2），其中 %3 个未变化；新写入 %4 个数据块（%5）。")
+            .arg(stats.fileCount)
+            .arg(formatBytes(stats.totalBytes))
+            .arg(stats.reusedFiles)
+            .arg(stats.storedChunks)
+            .arg(formatBytes(stats.storedBytes));
+        if (missingExternalCount > 0) {
+            message += QString("\n另有 %1 个外部图标文件当前已丢失，无法收入本次备份。").arg(missingExternalCount);
+        }
+        QMessageBox::information(nullptr, "备份成功", message);
+    } else if (!cancelled) {
+        QMessageBox::critical(nullptr, "备份失败",
+            QString("写入增量快照时出错：\n%1").arg(commitError.isEmpty() ? "未知错误" : commitError));
+    }
+}
+
+void FenceManager::onSnapshotRestoreRequested()
+{
+    // 正在拍的自动快照先结束，还原后的垃圾回收才不会删掉它正在读取的存储目录；还原结束前不再拍新的
+    const QScopedValueRollback<bool> restoring(m_restoreInProgress, true);
+    m_autoSnapshotTask.waitForFinished();
+
+    BackupStore store(ConfigManager::instance()->backupStorePath());
+    const QString snapshotId = chooseSnapshot(store, "从快照还原", "选择要还原的快照：");
+    if (snapshotId.isEmpty()) return;
+
+    int ret = QMessageBox::warning(
+        nullptr,
+        "确认还原",
+        "还原操作将覆盖当前所有围栏数据。\n\n确定要继续吗？",
+        QMessageBox::Yes | QMessageBox::No,
+        QMessageBox::No
+    );
+    if (ret != QMessageBox::Yes) return;
+
+    ConfigManager::instance()->stopSave();
+
+    // 临时目录与 fences_storage 放在同一目录下，还原时存储目录才能直接改名替换
+    QTemporaryDir extractDir(appDataDirectory() + "/restore-XXXXXX");
+    if (!extractDir.isValid()) {
         ConfigManager::instance()->resumeSave();
-        QMessageBox::critical(nullptr, "还原失败",
-            QString("写入图标存储目录失败：\n%1").arg(deployError.isEmpty() ? "未知错误" : deployError));
+        QMessageBox::critical(nullptr, "还原失败", "无法创建临时还原目录。");
         return;
     }
-    if (QFile::exists(extractedSettings) && !copyFileReplacing(extractedSettings, oldSettings, &deployError)) {
+
+    // 先取出到临时目录（逐块校验），之后与 .zip 还原走同一流程
+    QString restoreError;
+    bool cancelled = false;
+    const QString bundleDir = extractDir.path();
+    const bool ok = runWithProgress("从快照还原", "正在取出快照数据…",
+        [&store, &snapshotId, &bundleDir, &restoreError](const BackupStore::Progress &progress) {
+            return store.restore(snapshotId, bundleDir, progress, &restoreError);
+        }, &cancelled);
+
+    if (!ok) {
         ConfigManager::instance()->resumeSave();
-        QMessageBox::critical(nullptr, "还原失败",
-            QString("写入设置文件失败：\n%1").arg(deployError.isEmpty() ? "未知错误" : deployError));
+        if (!cancelled) {
+            QMessageBox::critical(nullptr, "还原失败",
+                QString("读取快照数据时出错：\n%1").arg(restoreError.isEmpty() ? "未知错误" : restoreError));
+        }
+        return;
+    }
+
+    restoreFromBackupDirectory(bundleDir);
+}
+
+void FenceManager::onSnapshotVerifyRequested()
+{
+    BackupStore store(ConfigManager::instance()->backupStorePath());
+    const QString snapshotId = chooseSnapshot(store, "校验快照", "选择要校验的快照：");
+    if (snapshotId.isEmpty()) return;
+
+    QStringList problems;
+    QString verifyError;
+    bool cancelled = false;
+    const bool ok = runWithProgress("校验快照", "正在校验快照数据…",
+        [&store, &snapshotId, &problems, &verifyError](const BackupStore::Progress &progress) {
+            return store.verify(snapshotId, progress, &problems, &verifyError);
+        }, &cancelled);
+
+    if (!ok) {
+        if (!cancelled) {
+            QMessageBox::critical(nullptr, "校验失败",
+                QString("校验快照时出错：\n%1").arg(verifyError.isEmpty() ? "未知错误" : verifyError));
+        }
+        return;
+    }
+
+    if (problems.isEmpty()) {
+        QMessageBox::information(nullptr, "校验完成", "快照数据完整，所有数据块均与记录一致。");
+        return;
+    }
+
+    const int shown = qMin(problems.size(), 10);
+    QString message = QString("发现 %1 个文件损坏或缺失：\n%2")
+        .arg(problems.size())
+        .arg(QStringList(problems.mid(0, shown)).join("\n"));
+    if (problems.size() > shown) {
+        message += QString("\n……另有 %1 项").arg(problems.size() - shown);
+    }
+    QMessageBox::warning(nullptr, "校验完成", message);
+}
+
+// 以最新一份增量快照记录的文件哈希为基准，并行检查当前图标存储目录，列出此后被修改、丢失或新增的文件
+void FenceManager::onStorageVerifyRequested()
+{
+    BackupStore store(ConfigManager::instance()->backupStorePath());
+    const QList<BackupStore::Snapshot> snapshots = store.snapshots();
+    if (snapshots.isEmpty()) {
+        QMessageBox::information(nullptr, "校验图标存储", "增量备份库中还没有快照，请先创建一份增量备份。");
+        return;
+    }
+
+    ContentManifest manifest;
+    QString verifyError;
+    if (!store.contentManifest(snapshots.first().id, &manifest, &verifyError)) {
+        QMessageBox::warning(nullptr, "校验图标存储", verifyError);
+        return;
+    }
+
+    ContentManifest::Report report;
+    bool cancelled = false;
+    const QString storagePath = ConfigManager::instance()->fencesStoragePath();
+    if (!verifyWithProgress("校验图标存储", manifest, storagePath, "fences_storage", &report, &cancelled, &verifyError)) {
+        if (!cancelled) {
+            QMessageBox::critical(nullptr, "校验失败",
+                QString("校验图标存储时出错：\n%1").arg(verifyError.isEmpty() ? "未知错误" : verifyError));
+        }
+        return;
+    }
+
+    const QString basis = QString("以 %1 的增量快照为基准。\n")
+        .arg(snapshots.first().created.toString("yyyy-MM-dd HH:mm:ss"));
+    if (report.isClean()) {
+        QMessageBox::information(nullptr, "校验完成", basis + "图标存储与快照完全一致。\n" + describeVerifyReport(report));
+    } else {
+        QMessageBox::warning(nullptr, "校验完成", basis + "以下文件在快照之后发生了变化：\n\n" + describeVerifyReport(report));
+    }
+}
+
+void FenceManager::onSnapshotPruneRequested()
+{
+    BackupStore store(ConfigManager::instance()->backupStorePath());
+    const int snapshotCount = store.snapshots().size();
+    if (snapshotCount == 0) {
+        QMessageBox::information(nullptr, "清理旧快照", "增量备份库中还没有快照。");
         return;
     }
 
-    QMessageBox::information(nullptr, "还原成功",
-        "围栏数据已成功还原！\n应用即将重启以加载新数据。");
+    bool ok = false;
+    const int keepCount = QInputDialog::getInt(nullptr, "清理旧快照",
+        QString("当前共有 %1 份快照。保留最新的几份？").arg(snapshotCount),
+        qMin(snapshotCount, 10), 1, snapshotCount, 1, &ok);
+    if (!ok) return;
+
+    int removedSnapshots = 0;
+    qint64 freedBytes = 0;
+    QString pruneError;
+    if (!store.prune(keepCount, &removedSnapshots, &freedBytes, &pruneError)) {
+        QMessageBox::critical(nullptr, "清理失败",
+            QString("清理旧快照时出错：\n%1").arg(pruneError.isEmpty() ? "未知错误" : pruneError));
+        return;
+    }
 
-    // ⚠️  关键：不能调用 shutdown()！
-    //
-    // shutdown() 内部会调用 ConfigManager::sync()，把当前内存中的
-    // 旧围栏数据写回磁盘，从而覆盖掉刚刚解压好的 fencing_config.json。
-    // 修复方案：直接设置 m_isShutdown 旗标，阻止任何待定保存写入，
-    // 然后隐藏托盘图标，启动新进程后让当前进程直接退出即可。
-    //
-    // 进程退出时操作系统会自动回收所有窗口/句柄，无需手动 close()。
+    QMessageBox::information(nullptr, "清理完成",
+        QString("已删除 %1 份快照，释放 %2。").arg(removedSnapshots).arg(formatBytes(freedBytes)));
+}
+
+// ─────────────────────────────────────────────────────────────────
+// 定时自动快照
+// 每分钟检查一次：距上一份已满设定间隔、且没有拖动或图标文件移动时，在后台创建一份硬链接快照并按档清理旧快照
+// ─────────────────────────────────────────────────────────────────
+void FenceManager::setupAutoSnapshots()
+{
+    if (ConfigManager::instance()->autoSnapshotIntervalMinutes() <= 0) return;
 
-    m_isShutdown = true; // 阻止任何后续的自动保存
+    const QList<AutoSnapshots::Snapshot> existing =
+        AutoSnapshots(ConfigManager::instance()->autoSnapshotPath()).snapshots();
+    if (!existing.isEmpty()) {
+        m_lastAutoSnapshot = existing.first().created;
+    }
 
-    // 停止所有围栏的待定保存定时器
-    // 注意：不调用 flushPendingSave()，因为它会 emit geometryChanged()
-    // 触发 saveFences() 更新 m_fencesData，有潜在覆盖风险。
-    // 此处只需停止定时器，阻止任何写盘动作即可。
+    m_autoSnapshotTimer = new QTimer(this);
+    m_autoSnapshotTimer->setInterval(kAutoSnapshotCheckIntervalMs);
+    connect(m_autoSnapshotTimer, &QTimer::timeout, this, &FenceManager::onAutoSnapshotTimer);
+    m_autoSnapshotTimer->start();
+}
+
+bool FenceManager::isUserInteracting() const
+{
+    // 拖动图标时 QDrag::exec 的事件循环中定时器照常触发，以鼠标键是否按下判断
+    if (QGuiApplication::mouseButtons() != Qt::NoButton) {
+        return true;
+    }
     for (FenceWindow *fence : m_fences) {
-        if (fence) fence->stopSaveTimer(); // 只停计时器，不触发保存
+        if (fence && fence->isInteracting()) {
+            return true;
+        }
     }
+    return false;
+}
 
-    // 隐藏托盘图标（让任务栏立即干净）
-    if (m_trayIcon) {
-        m_trayIcon->hide();
+void FenceManager::onAutoSnapshotTimer()
+{
+    const int intervalMinutes = ConfigManager::instance()->autoSnapshotIntervalMinutes();
+    if (m_isShutdown || m_restoreInProgress || intervalMinutes <= 0 || m_autoSnapshotTask.isRunning()) return;
+    if (m_lastAutoSnapshot.isValid()
+        && m_lastAutoSnapshot.secsTo(QDateTime::currentDateTime()) < qint64(intervalMinutes) * 60) {
+        return;
     }
+    // 拖动或图标文件移动进行中时推迟到下一次检查，避免拍到移动了一半的存储目录
+    if (isUserInteracting() || !FileOperationQueue::instance()->isIdle()) return;
+
+    // 布局取内存中的最新状态，不必等增量日志合并
+    saveFences();
+    const QByteArray fencesJson = QJsonDocument(ConfigManager::instance()->fencesData()).toJson(QJsonDocument::Compact);
+    const QString settingsPath = appDataDirectory() + "/user_settings.ini";
+    const QString storageDir = ConfigManager::instance()->fencesStoragePath();
+    const QString rootPath = ConfigManager::instance()->autoSnapshotPath();
+    m_lastAutoSnapshot = QDateTime::currentDateTime();
+
+    // 存储目录在后台扫描，晚于布局的取值：期间有任何文件操作提交，两者就可能对不上，放弃本次快照
+    const quint64 operationsAtCapture = FileOperationQueue::instance()->submittedCount();
+    const auto consistent = [operationsAtCapture]() {
+        return FileOperationQueue::instance()->submittedCount() == operationsAtCapture;
+    };
 
-    // 启动新实例
-    QString appExe = QCoreApplication::applicationFilePath();
-    QProcess::startDetached(appExe, QStringList());
+    m_autoSnapshotTask = QtConcurrent::run([this, fencesJson, settingsPath, storageDir, rootPath, consistent]() {
+        AutoSnapshots snapshots(rootPath);
+        QString snapshotId;
+        AutoSnapshots::Stats stats;
+        bool unchanged = false;
+        QString error;
+        if (!snapshots.create(fencesJson, settingsPath, storageDir, consistent, &snapshotId, &stats, &unchanged, &error)) {
+            LOG_WARN(Logger::Config, "[AutoSnapshots] Snapshot failed: " + error);
+            if (!consistent()) {
+                // 因文件操作放弃的快照在下一次检查时重拍，不必等满一个间隔
+                QMetaObject::invokeMethod(this, [this]() { m_lastAutoSnapshot = QDateTime(); }, Qt::QueuedConnection);
+            }
+            return;
+        }
+        if (unchanged) {
+            LOG_DEBUG(Logger::Config, "[AutoSnapshots] No changes since last snapshot");
+            return;
+        }
+        const int removed = snapshots.prune(AutoSnapshots::Retention());
+        LOG_INFO(Logger::Config, QString("[AutoSnapshots] Created %1: %2 files, %3 linked, %4 bytes copied; pruned %5")
+            .arg(snapshotId).arg(stats.fileCount).arg(stats.linkedFiles).arg(stats.copiedBytes).arg(removed));
+    });
+}
 
-    // 直接退出，不写任何数据到磁盘
-    QApplication::quit();
+void FenceManager::onAutoSnapshotRestoreRequested()
+{
+    // 等后台快照结束，列表中不会出现正被清理的快照；还原结束前不再拍新的
+    const QScopedValueRollback<bool> restoring(m_restoreInProgress, true);
+    m_autoSnapshotTask.waitForFinished();
+
+    const QString title = "从自动快照还原";
+    AutoSnapshots snapshots(ConfigManager::instance()->autoSnapshotPath());
+    const QList<AutoSnapshots::Snapshot> all = snapshots.snapshots();
+    if (all.isEmpty()) {
+        QMessageBox::information(nullptr, title, "还没有自动快照。");
+        return;
+    }
+
+    QStringList items;
+    for (const AutoSnapshots::Snapshot &snapshot : all) {
+        items.append(snapshot.created.toString("yyyy-MM-dd HH:mm:ss"));
+    }
+    const int row = chooseRow(title, "选择要还原的自动快照：", items);
+    if (row < 0) return;
+    const QString snapshotId = all.at(row).id;
+
+    int ret = QMessageBox::warning(
+        nullptr,
+        "确认还原",
+        "还原操作将覆盖当前所有围栏数据。\n\n确定要继续吗？",
+        QMessageBox::Yes | QMessageBox::No,
+        QMessageBox::No
+    );
+    if (ret != QMessageBox::Yes) return;
+
+    ConfigManager::instance()->stopSave();
+
+    // 临时目录与 fences_storage 放在同一目录下，还原时存储目录才能直接改名替换
+    QTemporaryDir extractDir(appDataDirectory() + "/restore-XXXXXX");
+    if (!extractDir.isValid()) {
+        ConfigManager::instance()->resumeSave();
+        QMessageBox::critical(nullptr, "还原失败", "无法创建临时还原目录。");
+        return;
+    }
+
+    // 复制而不是链接：还原后的存储文件被修改时不能改动快照
+    QString copyError;
+    bool cancelled = false;
+    const QString bundleDir = extractDir.path();
+    const bool copied = runWithProgress(title, "正在取出快照数据…",
+        [&snapshots, &snapshotId, &bundleDir, &copyError](const AutoSnapshots::Progress &progress) {
+            return snapshots.copyTo(snapshotId, bundleDir, progress, &copyError);
+        }, &cancelled);
+
+    if (!copied) {
+        ConfigManager::instance()->resumeSave();
+        if (!cancelled) {
+            QMessageBox::critical(nullptr, "还原失败",
+                QString("读取自动快照时出错：\n%1").arg(copyError.isEmpty() ? "未知错误" : copyError));
+        }
+        return;
+    }
+
+    restoreFromBackupDirectory(bundleDir);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -6,8 +6,14 @@
 #include <QSystemTrayIcon>
 #include <QMenu>
 #include <QSet>
+#include <QVector>
+#include <QPair>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QFuture>
 
 class FenceWindow;
+class QTimer;
 
 /**
  * @brief 围栏管理器
@@ -43,6 +49,14 @@ private slots:
     void onExitRequested();
     void onBackupFencesRequested();
     void onRestoreFencesRequested();
+    void onVerifyBackupRequested();
+    void onSnapshotBackupRequested();
+    void onSnapshotRestoreRequested();
+    void onSnapshotVerifyRequested();
+    void onStorageVerifyRequested();
+    void onSnapshotPruneRequested();
+    void onAutoSnapshotRestoreRequested();
+    void onAutoSnapshotTimer();
     void onScreenConfigChanged();   // 显示器配置变化（接入/断开/分辨率改变）
 
 protected:
@@ -57,12 +71,26 @@ private:
     QPoint getNewFencePosition() const;
     void attachFence(FenceWindow *fence);
     bool recoverOrphanedStorage(const QJsonObject &data);
+    void restoreFromBackupDirectory(const QString &bundleDir);
+    void setupAutoSnapshots();
+    // 正在拖动围栏或图标（此时不拍自动快照）
+    bool isUserInteracting() const;
+    void applyRestoredFences(const QJsonObject &data);
 
     QList<FenceWindow*> m_fences;
+    // 上次写入 ConfigManager 时各围栏的序列化版本号（按围栏顺序）
+    QVector<QPair<FenceWindow*, quint64>> m_savedRevisions;
     QSystemTrayIcon *m_trayIcon;
     QMenu *m_trayMenu;
     bool m_fencesVisible = true;
     bool m_isShutdown = false;
+
+    // 自动快照：定时检查，到期且空闲时在后台创建
+    QTimer *m_autoSnapshotTimer = nullptr;
+    QFuture<void> m_autoSnapshotTask;
+    QDateTime m_lastAutoSnapshot;
+    // 还原流程进行中（含选择、解压等对话框期间），不拍自动快照
+    bool m_restoreInProgress = false;
 };
 
 #endif // FENCEMANAGER_H
@@ -0,0 +1,536 @@
+#include "fileoperationqueue.h"
+#include "logger.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QPointer>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+namespace {
+
+const char *kJournalId = "file-operations";
+// 复制中的临时文件，复制完成后改名为目标文件
+const char *kPartSuffix = ".deskgo-part";
+// 目标位置原有的同名文件，操作成功后删除，失败或回滚时还原
+const char *kReplacedSuffix = ".deskgo-replaced";
+
+QString pathKey(const QString &path)
+{
+    return QDir::toNativeSeparators(QDir::cleanPath(path)).toCaseFolded();
+}
+
+bool pathExists(const QString &path)
+{
+    if (QFileInfo::exists(path)) {
+        return true;
+    }
+#ifdef Q_OS_WIN
+    // 部分中文文件名被占用时 QFileInfo 会误报不存在
+    const std::wstring wPath = QDir::toNativeSeparators(path).toStdWString();
+    return GetFileAttributesW(wPath.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+    return false;
+#endif
+}
+
+// 只做同卷改名，不隐式复制
+bool renameFile(const QString &source, const QString &destination)
+{
+#ifdef Q_OS_WIN
+    const std::wstring wSrc = QDir::toNativeSeparators(source).toStdWString();
+    const std::wstring wDst = QDir::toNativeSeparators(destination).toStdWString();
+    return MoveFileExW(wSrc.c_str(), wDst.c_str(), MOVEFILE_WRITE_THROUGH);
+#else
+    return QFile::rename(source, destination);
+#endif
+}
+
+bool moveFile(const QString &source, const QString &destination, QString *errorMessage)
+{
+    if (!pathExists(source)) {
+        *errorMessage = "source file not found";
+        return false;
+    }
+    QDir().mkpath(QFileInfo(destination).absolutePath());
+
+    if (renameFile(source, destination)) {
+        return true;
+    }
+
+    // 跨卷（或改名被拒绝）：复制到临时文件再改名，目标路径上不会出现不完整的文件
+    const QString part = destination + kPartSuffix;
+    QFile::remove(part);
+    bool copied = QFile::copy(source, part);
+#ifdef Q_OS_WIN
+    if (!copied) {
+        // Qt 复制偶尔报 "Unknown error"（权限/锁定），原生接口通常可以成功
+        const std::wstring wSrc = QDir::toNativeSeparators(source).toStdWString();
+        const std::wstring wPart = QDir::toNativeSeparators(part).toStdWString();
+        copied = CopyFileW(wSrc.c_str(), wPart.c_str(), FALSE);
+    }
+#endif
+    if (!copied) {
+        QFile::remove(part);
+        *errorMessage = "copy failed";
+        return false;
+    }
+    if (!renameFile(part, destination)) {
+        QFile::remove(part);
+        *errorMessage = "failed to rename copied file";
+        return false;
+    }
+    if (!QFile::remove(source)) {
+        // 源文件被占用：撤销复制，保持源文件原样
+        QFile::remove(destination);
+        *errorMessage = "source file is in use";
+        return false;
+    }
+    return true;
+}
+
+QJsonObject makeRecord(const QString &op, quint64 transaction, int index = -1)
+{
+    QJsonObject record;
+    record["op"] = op;
+    record["txn"] = static_cast<qint64>(transaction);
+    if (index >= 0) {
+        record["index"] = index;
+    }
+    return record;
+}
+
+QString operationKey(const QJsonObject &record)
+{
+    return QString("%1:%2").arg(record.value("txn").toVariant().toLongLong()).arg(record.value("index").toInt());
+}
+
+// 按布局的实际状态把一个未确认的操作补完（applied）或撤销
+void recoverOperation(const QJsonObject &begin, bool applied)
+{
+    const QString source = begin.value("source").toString();
+    const QString destination = begin.value("destination").toString();
+    const bool replaced = begin.value("replaced").toBool();
+    const QString backup = destination + kReplacedSuffix;
+    QFile::remove(destination + kPartSuffix);
+
+    // 目标位置的文件是否仍是操作前就存在的那个（备份改名之前就中断了）
+    const bool destinationIsOriginal = replaced && !pathExists(backup);
+    QString error;
+
+    if (applied) {
+        if (pathExists(source)) {
+            if (!pathExists(destination)) {
+                moveFile(source, destination, &error);
+            } else if (destinationIsOriginal) {
+                if (renameFile(destination, backup)) {
+                    moveFile(source, destination, &error);
+                }
+            } else {
+                // 复制已完成，只差删除源文件
+                QFile::remove(source);
+            }
+        }
+        QFile::remove(backup);
+        LOG_WARN(Logger::Fence, "[FileOperationQueue] Recovered (roll forward): " + source + " -> " + destination
+                                    + (error.isEmpty() ? QString() : " error: " + error));
+        return;
+    }
+
+    if (!pathExists(source)) {
+        if (pathExists(destination) && !destinationIsOriginal) {
+            moveFile(destination, source, &error);
+        }
+    } else if (pathExists(destination) && !destinationIsOriginal) {
+        QFile::remove(destination);
+    }
+    if (pathExists(backup) && !pathExists(destination)) {
+        renameFile(backup, destination);
+    }
+    LOG_WARN(Logger::Fence, "[FileOperationQueue] Recovered (roll back): " + destination + " -> " + source
+                                + (error.isEmpty() ? QString() : " error: " + error));
+}
+
+} // namespace
+
+FileOperationQueue *FileOperationQueue::instance()
+{
+    static FileOperationQueue *queue = new FileOperationQueue();
+    return queue;
+}
+
+FileOperationQueue::FileOperationQueue(QObject *parent)
+    : QObject(parent)
+{
+    // 同一时间只移动一个文件：操作之间可能互相依赖（移入后又移出），并发也不会让磁盘更快
+    m_pool.setMaxThreadCount(1);
+    m_pool.setExpiryTimeout(10000);
+}
+
+FileOperationQueue::~FileOperationQueue()
+{
+    shutdown();
+}
+
+void FileOperationQueue::setJournalPath(const QString &path)
+{
+    QMutexLocker locker(&m_journalMutex);
+    m_journal.setPath(path);
+    m_journalReady = false;
+}
+
+int FileOperationQueue::recover(const QStringList &referencedPaths)
+{
+    QMutexLocker locker(&m_journalMutex);
+
+    QList<QJsonObject> records;
+    const FenceJournal::ReplayResult result = m_journal.read(kJournalId, &records);
+    if (result == FenceJournal::ReplayResult::IOError) {
+        LOG_WARN(Logger::Fence, "[FileOperationQueue] Failed to read journal: " + m_journal.path());
+        return 0;
+    }
+
+    QSet<qint64> acknowledged;
+    QSet<QString> finished;
+    for (const QJsonObject &record : qAsConst(records)) {
+        const QString op = record.value("op").toString();
+        if (op == "ack") {
+            acknowledged.insert(record.value("txn").toVariant().toLongLong());
+        } else if (op == "abort") {
+            // 执行时已自行回滚
+            finished.insert(operationKey(record));
+        }
+    }
+
+    QSet<QString> referenced;
+    for (const QString &path : referencedPaths) {
+        referenced.insert(pathKey(path));
+    }
+
+    int recovered = 0;
+    for (const QJsonObject &record : qAsConst(records)) {
+        if (record.value("op").toString() != "begin"
+            || acknowledged.contains(record.value("txn").toVariant().toLongLong())
+            || finished.contains(operationKey(record))) {
+            continue;
+        }
+        const bool applied = record.value("rule").toString() == "source"
+            ? !referenced.contains(pathKey(record.value("source").toString()))
+            : referenced.contains(pathKey(record.value("destination").toString()));
+        recoverOperation(record, applied);
+        ++recovered;
+    }
+
+    m_journalReady = m_journal.reset(kJournalId);
+    if (recovered > 0) {
+        LOG_INFO(Logger::Fence, QString("[FileOperationQueue] Recovered %1 unacknowledged operation(s)").arg(recovered));
+    }
+    return recovered;
+}
+
+quint64 FileOperationQueue::submit(QObject *owner, const QList<Operation> &operations,
+                                   std::function<void(const Result &)> operationDone,
+                                   std::function<void(int committed, int failed)> finished)
+{
+    if (operations.isEmpty()) {
+        return 0;
+    }
+
+    // 回调只在 owner 仍存在时执行（送达时已回到 GUI 线程）
+    const QPointer<QObject> guard(owner);
+    Transaction transaction;
+    transaction.owner = owner;
+    transaction.operations = operations;
+    transaction.operationDone = [guard, operationDone](const Result &result) {
+        if (guard && operationDone) {
+            operationDone(result);
+        }
+    };
+    transaction.finished = [guard, finished](int committed, int failed) {
+        if (guard && finished) {
+            finished(committed, failed);
+        }
+    };
+
+    QMutexLocker locker(&m_mutex);
+    if (m_shuttingDown) {
+        return 0;
+    }
+    transaction.id = ++m_nextTransaction;
+    m_transactions.enqueue(transaction);
+    if (!m_workerActive) {
+        m_workerActive = true;
+        m_pool.start([this]() { drain(); });
+    }
+    return transaction.id;
+}
+
+bool FileOperationQueue::runNow(const Operation &operation, quint64 *transaction, QString *errorMessage)
+{
+    // 先让已提交的事务执行完，避免与其中的操作交错
+    m_pool.waitForDone();
+
+    quint64 id = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        id = ++m_nextTransaction;
+        m_unacknowledged.insert(id, nullptr);
+    }
+    *transaction = id;
+
+    const Result result = execute(id, 0, operation);
+    if (!result.committed) {
+        acknowledge(id);
+        if (errorMessage) {
+            *errorMessage = result.error;
+        }
+    }
+    return result.committed;
+}
+
+void FileOperationQueue::acknowledge(quint64 transaction)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_unacknowledged.remove(transaction) && !m_retired.remove(transaction)) {
+            return;
+        }
+    }
+    appendRecord(makeRecord("ack", transaction));
+    resetJournalIfIdle();
+}
+
+void FileOperationQueue::retire(quint64 transaction)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_unacknowledged.remove(transaction)) {
+        m_retired.insert(transaction);
+        LOG_WARN(Logger::Fence, QString("[FileOperationQueue] Transaction %1 left for startup recovery").arg(transaction));
+    }
+}
+
+quint64 FileOperationQueue::submittedCount()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_nextTransaction;
+}
+
+bool FileOperationQueue::isIdle()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_transactions.isEmpty() && !m_workerActive && m_unacknowledged.isEmpty();
+}
+
+void FileOperationQueue::cancel(QObject *owner)
+{
+    QMutexLocker locker(&m_mutex);
+    discardQueued(owner);
+    if (m_runningOwner == owner) {
+        m_runningCancelled = true;
+    }
+    // 结果不会再由 owner 写入布局
+    for (auto it = m_unacknowledged.begin(); it != m_unacknowledged.end();) {
+        if (owner && it.value() == owner) {
+            m_retired.insert(it.key());
+            it = m_unacknowledged.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FileOperationQueue::settle(QObject *owner)
+{
+    QMutexLocker locker(&m_mutex);
+    discardQueued(owner);
+    if (m_runningOwner == owner) {
+        m_runningCancelled = true;
+    }
+
+    const auto pending = [this, owner]() {
+        if (m_runningOwner == owner) {
+            return true;
+        }
+        for (const Transaction &transaction : qAsConst(m_transactions)) {
+            if (transaction.owner == owner) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (;;) {
+        while (pending()) {
+            m_runningChanged.wait(&m_mutex);
+        }
+        locker.unlock();
+        // 结果以排队调用的形式送往 GUI 线程，这里立即处理；回调中可能再次提交事务
+        QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+        locker.relock();
+        if (!pending()) {
+            return;
+        }
+    }
+}
+
+void FileOperationQueue::discardQueued(QObject *owner)
+{
+    for (auto it = m_transactions.begin(); it != m_transactions.end();) {
+        if (it->owner == owner) {
+            it = m_transactions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FileOperationQueue::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_shuttingDown = true;
+        m_transactions.clear();
+    }
+    m_pool.waitForDone();
+}
+
+void FileOperationQueue::drain()
+{
+    for (;;) {
+        Transaction transaction;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_transactions.isEmpty() || m_shuttingDown) {
+                m_workerActive = false;
+                break;
+            }
+            transaction = m_transactions.dequeue();
+            m_runningOwner = transaction.owner;
+            m_runningCancelled = false;
+            m_unacknowledged.insert(transaction.id, transaction.owner);
+        }
+
+        const int total = transaction.operations.size();
+        int committed = 0;
+        int failed = 0;
+        for (int i = 0; i < total; ++i) {
+            {
+                QMutexLocker locker(&m_mutex);
+                if (m_runningCancelled || m_shuttingDown) {
+                    break;
+                }
+            }
+
+            Result result = execute(transaction.id, i, transaction.operations.at(i));
+            if (result.committed) {
+                ++committed;
+            } else {
+                ++failed;
+            }
+            result.done = committed + failed;
+            result.total = total;
+
+            const std::function<void(const Result &)> done = transaction.operationDone;
+            QMetaObject::invokeMethod(this, [done, result]() { done(result); }, Qt::QueuedConnection);
+        }
+
+        if (committed == 0) {
+            // 没有文件被移动，布局无需更新
+            acknowledge(transaction.id);
+        }
+
+        const std::function<void(int, int)> finished = transaction.finished;
+        QMetaObject::invokeMethod(this, [finished, committed, failed]() {
+            finished(committed, failed);
+        }, Qt::QueuedConnection);
+
+        // 结束回调投递之后再通知 settle()，保证它能一并送达
+        {
+            QMutexLocker locker(&m_mutex);
+            m_runningOwner = nullptr;
+            m_runningChanged.wakeAll();
+        }
+    }
+}
+
+FileOperationQueue::Result FileOperationQueue::execute(quint64 transaction, int index, const Operation &operation)
+{
+    Result result;
+    result.index = index;
+    result.source = operation.source;
+    result.destination = operation.destination;
+
+    if (pathKey(operation.source) == pathKey(operation.destination)) {
+        result.committed = true;
+        return result;
+    }
+
+    const bool replacing = pathExists(operation.destination);
+    QJsonObject begin = makeRecord("begin", transaction, index);
+    begin["source"] = operation.source;
+    begin["destination"] = operation.destination;
+    begin["rule"] = operation.rule == Operation::SourceUnreferenced ? "source" : "destination";
+    begin["replaced"] = replacing;
+
+    // 日志写不进去就不动文件，否则崩溃后无从恢复
+    if (!appendRecord(begin)) {
+        result.error = "failed to write file operation journal";
+        LOG_WARN(Logger::Fence, "[FileOperationQueue] " + result.error + ": " + m_journal.path());
+        return result;
+    }
+
+    const QString backup = operation.destination + kReplacedSuffix;
+    if (replacing) {
+        QFile::remove(backup);
+        if (!renameFile(operation.destination, backup)) {
+            result.error = "destination file is in use";
+        }
+    }
+
+    if (result.error.isEmpty()) {
+        result.committed = moveFile(operation.source, operation.destination, &result.error);
+        if (replacing) {
+            if (result.committed) {
+                QFile::remove(backup);
+            } else {
+                renameFile(backup, operation.destination);
+            }
+        }
+    }
+
+    appendRecord(makeRecord(result.committed ? "commit" : "abort", transaction, index));
+    if (result.committed) {
+        LOG_DEBUG(Logger::Fence, "[FileOperationQueue] Moved " + operation.source + " -> " + operation.destination);
+    } else {
+        LOG_WARN(Logger::Fence, "[FileOperationQueue] Failed to move " + operation.source + " -> "
+                                    + operation.destination + ": " + result.error);
+    }
+    return result;
+}
+
+bool FileOperationQueue::appendRecord(const QJsonObject &record)
+{
+    QMutexLocker locker(&m_journalMutex);
+    if (!m_journalReady) {
+        m_journalReady = m_journal.reset(kJournalId);
+    }
+    return m_journalReady && m_journal.append({record});
+}
+
+void FileOperationQueue::resetJournalIfIdle()
+{
+    // 持有日志锁再检查：工作线程登记新事务后必须先拿到日志锁才能写 begin，不会被这里清掉
+    QMutexLocker journalLocker(&m_journalMutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_unacknowledged.isEmpty() || !m_retired.isEmpty()) {
+            return;
+        }
+    }
+    m_journalReady = m_journal.reset(kJournalId);
+}
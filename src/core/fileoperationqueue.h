@@ -0,0 +1,135 @@
+#ifndef FILEOPERATIONQUEUE_H
+#define FILEOPERATIONQUEUE_H
+
+#include "fencejournal.h"
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <functional>
+
+/**
+ * @brief 图标文件移动队列（桌面 <-> 围栏存储目录、围栏之间）
+ * 一次拖放/移除提交为一个事务，由单个后台线程按顺序执行，不阻塞 GUI 线程。
+ *
+ * 每个操作在动文件之前先把 begin 记录写入日志并落盘，完成后记 commit / abort；
+ * 调用方把结果写入围栏布局并 sync 成功后调用 acknowledge()。
+ * 程序在事务确认前崩溃时，下次启动由 recover() 对照已保存的布局决定每个操作前滚还是回滚，
+ * 保证文件要么在布局引用的位置，要么回到原处，不会丢失。
+ *
+ * 复制时先写到目标旁的临时文件再改名，目标路径上不会出现半个文件；
+ * 目标已存在时先改名备份，操作失败时还原。
+ */
+class FileOperationQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Operation {
+        // 崩溃恢复时如何判断该操作已反映到布局中
+        enum CommitRule {
+            DestinationReferenced, // 布局引用了 destination（文件移入围栏）
+            SourceUnreferenced     // 布局不再引用 source（文件移出围栏）
+        };
+
+        QString source;
+        QString destination;
+        CommitRule rule = DestinationReferenced;
+    };
+
+    struct Result {
+        int index = -1;      // 在事务中的下标
+        QString source;
+        QString destination;
+        bool committed = false;
+        QString error;
+        int done = 0;        // 事务中已完成（含失败）的操作数
+        int total = 0;
+    };
+
+    static FileOperationQueue *instance();
+
+    void setJournalPath(const QString &path);
+
+    // 启动时、加载围栏之前调用：referencedPaths 为已保存布局中引用的全部图标路径。
+    // 返回处理的未确认操作数
+    int recover(const QStringList &referencedPaths);
+
+    // operationDone 按完成顺序对每个操作调用一次，finished 在整个事务结束后调用；
+    // 两者都在 GUI 线程中执行，owner 已销毁时不再调用。返回事务 id，没有操作时返回 0
+    quint64 submit(QObject *owner, const QList<Operation> &operations,
+                   std::function<void(const Result &)> operationDone,
+                   std::function<void(int committed, int failed)> finished);
+
+    // 在当前线程中同步执行（同样写日志），用于调用方必须等待文件就位的场景（如删除围栏）。
+    // 会先等待队列中已提交的事务执行完
+    bool runNow(const Operation &operation, quint64 *transaction, QString *errorMessage = nullptr);
+
+    // 事务结果已写入布局并持久化
+    void acknowledge(quint64 transaction);
+
+    // 事务结果未能持久化（sync 失败、回滚未完成等）：不再等待确认，
+    // begin 记录保留在日志中，由下次启动时的 recover() 对照布局处理
+    void retire(quint64 transaction);
+
+    // 迄今提交过的事务数（只增不减），前后两次取值不同说明期间有文件操作发生
+    quint64 submittedCount();
+
+    // 没有排队、执行中或等待确认的事务（还原备份等需要独占存储目录的操作前检查）。
+    // 已放弃确认的事务不计入
+    bool isIdle();
+
+    // 对象销毁时调用：丢弃其尚未开始的事务，执行中的事务在当前操作完成后停止、结果不再送达；
+    // 其已执行未确认的事务转为放弃确认，留给下次启动时恢复
+    void cancel(QObject *owner);
+
+    // 删除围栏前调用：丢弃其尚未开始的事务，等待执行中的事务停止，
+    // 并立即把已产生的结果送达 owner（包括回调中再提交的事务，如回滚），返回时不再有该对象的文件操作
+    void settle(QObject *owner);
+
+    // 丢弃尚未开始的事务并等待执行中的操作结束（程序退出前调用）
+    void shutdown();
+
+private:
+    explicit FileOperationQueue(QObject *parent = nullptr);
+    ~FileOperationQueue() override;
+
+    struct Transaction {
+        quint64 id = 0;
+        QObject *owner = nullptr;
+        QList<Operation> operations;
+        std::function<void(const Result &)> operationDone;
+        std::function<void(int, int)> finished;
+    };
+
+    void drain();
+    // 调用方持有 m_mutex
+    void discardQueued(QObject *owner);
+    Result execute(quint64 transaction, int index, const Operation &operation);
+    bool appendRecord(const QJsonObject &record);
+    // 所有事务都已确认时清空日志，避免无限增长
+    void resetJournalIfIdle();
+
+    QMutex m_mutex;
+    QQueue<Transaction> m_transactions;
+    QHash<quint64, QObject *> m_unacknowledged; // 已开始执行、尚未确认的事务 -> owner
+    QSet<quint64> m_retired;                    // 已放弃确认，日志需保留到下次启动
+    quint64 m_nextTransaction = 0;
+    QObject *m_runningOwner = nullptr;
+    bool m_runningCancelled = false;
+    QWaitCondition m_runningChanged; // 执行中的事务结束
+    bool m_workerActive = false;
+    bool m_shuttingDown = false;
+
+    QMutex m_journalMutex;
+    FenceJournal m_journal;
+    bool m_journalReady = false;
+
+    QThreadPool m_pool;
+};
+
+#endif // FILEOPERATIONQUEUE_H
@@ -0,0 +1,397 @@
+#include "iconcache.h"
+#include "logger.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QReadLocker>
+#include <QSaveFile>
+#include <QWriteLocker>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = { 'D', 'G', 'I', 'C' };
+const quint32 kVersion = 1;
+const qint64 kHeaderSize = 32;
+const int kIndexFixedSize = 32; // 键之后的固定字段长度
+const int kMaxDimension = 1024;
+
+quint64 align16(quint64 value)
+{
+    return (value + 15) & ~quint64(15);
+}
+
+} // namespace
+
+IconCache *IconCache::instance()
+{
+    static IconCache cache;
+    return &cache;
+}
+
+IconCache::~IconCache()
+{
+    unmapFile();
+}
+
+QString IconCache::normalizedPath(const QString &path)
+{
+    // Windows 文件系统不区分大小写
+    return QDir::toNativeSeparators(QDir::cleanPath(path)).toLower();
+}
+
+IconCache::Key IconCache::makeKey(const QString &path, int pixelSize)
+{
+    Key key;
+    const QFileInfo info(path);
+    if (path.isEmpty() || !info.exists()) {
+        return key;
+    }
+
+    key.path = normalizedPath(info.absoluteFilePath());
+    key.id = key.path + QLatin1Char('|') + QString::number(pixelSize);
+    key.mtime = info.lastModified().toMSecsSinceEpoch();
+    key.fileSize = info.size();
+    key.pixelSize = pixelSize;
+    return key;
+}
+
+void IconCache::open(const QString &packPath)
+{
+    QWriteLocker locker(&m_mapLock);
+    unmapFile();
+    m_path = packPath;
+    if (mapFile()) {
+        LOG_INFO(Logger::Icon, QString("[IconCache] Mapped %1 entries from %2")
+                                   .arg(m_entries.size())
+                                   .arg(m_path));
+    }
+}
+
+void IconCache::close()
+{
+    QWriteLocker locker(&m_mapLock);
+    unmapFile();
+}
+
+bool IconCache::mapFile()
+{
+    m_file.setFileName(m_path);
+    if (!m_file.exists() || !m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    uchar *data = size >= kHeaderSize ? m_file.map(0, size) : nullptr;
+    if (!data) {
+        m_file.close();
+        return false;
+    }
+
+    auto fail = [this, data](const char *reason) {
+        LOG_WARN(Logger::Icon, QString("[IconCache] Discarding cache file %1: %2").arg(m_path, reason));
+        m_file.unmap(data);
+        m_file.close();
+        m_entries.clear();
+        m_index.clear();
+        return false;
+    };
+
+    if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || qFromLittleEndian<quint32>(data + 4) != kVersion) {
+        return fail("bad header");
+    }
+
+    const quint32 entryCount = qFromLittleEndian<quint32>(data + 8);
+    const quint64 indexOffset = qFromLittleEndian<quint64>(data + 16);
+    const quint64 indexSize = qFromLittleEndian<quint64>(data + 24);
+    if (indexOffset < quint64(kHeaderSize) || indexOffset > quint64(size) ||
+        indexSize > quint64(size) - indexOffset) {
+        return fail("index out of range");
+    }
+
+    const uchar *cursor = data + indexOffset;
+    const uchar *indexEnd = cursor + indexSize;
+    m_entries.reserve(static_cast<int>(entryCount));
+
+    for (quint32 i = 0; i < entryCount; ++i) {
+        if (indexEnd - cursor < 2) {
+            return fail("truncated index");
+        }
+        const quint16 keyLength = qFromLittleEndian<quint16>(cursor);
+        cursor += 2;
+        if (indexEnd - cursor < keyLength + kIndexFixedSize) {
+            return fail("truncated index");
+        }
+
+        Entry entry;
+        entry.id = QString::fromUtf8(reinterpret_cast<const char *>(cursor), keyLength);
+        cursor += keyLength;
+        entry.pixelSize = qFromLittleEndian<quint16>(cursor);
+        entry.width = qFromLittleEndian<quint16>(cursor + 2);
+        entry.height = qFromLittleEndian<quint16>(cursor + 4);
+        entry.mtime = qFromLittleEndian<qint64>(cursor + 8);
+        entry.fileSize = qFromLittleEndian<qint64>(cursor + 16);
+        entry.offset = qFromLittleEndian<quint64>(cursor + 24);
+        cursor += kIndexFixedSize;
+
+        const quint64 bytes = quint64(entry.width) * quint64(entry.height) * 4;
+        if (entry.width <= 0 || entry.height <= 0 || entry.width > kMaxDimension ||
+            entry.height > kMaxDimension || entry.offset < quint64(kHeaderSize) ||
+            entry.offset > indexOffset || bytes > indexOffset - entry.offset) {
+            return fail("entry out of range");
+        }
+
+        const int separator = entry.id.lastIndexOf(QLatin1Char('|'));
+        entry.path = separator > 0 ? entry.id.left(separator) : entry.id;
+
+        m_index.insert(entry.id, m_entries.size());
+        m_entries.append(entry);
+    }
+
+    m_mapped = data;
+    m_mappedSize = size;
+    m_touched.reset(new std::atomic<bool>[m_entries.size()]);
+    for (int i = 0; i < m_entries.size(); ++i) {
+        m_touched[i].store(false, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void IconCache::unmapFile()
+{
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+        m_mapped = nullptr;
+        m_mappedSize = 0;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_entries.clear();
+    m_index.clear();
+    m_touched.reset();
+}
+
+QImage IconCache::lookup(const Key &key)
+{
+    if (!key.isValid()) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return QImage();
+    }
+
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        const auto it = m_pending.constFind(key.id);
+        if (it != m_pending.constEnd() && it->key.mtime == key.mtime && it->key.fileSize == key.fileSize) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return it->image;
+        }
+        if (m_invalidatedPaths.contains(key.path)) {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return QImage();
+        }
+    }
+
+    QReadLocker locker(&m_mapLock);
+    const auto it = m_index.constFind(key.id);
+    if (m_mapped && it != m_index.constEnd()) {
+        const Entry &entry = m_entries.at(it.value());
+        if (entry.mtime == key.mtime && entry.fileSize == key.fileSize) {
+            m_touched[it.value()].store(true, std::memory_order_relaxed);
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            // 直接引用映射内存，不做拷贝和解码
+            return QImage(m_mapped + entry.offset, entry.width, entry.height, entry.width * 4,
+                          QImage::Format_ARGB32_Premultiplied);
+        }
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return QImage();
+}
+
+void IconCache::insert(const Key &key, const QImage &image)
+{
+    if (!key.isValid() || image.isNull() || image.width() > kMaxDimension || image.height() > kMaxDimension) {
+        return;
+    }
+
+    PendingEntry pending;
+    pending.key = key;
+    pending.image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    QMutexLocker locker(&m_pendingMutex);
+    m_pending.insert(key.id, pending);
+}
+
+void IconCache::invalidate(const QString &path)
+{
+    const QString normalized = normalizedPath(QFileInfo(path).absoluteFilePath());
+
+    QMutexLocker locker(&m_pendingMutex);
+    m_invalidatedPaths.insert(normalized);
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (it->key.path == normalized) {
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool IconCache::save()
+{
+    if (m_path.isEmpty()) {
+        return false;
+    }
+
+    QWriteLocker mapLocker(&m_mapLock);
+    QMutexLocker pendingLocker(&m_pendingMutex);
+
+    // 本次运行中没有任何查询时（例如没有围栏），不按“未命中即过期”清理，避免清空缓存
+    const bool pruneUntouched = (hits() + misses()) > 0;
+
+    struct Output {
+        const Entry *mapped = nullptr;
+        const PendingEntry *pending = nullptr;
+        quint64 offset = 0;
+    };
+    QVector<Output> outputs;
+    int dropped = 0;
+
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const Entry &entry = m_entries.at(i);
+        const bool superseded = m_pending.contains(entry.id);
+        const bool invalidated = m_invalidatedPaths.contains(entry.path);
+        const bool untouched = pruneUntouched && !m_touched[i].load(std::memory_order_relaxed);
+        if (superseded || invalidated || untouched) {
+            ++dropped;
+            continue;
+        }
+        Output output;
+        output.mapped = &entry;
+        outputs.append(output);
+    }
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        Output output;
+        output.pending = &it.value();
+        outputs.append(output);
+    }
+
+    if (m_pending.isEmpty() && dropped == 0) {
+        return true;
+    }
+
+    const int newCount = m_pending.size();
+
+    // 先计算布局，再顺序写出：[头][像素块...][索引]
+    QByteArray index;
+    quint64 offset = kHeaderSize;
+    for (Output &output : outputs) {
+        QString id;
+        int pixelSize = 0;
+        int width = 0;
+        int height = 0;
+        qint64 mtime = 0;
+        qint64 fileSize = 0;
+        if (output.mapped) {
+            id = output.mapped->id;
+            pixelSize = output.mapped->pixelSize;
+            width = output.mapped->width;
+            height = output.mapped->height;
+            mtime = output.mapped->mtime;
+            fileSize = output.mapped->fileSize;
+        } else {
+            id = output.pending->key.id;
+            pixelSize = output.pending->key.pixelSize;
+            width = output.pending->image.width();
+            height = output.pending->image.height();
+            mtime = output.pending->key.mtime;
+            fileSize = output.pending->key.fileSize;
+        }
+
+        offset = align16(offset);
+        output.offset = offset;
+        offset += quint64(width) * quint64(height) * 4;
+
+        const QByteArray keyBytes = id.toUtf8();
+        uchar fixed[2 + kIndexFixedSize];
+        std::memset(fixed, 0, sizeof(fixed));
+        qToLittleEndian<quint16>(static_cast<quint16>(keyBytes.size()), fixed);
+        index.append(reinterpret_cast<const char *>(fixed), 2);
+        index.append(keyBytes);
+        uchar *field = fixed + 2;
+        qToLittleEndian<quint16>(static_cast<quint16>(pixelSize), field);
+        qToLittleEndian<quint16>(static_cast<quint16>(width), field + 2);
+        qToLittleEndian<quint16>(static_cast<quint16>(height), field + 4);
+        qToLittleEndian<qint64>(mtime, field + 8);
+        qToLittleEndian<qint64>(fileSize, field + 16);
+        qToLittleEndian<quint64>(output.offset, field + 24);
+        index.append(reinterpret_cast<const char *>(field), kIndexFixedSize);
+    }
+
+    const quint64 indexOffset = offset;
+    uchar header[kHeaderSize];
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    qToLittleEndian<quint32>(kVersion, header + 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(outputs.size()), header + 8);
+    qToLittleEndian<quint64>(indexOffset, header + 16);
+    qToLittleEndian<quint64>(static_cast<quint64>(index.size()), header + 24);
+
+    QSaveFile out(m_path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        LOG_WARN(Logger::Icon, "[IconCache] Failed to open cache file for writing: " + m_path);
+        return false;
+    }
+
+    bool ok = out.write(reinterpret_cast<const char *>(header), kHeaderSize) == kHeaderSize;
+    qint64 written = kHeaderSize;
+    for (const Output &output : qAsConst(outputs)) {
+        if (!ok) {
+            break;
+        }
+        if (output.offset > quint64(written)) {
+            const QByteArray padding(static_cast<int>(output.offset - written), '\0');
+            ok = out.write(padding) == padding.size();
+            written += padding.size();
+        }
+
+        if (output.mapped) {
+            const qint64 bytes = qint64(output.mapped->width) * output.mapped->height * 4;
+            ok = ok && out.write(reinterpret_cast<const char *>(m_mapped + output.mapped->offset), bytes) == bytes;
+            written += bytes;
+        } else {
+            const QImage &image = output.pending->image;
+            const qint64 rowBytes = qint64(image.width()) * 4;
+            for (int y = 0; ok && y < image.height(); ++y) {
+                ok = out.write(reinterpret_cast<const char *>(image.constScanLine(y)), rowBytes) == rowBytes;
+            }
+            written += rowBytes * image.height();
+        }
+    }
+    ok = ok && out.write(index) == index.size();
+
+    if (!ok) {
+        LOG_WARN(Logger::Icon, "[IconCache] Short write when saving cache file: " + m_path);
+        out.cancelWriting();
+        return false;
+    }
+
+    // Windows 下仍被映射的文件无法被替换，提交前先解除映射
+    unmapFile();
+    const bool committed = out.commit();
+    if (committed) {
+        m_pending.clear();
+        m_invalidatedPaths.clear();
+    }
+    mapFile();
+
+    LOG_INFO(Logger::Icon, QString("[IconCache] Saved %1 entries (%2 new, %3 dropped), hits=%4 misses=%5")
+                               .arg(outputs.size())
+                               .arg(newCount)
+                               .arg(dropped)
+                               .arg(hits())
+                               .arg(misses()));
+    return committed;
+}
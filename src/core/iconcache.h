@@ -0,0 +1,107 @@
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief 图标持久化缓存
+ * 把已裁剪、已缩放到显示尺寸的图标以 ARGB32_Premultiplied 原始像素保存在
+ * icon_cache.pack 中（与 fences_storage 同目录），启动时整体内存映射。
+ * 命中时直接用映射内存构造 QImage，不经过 Shell 图标提取、裁剪或任何解码。
+ *
+ * 索引键为 规范化路径 + 像素尺寸，并校验文件的修改时间与大小；
+ * 文件变化后旧条目自然失效，在 save() 时被压缩掉。
+ *
+ * 文件格式（小端序）：
+ *   [32 字节头: "DGIC" | version | entryCount | reserved | indexOffset(u64) | indexSize(u64)]
+ *   [像素数据块，按 16 字节对齐]
+ *   [索引: 每条 keyLen(u16) key(utf8) pixelSize(u16) width(u16) height(u16) pad(u16)
+ *          mtime(i64) fileSize(i64) offset(u64)]
+ */
+class IconCache
+{
+public:
+    struct Key {
+        QString path;       // 规范化路径
+        QString id;         // 规范化路径 + 像素尺寸
+        qint64 mtime = 0;
+        qint64 fileSize = 0;
+        int pixelSize = 0;
+        bool isValid() const { return !id.isEmpty(); }
+    };
+
+    static IconCache *instance();
+
+    // 映射已有的缓存文件；文件不存在或损坏时以空缓存启动，save() 时重建
+    void open(const QString &packPath);
+    void close();
+
+    // 读取文件属性并生成缓存键（文件不存在时返回无效键）
+    static Key makeKey(const QString &path, int pixelSize);
+
+    // 命中时返回直接引用映射内存的只读 QImage，在 save()/close() 之前有效
+    QImage lookup(const Key &key);
+    void insert(const Key &key, const QImage &image);
+    void invalidate(const QString &path);
+
+    // 写出新条目并压缩失效条目（退出前调用）；完成后重新映射新文件
+    bool save();
+
+    quint64 hits() const { return m_hits.load(std::memory_order_relaxed); }
+    quint64 misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+    IconCache() = default;
+    ~IconCache();
+    IconCache(const IconCache &) = delete;
+    IconCache &operator=(const IconCache &) = delete;
+
+    struct Entry {
+        QString path;
+        QString id;
+        qint64 mtime = 0;
+        qint64 fileSize = 0;
+        quint64 offset = 0;
+        int pixelSize = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    struct PendingEntry {
+        Key key;
+        QImage image;
+    };
+
+    bool mapFile();
+    void unmapFile();
+    static QString normalizedPath(const QString &path);
+
+    QString m_path;
+    QFile m_file;
+    uchar *m_mapped = nullptr;
+    qint64 m_mappedSize = 0;
+
+    // 映射文件中的条目，open() 之后只读；m_touched 记录本次运行中被命中过的条目
+    QVector<Entry> m_entries;
+    QHash<QString, int> m_index;
+    std::unique_ptr<std::atomic<bool>[]> m_touched;
+    QReadWriteLock m_mapLock;
+
+    QHash<QString, PendingEntry> m_pending;
+    QSet<QString> m_invalidatedPaths;
+    QMutex m_pendingMutex;
+
+    std::atomic<quint64> m_hits{0};
+    std::atomic<quint64> m_misses{0};
+};
+
+#endif // ICONCACHE_H
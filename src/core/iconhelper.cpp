@@ -1,5 +1,7 @@
 #include "iconhelper.h"
+#include "alphabounds.h"
 #include "configmanager.h"
+#include "iconcache.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QImage>
@@ -26,7 +28,7 @@ static const GUID IID_IImageList_LOCAL = { 0x46EB5926, 0x582E, 0x4017, { 0x9F, 0
 #endif
 #endif
 
-QPixmap IconHelper::getWinIcon(const QString &path)
+QImage IconHelper::getWinImage(const QString &path)
 {
 #ifdef Q_OS_WIN
     SHFILEINFOW sfi;
@@ -50,40 +52,84 @@ QPixmap IconHelper::getWinIcon(const QString &path)
         HICON hIcon = nullptr;
         hr = piml->GetIcon(sfi.iIcon, ILD_TRANSPARENT, &hIcon);
         if (SUCCEEDED(hr) && hIcon) {
-            QPixmap pixmap = QtWin::fromHICON(hIcon);
+            QImage image = QtWin::imageFromHICON(hIcon);
             DestroyIcon(hIcon);
             piml->Release();
             // 获取后进行透明裁剪，紧凑化图标
-            return cropTransparent(pixmap);
+            return cropTransparent(image);
         }
         piml->Release();
     }
 #endif
-    return QPixmap();
+    return QImage();
+}
+
+QPixmap IconHelper::getWinIcon(const QString &path)
+{
+    const QImage image = getWinImage(path);
+    return image.isNull() ? QPixmap() : QPixmap::fromImage(image);
+}
+
+QImage IconHelper::getCachedWinImage(const QString &path, int pixelSize)
+{
+    IconCache *cache = IconCache::instance();
+    const IconCache::Key key = IconCache::makeKey(path, pixelSize);
+    const QImage cached = cache->lookup(key);
+    if (!cached.isNull()) {
+        return cached;
+    }
+
+    QImage image = getWinImage(path);
+    if (image.isNull()) {
+        return image;
+    }
+
+    // 以显示尺寸入库，IconWidget 再次缩放时尺寸不变，直接复用
+    if (image.width() > pixelSize || image.height() > pixelSize) {
+        image = image.scaled(pixelSize, pixelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    cache->insert(key, image);
+    return image;
+}
+
+QPixmap IconHelper::getCachedWinIcon(const QString &path, int pixelSize)
+{
+    const QImage image = getCachedWinImage(path, pixelSize);
+    return image.isNull() ? QPixmap() : QPixmap::fromImage(image);
 }
 
 QPixmap IconHelper::cropTransparent(const QPixmap& pixmap)
 {
     if (pixmap.isNull()) return pixmap;
 
-    QImage img = pixmap.toImage();
-    int minX = img.width();
-    int minY = img.height();
-    int maxX = -1;
-    int maxY = -1;
-
-    for (int y = 0; y < img.height(); ++y) {
-        for (int x = 0; x < img.width(); ++x) {
-            if (qAlpha(img.pixel(x, y)) > 0) {
-                if (x < minX) minX = x;
-                if (x > maxX) maxX = x;
-                if (y < minY) minY = y;
-                if (y > maxY) maxY = y;
-            }
-        }
+    const QRect bounds = opaqueBounds(pixmap.toImage());
+    return bounds.isValid() ? pixmap.copy(bounds) : pixmap;
+}
+
+QImage IconHelper::cropTransparent(const QImage& image)
+{
+    if (image.isNull()) return image;
+
+    const QRect bounds = opaqueBounds(image);
+    return bounds.isValid() ? image.copy(bounds) : image;
+}
+
+QRect IconHelper::opaqueBounds(const QImage& image)
+{
+    QImage img = image;
+    // 内核直接读取 32 位扫描行；其他格式（含无 alpha 格式，结果为整幅图像）先转换
+    if (img.format() != QImage::Format_ARGB32 && img.format() != QImage::Format_ARGB32_Premultiplied) {
+        img = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
     }
 
-    if (maxX == -1) return pixmap; // 全透明或空
+    AlphaBounds::Rect bounds;
+    if (!AlphaBounds::find(img.constBits(), img.width(), img.height(), img.bytesPerLine(), &bounds)) {
+        return QRect(); // 全透明或空
+    }
+    int minX = bounds.left;
+    int minY = bounds.top;
+    int maxX = bounds.right;
+    int maxY = bounds.bottom;
 
     // 增加一点边距
     int margin = 2;
@@ -92,7 +138,7 @@ QPixmap IconHelper::cropTransparent(const QPixmap& pixmap)
     maxX = qMin(img.width() - 1, maxX + margin);
     maxY = qMin(img.height() - 1, maxY + margin);
 
-    return pixmap.copy(minX, minY, maxX - minX + 1, maxY - minY + 1);
+    return QRect(minX, minY, maxX - minX + 1, maxY - minY + 1);
 }
 
 QString IconHelper::toStoragePath(const QString& path, const QString& fenceId)
@@ -3,6 +3,8 @@
 
 #include <QString>
 #include <QPixmap>
+#include <QImage>
+#include <QRect>
 
 /**
  * @brief 图标处理助手
@@ -10,15 +12,30 @@
  */
 class IconHelper {
 public:
+    // 图标显示尺寸（逻辑像素），与 IconWidget 中图标标签一致
+    static const int kIconDisplaySize = 48;
+
     // 获取 Windows 系统原生图标 (支持超大图标)
     static QPixmap getWinIcon(const QString &path);
+    // 同上，以 QImage 返回，可在工作线程中调用（调用线程需已初始化 COM）
+    static QImage getWinImage(const QString &path);
+
+    // 带持久化缓存的图标获取：返回已裁剪并缩放到 pixelSize 以内的图标，
+    // 命中 IconCache 时不调用 Shell 接口、不做裁剪
+    static QPixmap getCachedWinIcon(const QString &path, int pixelSize);
+    static QImage getCachedWinImage(const QString &path, int pixelSize);
     
     // 裁剪图标周围的透明区域
     static QPixmap cropTransparent(const QPixmap& pixmap);
+    static QImage cropTransparent(const QImage& image);
     
     // 路径转换工具
     static QString toStoragePath(const QString& path, const QString& fenceId);
     static QString fromStoragePath(const QString& path, const QString& fenceId);
+
+private:
+    // 非透明区域外扩 2 像素后的矩形；全透明时返回无效矩形
+    static QRect opaqueBounds(const QImage& image);
 };
 
 #endif // ICONHELPER_H
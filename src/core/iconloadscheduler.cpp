@@ -0,0 +1,165 @@
+#include "iconloadscheduler.h"
+#include "logger.h"
+#include <QMutexLocker>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <objbase.h>
+#endif
+
+IconLoadScheduler *IconLoadScheduler::instance()
+{
+    static IconLoadScheduler *scheduler = new IconLoadScheduler();
+    return scheduler;
+}
+
+IconLoadScheduler::IconLoadScheduler(QObject *parent)
+    : QObject(parent)
+{
+    // Shell 图标提取主要受 I/O 与系统图标缓存锁限制，过多并发反而更慢
+    m_maxConcurrency = qBound(1, QThread::idealThreadCount() / 2, 4);
+    m_pool.setMaxThreadCount(m_maxConcurrency);
+    m_pool.setExpiryTimeout(10000);
+}
+
+IconLoadScheduler::~IconLoadScheduler()
+{
+    shutdown();
+}
+
+void IconLoadScheduler::enqueue(QObject *owner, Priority priority, Task task)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_shuttingDown) {
+        return;
+    }
+
+    auto it = m_queues.find(owner);
+    if (it == m_queues.end()) {
+        OwnerQueue queue;
+        queue.token = ++m_nextToken;
+        queue.order = ++m_nextOrder;
+        queue.priority = priority;
+        it = m_queues.insert(owner, queue);
+    }
+    it->tasks.enqueue(std::move(task));
+
+    if (m_activeWorkers < m_maxConcurrency) {
+        ++m_activeWorkers;
+        m_pool.start([this]() { drain(); });
+    }
+}
+
+void IconLoadScheduler::setPriority(QObject *owner, Priority priority)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_queues.find(owner);
+    if (it != m_queues.end()) {
+        it->priority = priority;
+    }
+}
+
+void IconLoadScheduler::cancel(QObject *owner)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_queues.find(owner);
+    if (it == m_queues.end()) {
+        return;
+    }
+    LOG_DEBUG(Logger::Icon, QString("[IconLoadScheduler] Cancelled %1 queued, %2 in flight")
+                                .arg(it->tasks.size())
+                                .arg(it->inFlight));
+    m_queues.erase(it);
+}
+
+int IconLoadScheduler::pendingCount(QObject *owner) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_queues.constFind(owner);
+    return it == m_queues.constEnd() ? 0 : it->tasks.size() + it->inFlight;
+}
+
+void IconLoadScheduler::setMaxConcurrency(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxConcurrency = qMax(1, count);
+    m_pool.setMaxThreadCount(m_maxConcurrency);
+}
+
+int IconLoadScheduler::maxConcurrency() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxConcurrency;
+}
+
+void IconLoadScheduler::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_shuttingDown = true;
+        m_queues.clear();
+    }
+    m_pool.waitForDone();
+}
+
+void IconLoadScheduler::drain()
+{
+#ifdef Q_OS_WIN
+    // Shell 图标接口要求调用线程已初始化 COM
+    const HRESULT hrCom = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+#endif
+
+    for (;;) {
+        Task task;
+        QObject *owner = nullptr;
+        quint64 token = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            auto best = m_queues.end();
+            for (auto it = m_queues.begin(); it != m_queues.end(); ++it) {
+                if (it->tasks.isEmpty()) {
+                    continue;
+                }
+                if (best == m_queues.end() || it->priority < best->priority
+                    || (it->priority == best->priority && it->order < best->order)) {
+                    best = it;
+                }
+            }
+            if (best == m_queues.end()) {
+                --m_activeWorkers;
+                break;
+            }
+            task = best->tasks.dequeue();
+            ++best->inFlight;
+            owner = best.key();
+            token = best->token;
+        }
+
+        const std::function<void()> continuation = task();
+        QMetaObject::invokeMethod(this, [this, owner, token, continuation]() {
+            deliver(owner, token, continuation);
+        }, Qt::QueuedConnection);
+    }
+
+#ifdef Q_OS_WIN
+    if (SUCCEEDED(hrCom)) {
+        CoUninitialize();
+    }
+#endif
+}
+
+void IconLoadScheduler::deliver(QObject *owner, quint64 token, const std::function<void()> &continuation)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_queues.find(owner);
+        if (it == m_queues.end() || it->token != token) {
+            return; // 已取消
+        }
+        if (--it->inFlight == 0 && it->tasks.isEmpty()) {
+            m_queues.erase(it);
+        }
+    }
+    continuation();
+}
@@ -0,0 +1,84 @@
+#ifndef ICONLOADSCHEDULER_H
+#define ICONLOADSCHEDULER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QThreadPool>
+#include <functional>
+
+/**
+ * @brief 全局图标提取调度器
+ * 所有围栏把单个图标的加载任务提交到同一个调度器，由固定上限的专用线程池执行，
+ * 避免多个围栏同时占满全局线程池、并发调用 Shell 接口。
+ *
+ * 任务按所属对象（围栏）分组：优先级低的组先执行（可见展开 > 折叠 > 隐藏），
+ * 同优先级按提交顺序。工作线程已初始化 COM，任务只应处理 QImage 等可跨线程的数据；
+ * 结果回到 GUI 线程交给 done 回调。cancel() 丢弃该对象尚未开始的任务和尚未送达的结果。
+ */
+class IconLoadScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        VisiblePriority = 0,   // 可见且展开
+        CollapsedPriority,     // 已折叠
+        HiddenPriority         // 不可见
+    };
+
+    static IconLoadScheduler *instance();
+
+    // work 在工作线程中执行；done 在 GUI 线程中执行，owner 已取消时不会调用
+    template <typename Result>
+    void submit(QObject *owner, Priority priority, std::function<Result()> work,
+                std::function<void(const Result &)> done)
+    {
+        enqueue(owner, priority, [work, done]() -> std::function<void()> {
+            const Result result = work();
+            return [done, result]() { done(result); };
+        });
+    }
+
+    void setPriority(QObject *owner, Priority priority);
+    void cancel(QObject *owner);
+    // 尚未送达结果的任务数（含执行中）
+    int pendingCount(QObject *owner) const;
+
+    // 同时执行的 Shell 调用上限
+    void setMaxConcurrency(int count);
+    int maxConcurrency() const;
+
+    // 取消全部任务并等待执行中的任务结束（程序退出前调用）
+    void shutdown();
+
+private:
+    explicit IconLoadScheduler(QObject *parent = nullptr);
+    ~IconLoadScheduler() override;
+
+    typedef std::function<std::function<void()>()> Task;
+
+    struct OwnerQueue {
+        quint64 token = 0;   // 区分先后位于同一地址的不同对象
+        quint64 order = 0;   // 同优先级时按首次提交顺序
+        int priority = VisiblePriority;
+        int inFlight = 0;    // 已出队、结果尚未送达的任务数
+        QQueue<Task> tasks;
+    };
+
+    void enqueue(QObject *owner, Priority priority, Task task);
+    void drain();
+    void deliver(QObject *owner, quint64 token, const std::function<void()> &continuation);
+
+    mutable QMutex m_mutex;
+    QHash<QObject *, OwnerQueue> m_queues;
+    quint64 m_nextToken = 0;
+    quint64 m_nextOrder = 0;
+    int m_activeWorkers = 0;
+    int m_maxConcurrency = 1;
+    bool m_shuttingDown = false;
+    QThreadPool m_pool;
+};
+
+#endif // ICONLOADSCHEDULER_H
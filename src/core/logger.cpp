@@ -0,0 +1,331 @@
+#include "logger.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+std::atomic<int> Logger::s_level{Logger::Info};
+std::atomic<quint32> Logger::s_categoryMask{Logger::AllCategories};
+
+namespace {
+
+const size_t kRingCapacity = 8192; // 必须是 2 的幂
+const size_t kRingMask = kRingCapacity - 1;
+const int kFlushIntervalMs = 200;
+
+const char *levelTag(int level)
+{
+    switch (level) {
+    case Logger::Debug: return "D ";
+    case Logger::Info: return "I ";
+    case Logger::Warning: return "W ";
+    case Logger::Error: return "E ";
+    default: return "  ";
+    }
+}
+
+const char *categoryTag(quint32 category)
+{
+    switch (category) {
+    case Logger::General: return "[general] ";
+    case Logger::Config: return "[config] ";
+    case Logger::Fence: return "[fence] ";
+    case Logger::Icon: return "[icon] ";
+    case Logger::Drag: return "[drag] ";
+    case Logger::Snap: return "[snap] ";
+    default: return "";
+    }
+}
+
+/**
+ * 有界多生产者单消费者队列（Vyukov 序号槽算法）。
+ * 生产者只做一次 CAS 和一次 QString 移动；缓冲区满时直接丢弃，不阻塞调用线程。
+ */
+class LogRing
+{
+public:
+    struct Entry {
+        qint64 timestamp = 0;
+        int level = Logger::Info;
+        quint32 category = Logger::General;
+        QString message;
+    };
+
+    LogRing()
+        : m_slots(new Slot[kRingCapacity])
+    {
+        for (size_t i = 0; i < kRingCapacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~LogRing() { delete[] m_slots; }
+
+    // 返回入队后的位置（用于判断是否需要唤醒写入线程），缓冲区已满时返回 0
+    size_t push(qint64 timestamp, int level, quint32 category, const QString &message)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot *slot = nullptr;
+        for (;;) {
+            slot = &m_slots[pos & kRingMask];
+            const size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return 0;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->entry.timestamp = timestamp;
+        slot->entry.level = level;
+        slot->entry.category = category;
+        slot->entry.message = message;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return pos + 1;
+    }
+
+    // 仅由写入线程调用
+    bool pop(Entry *out)
+    {
+        Slot &slot = m_slots[m_dequeuePos & kRingMask];
+        const size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(m_dequeuePos + 1) < 0) {
+            return false;
+        }
+
+        out->timestamp = slot.entry.timestamp;
+        out->level = slot.entry.level;
+        out->category = slot.entry.category;
+        out->message = std::move(slot.entry.message);
+        slot.entry.message = QString();
+        slot.sequence.store(m_dequeuePos + kRingCapacity, std::memory_order_release);
+        ++m_dequeuePos;
+        return true;
+    }
+
+    quint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Entry entry;
+    };
+
+    Slot *m_slots;
+    alignas(64) std::atomic<size_t> m_enqueuePos{0};
+    alignas(64) size_t m_dequeuePos = 0;
+    std::atomic<quint64> m_dropped{0};
+};
+
+class LogWriter
+{
+public:
+    static LogWriter *instance()
+    {
+        static LogWriter writer;
+        return &writer;
+    }
+
+    LogRing ring;
+
+    void start(const QString &filePath)
+    {
+        std::lock_guard<std::mutex> locker(m_threadMutex);
+        if (m_thread.joinable()) {
+            return;
+        }
+        m_filePath = filePath;
+        m_stopping.store(false, std::memory_order_relaxed);
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> locker(m_threadMutex);
+        if (!m_thread.joinable()) {
+            return;
+        }
+        m_stopping.store(true, std::memory_order_release);
+        wake();
+        m_thread.join();
+    }
+
+    void wake() { m_wakeCondition.notify_one(); }
+
+    void setRotation(qint64 maxFileSize, int maxBackupFiles)
+    {
+        m_maxFileSize.store(maxFileSize, std::memory_order_relaxed);
+        m_maxBackupFiles.store(maxBackupFiles, std::memory_order_relaxed);
+    }
+
+private:
+    LogWriter() = default;
+    ~LogWriter() { stop(); }
+
+    void run()
+    {
+        QFile file(m_filePath);
+        QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+        file.open(QIODevice::WriteOnly | QIODevice::Append);
+
+        QByteArray buffer;
+        LogRing::Entry entry;
+        quint64 reportedDropped = 0;
+
+        for (;;) {
+            const bool stopping = m_stopping.load(std::memory_order_acquire);
+
+            buffer.clear();
+            while (ring.pop(&entry)) {
+                buffer.append(QDateTime::fromMSecsSinceEpoch(entry.timestamp)
+                                  .toString("yyyy-MM-dd HH:mm:ss.zzz ")
+                                  .toUtf8());
+                buffer.append(levelTag(entry.level));
+                buffer.append(categoryTag(entry.category));
+                buffer.append(entry.message.toUtf8());
+                buffer.append('\n');
+            }
+
+            const quint64 dropped = ring.dropped();
+            if (dropped != reportedDropped) {
+                buffer.append(QString("[Logger] %1 messages dropped (buffer full)\n")
+                                  .arg(dropped - reportedDropped)
+                                  .toUtf8());
+                reportedDropped = dropped;
+            }
+
+            if (!buffer.isEmpty() && file.isOpen()) {
+                file.write(buffer);
+                file.flush();
+                rotateIfNeeded(&file);
+            }
+
+            if (stopping) {
+                break;
+            }
+
+            std::unique_lock<std::mutex> locker(m_wakeMutex);
+            m_wakeCondition.wait_for(locker, std::chrono::milliseconds(kFlushIntervalMs));
+        }
+
+        file.close();
+    }
+
+    void rotateIfNeeded(QFile *file)
+    {
+        const qint64 maxFileSize = m_maxFileSize.load(std::memory_order_relaxed);
+        if (maxFileSize <= 0 || file->size() < maxFileSize) {
+            return;
+        }
+
+        file->close();
+
+        // msix_debug.txt -> msix_debug.1.txt -> msix_debug.2.txt ...
+        const QFileInfo info(m_filePath);
+        const QString base = info.absolutePath() + "/" + info.completeBaseName();
+        const QString suffix = info.suffix().isEmpty() ? QString() : "." + info.suffix();
+        const int maxBackupFiles = m_maxBackupFiles.load(std::memory_order_relaxed);
+
+        if (maxBackupFiles <= 0) {
+            QFile::remove(m_filePath);
+        } else {
+            QFile::remove(QString("%1.%2%3").arg(base).arg(maxBackupFiles).arg(suffix));
+            for (int i = maxBackupFiles - 1; i >= 1; --i) {
+                QFile::rename(QString("%1.%2%3").arg(base).arg(i).arg(suffix),
+                              QString("%1.%2%3").arg(base).arg(i + 1).arg(suffix));
+            }
+            QFile::rename(m_filePath, QString("%1.1%2").arg(base, suffix));
+        }
+
+        file->open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+
+    QString m_filePath;
+    std::thread m_thread;
+    std::mutex m_threadMutex;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<qint64> m_maxFileSize{4 * 1024 * 1024};
+    std::atomic<int> m_maxBackupFiles{2};
+};
+
+int parseLevel(const QString &value, int fallback)
+{
+    const QString level = value.trimmed().toLower();
+    if (level == "debug") return Logger::Debug;
+    if (level == "info") return Logger::Info;
+    if (level == "warning" || level == "warn") return Logger::Warning;
+    if (level == "error") return Logger::Error;
+    if (level == "off" || level == "none") return Logger::Off;
+    return fallback;
+}
+
+quint32 parseCategories(const QString &value)
+{
+    quint32 mask = 0;
+    for (const QString &part : value.split(',', Qt::SkipEmptyParts)) {
+        const QString name = part.trimmed().toLower();
+        if (name == "all") mask |= Logger::AllCategories;
+        else if (name == "general") mask |= Logger::General;
+        else if (name == "config") mask |= Logger::Config;
+        else if (name == "fence") mask |= Logger::Fence;
+        else if (name == "icon") mask |= Logger::Icon;
+        else if (name == "drag") mask |= Logger::Drag;
+        else if (name == "snap") mask |= Logger::Snap;
+    }
+    return mask;
+}
+
+} // namespace
+
+void Logger::initialize(const QString &filePath)
+{
+    const QString levelEnv = qEnvironmentVariable("DESKGO_LOG_LEVEL");
+    if (!levelEnv.isEmpty()) {
+        setLevel(static_cast<Level>(parseLevel(levelEnv, Info)));
+    }
+    const QString categoriesEnv = qEnvironmentVariable("DESKGO_LOG_CATEGORIES");
+    if (!categoriesEnv.isEmpty()) {
+        setCategoryMask(parseCategories(categoriesEnv));
+    }
+
+    LogWriter::instance()->start(filePath);
+}
+
+void Logger::shutdown()
+{
+    LogWriter::instance()->stop();
+}
+
+void Logger::write(Level level, quint32 category, const QString &message)
+{
+    LogWriter *writer = LogWriter::instance();
+    const size_t pos = writer->ring.push(QDateTime::currentMSecsSinceEpoch(), level, category, message);
+
+    // 平时由写入线程定时批量刷出；警告/错误或积压较多时立即唤醒
+    if (level >= Warning || (pos != 0 && (pos & 1023) == 0)) {
+        writer->wake();
+    }
+}
+
+void Logger::setRotation(qint64 maxFileSize, int maxBackupFiles)
+{
+    LogWriter::instance()->setRotation(maxFileSize, maxBackupFiles);
+}
+
+quint64 Logger::droppedCount()
+{
+    return LogWriter::instance()->ring.dropped();
+}
@@ -0,0 +1,82 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QString>
+#include <atomic>
+
+/**
+ * @brief 异步日志
+ * 调用线程只把消息放入无锁有界环形缓冲区，由单独的后台线程格式化时间戳并写入
+ * msix_debug.txt（文件保持打开，按大小滚动）。级别与分类在格式化任何字符串之前检查，
+ * 热路径请使用下方的 LOG_* 宏，被禁用的日志几乎没有开销。
+ *
+ * 运行时配置（环境变量）：
+ *   DESKGO_LOG_LEVEL       debug / info / warning / error / off，默认 info
+ *   DESKGO_LOG_CATEGORIES  逗号分隔的分类名（general,config,fence,icon,drag,snap）或 all
+ */
+class Logger
+{
+public:
+    enum Level {
+        Debug = 0,
+        Info,
+        Warning,
+        Error,
+        Off
+    };
+
+    enum Category : quint32 {
+        General = 1u << 0,
+        Config  = 1u << 1,  // 配置与持久化
+        Fence   = 1u << 2,  // 围栏生命周期、图标增删
+        Icon    = 1u << 3,  // 图标解析与提取
+        Drag    = 1u << 4,  // 拖放
+        Snap    = 1u << 5,  // 吸附与对齐线
+        AllCategories = 0xFFFFFFFFu
+    };
+
+    // 启动后台写入线程；在此之前写入的消息会暂存在缓冲区中
+    static void initialize(const QString &filePath);
+    // 写出缓冲区中剩余的消息并结束后台线程（程序退出前调用）
+    static void shutdown();
+
+    // 分类掩码只过滤 Debug/Info，Warning 及以上总是输出
+    static bool isEnabled(Level level, quint32 category)
+    {
+        const int minLevel = s_level.load(std::memory_order_relaxed);
+        if (level < minLevel) {
+            return false;
+        }
+        return level >= Warning || (s_categoryMask.load(std::memory_order_relaxed) & category) != 0;
+    }
+
+    static void write(Level level, quint32 category, const QString &message);
+
+    static void setLevel(Level level) { s_level.store(level, std::memory_order_relaxed); }
+    static void setCategoryMask(quint32 mask) { s_categoryMask.store(mask, std::memory_order_relaxed); }
+
+    // 单个日志文件上限及保留的历史文件数
+    static void setRotation(qint64 maxFileSize, int maxBackupFiles);
+
+    // 因缓冲区已满而丢弃的消息数
+    static quint64 droppedCount();
+
+private:
+    static std::atomic<int> s_level;
+    static std::atomic<quint32> s_categoryMask;
+};
+
+// 先检查级别和分类，再对 message 表达式求值
+#define DESKGO_LOG(level, category, message) \
+    do { \
+        if (Logger::isEnabled(level, category)) { \
+            Logger::write(level, category, message); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(category, message) DESKGO_LOG(Logger::Debug, category, message)
+#define LOG_INFO(category, message) DESKGO_LOG(Logger::Info, category, message)
+#define LOG_WARN(category, message) DESKGO_LOG(Logger::Warning, category, message)
+#define LOG_ERROR(category, message) DESKGO_LOG(Logger::Error, category, message)
+
+#endif // LOGGER_H
@@ -0,0 +1,171 @@
+#include "storagegenerations.h"
+#include "logger.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSaveFile>
+
+namespace {
+
+const char *kBaseName = "fences_storage";
+const char *kPointerFileName = "fences_storage.current";
+const char *kStagingPrefix = "fences_storage.staging-";
+
+QString pointerPath(const QString &appDataDir)
+{
+    return QDir(appDataDir).filePath(kPointerFileName);
+}
+
+// 指针文件只保存目录名（相对 appDataDir），数据目录整体搬迁后仍然有效。
+// 没有指针文件时为 fences_storage；指针存在却无法确认时返回 false
+bool currentName(const QString &appDataDir, QString *name, QString *errorMessage)
+{
+    QFile file(pointerPath(appDataDir));
+    if (!file.exists()) {
+        *name = kBaseName;
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorMessage = QString("无法读取存储指针：%1").arg(QDir::toNativeSeparators(file.fileName()));
+        return false;
+    }
+    const QString value = QString::fromUtf8(file.readAll()).trimmed();
+    if (value != kBaseName && !value.startsWith(QString(kBaseName) + ".")) {
+        *errorMessage = QString("存储指针内容无效：%1").arg(QDir::toNativeSeparators(file.fileName()));
+        return false;
+    }
+    if (!QDir(QDir(appDataDir).filePath(value)).exists()) {
+        *errorMessage = QString("存储指针指向的目录不存在：%1").arg(value);
+        return false;
+    }
+    *name = value;
+    return true;
+}
+
+// fences_storage 为第 0 代，fences_storage.<N> 为第 N 代；其他名称返回 -1
+int generationNumber(const QString &name)
+{
+    if (name == kBaseName) {
+        return 0;
+    }
+    static const QRegularExpression pattern(QString("^%1\\.(\\d+)$").arg(kBaseName));
+    const QRegularExpressionMatch match = pattern.match(name);
+    return match.hasMatch() ? match.captured(1).toInt() : -1;
+}
+
+} // namespace
+
+namespace StorageGenerations {
+
+QString currentPath(const QString &appDataDir, QString *errorMessage)
+{
+    QString name;
+    QString error;
+    if (!currentName(appDataDir, &name, &error)) {
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        return QString();
+    }
+    return QDir::cleanPath(QDir(appDataDir).filePath(name));
+}
+
+QString latestPath(const QString &appDataDir)
+{
+    const QDir root(appDataDir);
+    QString latest = kBaseName;
+    int latestNumber = -1;
+    for (const QString &name : root.entryList({QString(kBaseName) + "*"}, QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const int number = generationNumber(name);
+        if (number > latestNumber) {
+            latest = name;
+            latestNumber = number;
+        }
+    }
+    return QDir::cleanPath(root.filePath(latest));
+}
+
+QString createStaging(const QString &appDataDir, QString *errorMessage)
+{
+    const QString path = QDir(appDataDir).filePath(kStagingPrefix
+        + QDateTime::currentDateTime().toString("yyyyMMddHHmmsszzz"));
+    if (!QDir().mkpath(path)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法创建暂存目录：%1").arg(QDir::toNativeSeparators(path));
+        }
+        return QString();
+    }
+    return QDir::cleanPath(path);
+}
+
+bool commit(const QString &appDataDir, const QString &stagingDir, QString *generationPath, QString *errorMessage)
+{
+    const QDir root(appDataDir);
+    int next = 1;
+    for (const QString &name : root.entryList({QString(kBaseName) + "*"}, QDir::Dirs | QDir::NoDotAndDotDot)) {
+        next = qMax(next, generationNumber(name) + 1);
+    }
+
+    const QString name = QString("%1.%2").arg(kBaseName).arg(next);
+    const QString path = QDir::cleanPath(root.filePath(name));
+    if (!QDir().rename(stagingDir, path)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法移动目录：%1 -> %2")
+                .arg(QDir::toNativeSeparators(stagingDir), QDir::toNativeSeparators(path));
+        }
+        return false;
+    }
+
+    QSaveFile pointer(pointerPath(appDataDir));
+    const QByteArray data = name.toUtf8();
+    if (!pointer.open(QIODevice::WriteOnly) || pointer.write(data) != data.size() || !pointer.commit()) {
+        // 指针未切换，新目录改回原名，当前代保持不变
+        QDir().rename(path, stagingDir);
+        if (errorMessage) {
+            *errorMessage = QString("无法写入存储指针：%1").arg(QDir::toNativeSeparators(pointerPath(appDataDir)));
+        }
+        return false;
+    }
+
+    LOG_INFO(Logger::Config, "[StorageGenerations] Switched storage to " + name);
+    if (generationPath) {
+        *generationPath = path;
+    }
+    return true;
+}
+
+void collectGarbage(const QString &appDataDir)
+{
+    // 先列目录再读指针：列出之后才提交的新一代不在列表中，读到的指针也不会比列表旧
+    const QDir root(appDataDir);
+    const QStringList names = root.entryList({QString(kBaseName) + "*"}, QDir::Dirs | QDir::NoDotAndDotDot);
+    QString current;
+    QString error;
+    if (!currentName(appDataDir, &current, &error)) {
+        // 无法确定哪一代在用，宁可留下旧目录也不能删掉正在使用的存储
+        LOG_WARN(Logger::Config, "[StorageGenerations] Garbage collection skipped: " + error);
+        return;
+    }
+
+    // 最新一代即使不是指针所指也保留：可能是刚提交、指针尚未被本次读取反映的目录
+    int latest = -1;
+    for (const QString &name : names) {
+        latest = qMax(latest, generationNumber(name));
+    }
+
+    for (const QString &name : names) {
+        const int number = generationNumber(name);
+        if (name == current || (number >= 0 && number == latest)) {
+            continue;
+        }
+        if (number < 0 && !name.startsWith(kStagingPrefix)) {
+            continue;
+        }
+        if (QDir(root.filePath(name)).removeRecursively()) {
+            LOG_INFO(Logger::Config, "[StorageGenerations] Removed " + name);
+        }
+    }
+}
+
+} // namespace StorageGenerations
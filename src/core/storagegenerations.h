@@ -0,0 +1,36 @@
+#ifndef STORAGEGENERATIONS_H
+#define STORAGEGENERATIONS_H
+
+#include <QString>
+
+/**
+ * @brief fences_storage 代际目录
+ * 存储目录不再原地删除重建：新内容先在同级的暂存目录中准备好，
+ * 再改名为新一代目录（fences_storage.<N>），最后用 QSaveFile 原子改写指针文件
+ * fences_storage.current 完成切换。任何时刻崩溃，指针都指向一个完整的目录。
+ * 没有指针文件时当前代就是原来的 fences_storage，旧安装无需迁移。
+ * 被替换下来的旧代和中断留下的暂存目录由 collectGarbage() 在后台删除。
+ */
+namespace StorageGenerations {
+
+// 当前代存储目录的绝对路径。指针文件存在但无法读取、内容无效或指向的目录不存在时
+// 返回空串并给出错误，不擅自退回 fences_storage
+QString currentPath(const QString &appDataDir, QString *errorMessage);
+
+// 编号最大的代目录（没有任何代目录时为 fences_storage），供指针损坏时兜底
+QString latestPath(const QString &appDataDir);
+
+// 在 appDataDir 下新建一个空的暂存目录，失败时返回空串
+QString createStaging(const QString &appDataDir, QString *errorMessage);
+
+// 把 stagingDir（须与 appDataDir 位于同一卷）改名为新一代并改写指针文件。
+// 成功后 generationPath 为新一代目录；失败时当前代保持不变
+bool commit(const QString &appDataDir, const QString &stagingDir, QString *generationPath, QString *errorMessage);
+
+// 删除当前代以外的代目录和暂存目录；编号最大的一代始终保留，指针无法确认时不删除任何目录。
+// 会遍历整棵目录树，应在后台线程调用
+void collectGarbage(const QString &appDataDir);
+
+} // namespace StorageGenerations
+
+#endif // STORAGEGENERATIONS_H
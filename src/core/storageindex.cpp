@@ -0,0 +1,71 @@
+#include "storageindex.h"
+#include "logger.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+StorageIndex *StorageIndex::instance()
+{
+    static StorageIndex index;
+    return &index;
+}
+
+std::shared_ptr<const StorageIndex::Entries> StorageIndex::build(const QString &storageRoot)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto entries = std::make_shared<Entries>();
+    const QDir rootDir(storageRoot);
+    const QStringList subDirs = rootDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    int entryCount = 0;
+    for (const QString &subDir : subDirs) {
+        const QDir dir(rootDir.filePath(subDir));
+        const QStringList names = dir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+        for (const QString &name : names) {
+            Location location;
+            location.dirName = subDir;
+            location.path = QDir::toNativeSeparators(QDir::cleanPath(dir.filePath(name)));
+            (*entries)[name.toLower()].append(location);
+            ++entryCount;
+        }
+    }
+
+    LOG_INFO(Logger::Icon, QString("[StorageIndex] Indexed %1 entries in %2 directories in %3 ms")
+                               .arg(entryCount)
+                               .arg(subDirs.size())
+                               .arg(timer.elapsed()));
+    return entries;
+}
+
+void StorageIndex::invalidate()
+{
+    std::lock_guard<std::mutex> locker(m_buildMutex);
+    std::atomic_store(&m_entries, std::shared_ptr<const Entries>());
+}
+
+QString StorageIndex::find(const QString &storageRoot, const QString &fileName, const QString &preferredDir)
+{
+    std::shared_ptr<const Entries> entries = std::atomic_load(&m_entries);
+    if (!entries) {
+        std::lock_guard<std::mutex> locker(m_buildMutex);
+        entries = std::atomic_load(&m_entries);
+        if (!entries) {
+            entries = build(storageRoot);
+            std::atomic_store(&m_entries, entries);
+        }
+    }
+
+    const auto it = entries->constFind(fileName.toLower());
+    if (it == entries->constEnd() || it->isEmpty()) {
+        return QString();
+    }
+
+    const QString preferredName = QFileInfo(QDir::cleanPath(preferredDir)).fileName();
+    for (const Location &location : *it) {
+        if (QString::compare(location.dirName, preferredName, Qt::CaseInsensitive) == 0) {
+            return location.path;
+        }
+    }
+    return it->first().path;
+}
@@ -0,0 +1,47 @@
+#ifndef STORAGEINDEX_H
+#define STORAGEINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <mutex>
+
+/**
+ * @brief fences_storage 文件名索引
+ * 恢复图标时若保存的路径已失效，需要在所有围栏的存储目录里按文件名查找。
+ * 索引在第一次查找时用一次目录扫描建立（根目录下每个围栏目录的直接子项，
+ * 与原先逐目录探测的范围相同），之后所有加载任务只读共享同一份不可变快照。
+ * 索引完整覆盖扫描范围，因此未命中即可直接判定不存在，重复的未命中没有任何文件系统开销。
+ *
+ * 存储目录被整体替换（在线还原备份）后调用 invalidate()，下次查找时重新扫描；
+ * 正在使用旧快照的查找不受影响。
+ */
+class StorageIndex
+{
+public:
+    static StorageIndex *instance();
+
+    // 在 storageRoot 下查找名为 fileName 的条目（不区分大小写）。
+    // 优先返回位于 preferredDir 中的条目，否则按目录名排序返回第一个；没有则返回空串
+    QString find(const QString &storageRoot, const QString &fileName, const QString &preferredDir);
+
+    // 丢弃当前索引，下次查找时重建
+    void invalidate();
+
+private:
+    StorageIndex() = default;
+
+    struct Location {
+        QString dirName;  // 围栏目录名（即围栏 id）
+        QString path;     // 规范化的完整路径
+    };
+    typedef QHash<QString, QVector<Location>> Entries; // 小写文件名 -> 所在位置
+
+    static std::shared_ptr<const Entries> build(const QString &storageRoot);
+
+    std::mutex m_buildMutex;
+    std::shared_ptr<const Entries> m_entries; // 只通过 std::atomic_load / atomic_store 访问
+};
+
+#endif // STORAGEINDEX_H
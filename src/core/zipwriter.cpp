@@ -0,0 +1,439 @@
+#include "zipwriter.h"
+#include "contentmanifest.h"
+#include "crc32.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtEndian>
+
+namespace {
+
+const quint32 kLocalHeaderSignature = 0x04034b50;
+const quint32 kCentralHeaderSignature = 0x02014b50;
+const quint32 kEndOfCentralDirSignature = 0x06054b50;
+const quint32 kZip64EndOfCentralDirSignature = 0x06064b50;
+const quint32 kZip64LocatorSignature = 0x07064b50;
+const quint16 kZip64ExtraId = 0x0001;
+
+const quint16 kVersionDefault = 20;
+const quint16 kVersionZip64 = 45;
+const quint16 kFlagUtf8Name = 0x0800;
+const quint16 kMethodStored = 0;
+const quint16 kMethodDeflated = 8;
+
+const qint64 kMax16 = 0xFFFF;
+const qint64 kMax32 = 0xFFFFFFFFLL;
+const qint64 kChunkSize = 1024 * 1024;
+// 本地文件头中 CRC 字段的偏移，大文件写完后回填
+const int kLocalHeaderCrcOffset = 14;
+
+void put16(QByteArray *out, quint16 value)
+{
+    char bytes[2];
+    qToLittleEndian<quint16>(value, bytes);
+    out->append(bytes, 2);
+}
+
+void put32(QByteArray *out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    out->append(bytes, 4);
+}
+
+void put64(QByteArray *out, quint64 value)
+{
+    char bytes[8];
+    qToLittleEndian<quint64>(value, bytes);
+    out->append(bytes, 8);
+}
+
+quint32 clamp32(qint64 value)
+{
+    return static_cast<quint32>(qMin(value, kMax32));
+}
+
+// MS-DOS 日期时间（本地时间，2 秒精度，最早 1980 年）
+quint32 dosDateTime(const QDateTime &dateTime)
+{
+    const QDateTime local = dateTime.isValid() ? dateTime.toLocalTime() : QDateTime::currentDateTime();
+    const QDate date = local.date();
+    const QTime time = local.time();
+    if (date.year() < 1980) {
+        return (1 << 5 | 1) << 16;
+    }
+    const quint32 dosDate = quint32(date.year() - 1980) << 9 | quint32(date.month()) << 5 | quint32(date.day());
+    const quint32 dosTime = quint32(time.hour()) << 11 | quint32(time.minute()) << 5 | quint32(time.second() / 2);
+    return dosDate << 16 | dosTime;
+}
+
+struct Record {
+    QByteArray name;
+    quint16 method = kMethodStored;
+    quint32 crc = 0;
+    quint32 dosTime = 0;
+    qint64 size = 0;
+    qint64 compressedSize = 0;
+    qint64 offset = 0;
+
+    bool sizesNeedZip64() const { return size >= kMax32 || compressedSize >= kMax32; }
+};
+
+QByteArray localHeader(const Record &record)
+{
+    const bool zip64 = record.sizesNeedZip64();
+    QByteArray extra;
+    if (zip64) {
+        put16(&extra, kZip64ExtraId);
+        put16(&extra, 16);
+        put64(&extra, record.size);
+        put64(&extra, record.compressedSize);
+    }
+
+    QByteArray header;
+    put32(&header, kLocalHeaderSignature);
+    put16(&header, zip64 ? kVersionZip64 : kVersionDefault);
+    put16(&header, kFlagUtf8Name);
+    put16(&header, record.method);
+    put32(&header, record.dosTime);
+    put32(&header, record.crc);
+    put32(&header, zip64 ? quint32(kMax32) : quint32(record.compressedSize));
+    put32(&header, zip64 ? quint32(kMax32) : quint32(record.size));
+    put16(&header, quint16(record.name.size()));
+    put16(&header, quint16(extra.size()));
+    header.append(record.name);
+    header.append(extra);
+    return header;
+}
+
+QByteArray centralHeader(const Record &record)
+{
+    // ZIP64 扩展字段只包含在 32 位字段中被标记为 0xFFFFFFFF 的值，顺序固定
+    const bool zip64Sizes = record.sizesNeedZip64();
+    const bool zip64Offset = record.offset >= kMax32;
+    QByteArray extra;
+    if (zip64Sizes || zip64Offset) {
+        QByteArray values;
+        if (zip64Sizes) {
+            put64(&values, record.size);
+            put64(&values, record.compressedSize);
+        }
+        if (zip64Offset) {
+            put64(&values, record.offset);
+        }
+        put16(&extra, kZip64ExtraId);
+        put16(&extra, quint16(values.size()));
+        extra.append(values);
+    }
+
+    QByteArray header;
+    put32(&header, kCentralHeaderSignature);
+    put16(&header, kVersionZip64);  // 创建版本（MS-DOS 属性）
+    put16(&header, extra.isEmpty() ? kVersionDefault : kVersionZip64);
+    put16(&header, kFlagUtf8Name);
+    put16(&header, record.method);
+    put32(&header, record.dosTime);
+    put32(&header, record.crc);
+    put32(&header, zip64Sizes ? quint32(kMax32) : quint32(record.compressedSize));
+    put32(&header, zip64Sizes ? quint32(kMax32) : quint32(record.size));
+    put16(&header, quint16(record.name.size()));
+    put16(&header, quint16(extra.size()));
+    put16(&header, 0);  // 注释长度
+    put16(&header, 0);  // 起始磁盘
+    put16(&header, 0);  // 内部属性
+    put32(&header, 0);  // 外部属性
+    put32(&header, zip64Offset ? quint32(kMax32) : quint32(record.offset));
+    header.append(record.name);
+    header.append(extra);
+    return header;
+}
+
+QByteArray endOfCentralDirectory(qint64 entryCount, qint64 directoryOffset, qint64 directorySize)
+{
+    QByteArray tail;
+    const bool zip64 = entryCount >= kMax16 || directoryOffset >= kMax32 || directorySize >= kMax32;
+    if (zip64) {
+        const qint64 zip64EndOffset = directoryOffset + directorySize;
+        put32(&tail, kZip64EndOfCentralDirSignature);
+        put64(&tail, 44);  // 记录剩余长度
+        put16(&tail, kVersionZip64);
+        put16(&tail, kVersionZip64);
+        put32(&tail, 0);
+        put32(&tail, 0);
+        put64(&tail, entryCount);
+        put64(&tail, entryCount);
+        put64(&tail, directorySize);
+        put64(&tail, directoryOffset);
+
+        put32(&tail, kZip64LocatorSignature);
+        put32(&tail, 0);
+        put64(&tail, zip64EndOffset);
+        put32(&tail, 1);
+    }
+
+    put32(&tail, kEndOfCentralDirSignature);
+    put16(&tail, 0);
+    put16(&tail, 0);
+    put16(&tail, quint16(qMin(entryCount, kMax16)));
+    put16(&tail, quint16(qMin(entryCount, kMax16)));
+    put32(&tail, clamp32(directorySize));
+    put32(&tail, clamp32(directoryOffset));
+    put16(&tail, 0);
+    return tail;
+}
+
+struct Prepared {
+    QByteArray payload;
+    QString sha256;
+    quint32 crc = 0;
+    qint64 size = 0;
+    quint16 method = kMethodStored;
+    QString error;
+};
+
+// 工作线程：读入整个条目、计算 CRC 和 SHA-256 并压缩，压缩后没有变小则原样存储
+Prepared prepareEntry(const QString &sourcePath, const QByteArray &data)
+{
+    Prepared prepared;
+    QByteArray raw = data;
+    if (!sourcePath.isEmpty()) {
+        QFile file(sourcePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            prepared.error = QString("无法读取文件：%1").arg(sourcePath);
+            return prepared;
+        }
+        raw = file.readAll();
+    }
+
+    prepared.crc = Crc32::compute(raw);
+    prepared.sha256 = ContentManifest::hashData(raw);
+    prepared.size = raw.size();
+    prepared.payload = raw;
+
+    if (!raw.isEmpty()) {
+        // qCompress 输出为 4 字节长度 + zlib 流（2 字节头 + deflate 数据 + 4 字节 Adler-32），
+        // ZIP 需要的是中间的原始 deflate 数据
+        const QByteArray zlib = qCompress(raw, 6);
+        if (zlib.size() > 10) {
+            const int deflatedSize = zlib.size() - 10;
+            if (deflatedSize < raw.size()) {
+                prepared.payload = zlib.mid(6, deflatedSize);
+                prepared.method = kMethodDeflated;
+            }
+        }
+    }
+    return prepared;
+}
+
+} // namespace
+
+ZipWriter::ZipWriter(const QString &path)
+    : m_path(path)
+{
+}
+
+void ZipWriter::addFile(const QString &name, const QString &sourcePath)
+{
+    const QFileInfo info(sourcePath);
+    Entry entry;
+    entry.name = name;
+    entry.sourcePath = sourcePath;
+    entry.size = info.size();
+    entry.modified = info.lastModified();
+    m_totalBytes += entry.size;
+    m_entries.append(entry);
+}
+
+void ZipWriter::addData(const QString &name, const QByteArray &data, const QDateTime &modified)
+{
+    Entry entry;
+    entry.name = name;
+    entry.data = data;
+    entry.size = data.size();
+    entry.modified = modified;
+    m_totalBytes += entry.size;
+    m_entries.append(entry);
+}
+
+bool ZipWriter::write(const Progress &progress, QString *errorMessage)
+{
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorMessage) {
+            *errorMessage = QString("无法写入文件：%1").arg(m_path);
+        }
+        return false;
+    }
+
+    // 压缩在专用线程池中进行，最多提前准备 2 倍线程数的条目，控制内存占用
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    const int window = 2 * pool.maxThreadCount();
+
+    const int count = m_entries.size();
+    QVector<QFuture<Prepared>> futures(count);
+    auto inMemory = [this](int index) { return m_entries.at(index).size <= kMaxDeflateSize; };
+    int scheduled = 0;
+    auto scheduleNext = [&]() {
+        while (scheduled < count) {
+            const int index = scheduled++;
+            if (inMemory(index)) {
+                const Entry &entry = m_entries.at(index);
+                futures[index] = QtConcurrent::run(&pool, prepareEntry, entry.sourcePath, entry.data);
+                return;
+            }
+        }
+    };
+    for (int i = 0; i < window; ++i) {
+        scheduleNext();
+    }
+
+    QVector<Record> records;
+    records.reserve(count);
+    ContentManifest manifest;
+    qint64 offset = 0;
+    qint64 processed = 0;
+    QString error;
+
+    auto writeBytes = [&file, &offset, &error, this](const QByteArray &bytes) {
+        if (file.write(bytes) != bytes.size()) {
+            error = QString("写入备份文件失败：%1").arg(m_path);
+            return false;
+        }
+        offset += bytes.size();
+        return true;
+    };
+
+    for (int i = 0; i < count && error.isEmpty(); ++i) {
+        const Entry &entry = m_entries.at(i);
+        Record record;
+        record.name = entry.name.toUtf8();
+        record.dosTime = dosDateTime(entry.modified);
+        record.offset = offset;
+
+        if (inMemory(i)) {
+            const Prepared prepared = futures[i].result();
+            futures[i] = QFuture<Prepared>();
+            scheduleNext();
+            if (!prepared.error.isEmpty()) {
+                error = prepared.error;
+                break;
+            }
+            record.method = prepared.method;
+            record.crc = prepared.crc;
+            record.size = prepared.size;
+            record.compressedSize = prepared.payload.size();
+            if (!writeBytes(localHeader(record)) || !writeBytes(prepared.payload)) {
+                break;
+            }
+            manifest.add(entry.name, record.size, prepared.sha256);
+            processed += record.size;
+        } else {
+            // 大文件：分块读取直接写入，CRC 和 SHA-256 边读边算，CRC 写完后回填到本地文件头
+            QFile source(entry.sourcePath);
+            if (!source.open(QIODevice::ReadOnly)) {
+                error = QString("无法读取文件：%1").arg(entry.sourcePath);
+                break;
+            }
+            record.size = entry.size;
+            record.compressedSize = entry.size;
+            if (!writeBytes(localHeader(record))) {
+                break;
+            }
+
+            qint64 copied = 0;
+            quint32 crc = 0;
+            QCryptographicHash sha256(QCryptographicHash::Sha256);
+            while (copied < entry.size) {
+                const QByteArray chunk = source.read(qMin(kChunkSize, entry.size - copied));
+                if (chunk.isEmpty()) {
+                    break;
+                }
+                crc = Crc32::update(crc, chunk.constData(), chunk.size());
+                sha256.addData(chunk);
+                if (!writeBytes(chunk)) {
+                    break;
+                }
+                copied += chunk.size();
+                processed += chunk.size();
+                if (progress && !progress(processed, m_totalBytes)) {
+                    error = "已取消";
+                    break;
+                }
+            }
+            if (!error.isEmpty()) {
+                break;
+            }
+            if (copied != entry.size || !source.atEnd()) {
+                error = QString("读取过程中文件发生变化：%1").arg(entry.sourcePath);
+                break;
+            }
+
+            record.crc = crc;
+            manifest.add(entry.name, record.size, QString::fromLatin1(sha256.result().toHex()));
+            QByteArray crcBytes;
+            put32(&crcBytes, crc);
+            if (!file.seek(record.offset + kLocalHeaderCrcOffset) || file.write(crcBytes) != crcBytes.size()
+                || !file.seek(offset)) {
+                error = QString("写入备份文件失败：%1").arg(m_path);
+                break;
+            }
+        }
+
+        records.append(record);
+        if (progress && !progress(processed, m_totalBytes)) {
+            error = "已取消";
+        }
+    }
+
+    if (error.isEmpty() && !m_manifestName.isEmpty()) {
+        // 内容清单本身不列入清单
+        const Prepared prepared = prepareEntry(QString(), manifest.toJson());
+        Record record;
+        record.name = m_manifestName.toUtf8();
+        record.dosTime = dosDateTime(QDateTime());
+        record.offset = offset;
+        record.method = prepared.method;
+        record.crc = prepared.crc;
+        record.size = prepared.size;
+        record.compressedSize = prepared.payload.size();
+        if (writeBytes(localHeader(record)) && writeBytes(prepared.payload)) {
+            records.append(record);
+        }
+    }
+
+    if (error.isEmpty()) {
+        const qint64 directoryOffset = offset;
+        QByteArray directory;
+        for (const Record &record : qAsConst(records)) {
+            directory.append(centralHeader(record));
+        }
+        if (writeBytes(directory)) {
+            writeBytes(endOfCentralDirectory(records.size(), directoryOffset, directory.size()));
+        }
+    }
+
+    if (!error.isEmpty()) {
+        // 出错或取消：丢弃临时文件，等待仍在压缩的条目结束
+        pool.clear();
+        pool.waitForDone();
+        file.cancelWriting();
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        return false;
+    }
+
+    if (!file.commit()) {
+        if (errorMessage) {
+            *errorMessage = QString("提交备份文件失败：%1").arg(m_path);
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief 流式 ZIP 写入器（ZIP64，只依赖 QtCore）
+ * 条目直接从源文件读取写入归档，不需要先复制到临时目录。
+ * 较小的条目在工作线程中并行读取、计算 CRC 并 deflate，按添加顺序写出；
+ * 超过 kMaxDeflateSize 的大文件在写入线程中分块读取、原样存储（stored），内存占用有上限。
+ * 条目数、文件大小或偏移超过 32 位上限时自动写出 ZIP64 扩展字段和目录尾记录。
+ * 输出先写到临时文件，全部成功后才替换目标路径。
+ * 设置了内容清单名称时，每个条目的 SHA-256 在读取时一并计算（小条目在压缩线程中并行），
+ * 最后作为一个额外条目写入 ContentManifest。
+ */
+class ZipWriter
+{
+public:
+    // 单个条目在内存中压缩的上限，更大的文件直接存储
+    static const qint64 kMaxDeflateSize = 16 * 1024 * 1024;
+
+    // progress(已处理的未压缩字节, 总字节)，在调用 write() 的线程中回调；返回 false 取消写入
+    typedef std::function<bool(qint64, qint64)> Progress;
+
+    explicit ZipWriter(const QString &path);
+
+    // name 为归档内路径，以 / 分隔
+    void addFile(const QString &name, const QString &sourcePath);
+    void addData(const QString &name, const QByteArray &data, const QDateTime &modified = QDateTime());
+    // 在归档末尾写入列出全部条目大小和 SHA-256 的内容清单，为空时不写
+    void setContentManifestName(const QString &name) { m_manifestName = name; }
+
+    int entryCount() const { return m_entries.size(); }
+    qint64 totalBytes() const { return m_totalBytes; }
+
+    bool write(const Progress &progress, QString *errorMessage);
+
+private:
+    struct Entry {
+        QString name;
+        QString sourcePath;   // 为空时使用 data
+        QByteArray data;
+        qint64 size = 0;
+        QDateTime modified;
+    };
+
+    QString m_path;
+    QString m_manifestName;
+    QVector<Entry> m_entries;
+    qint64 m_totalBytes = 0;
+};
+
+#endif // ZIPWRITER_H
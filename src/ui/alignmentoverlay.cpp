@@ -0,0 +1,148 @@
+#include "alignmentoverlay.h"
+#include <QGuiApplication>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPaintEvent>
+#include <QRegion>
+#include <QScreen>
+#include <QWidget>
+
+/**
+ * @brief 单个显示器上的覆盖窗口，覆盖整个显示器，只绘制落在该显示器上的参考线
+ */
+class AlignmentOverlayWindow : public QWidget
+{
+public:
+    explicit AlignmentOverlayWindow(QScreen *screen)
+        : QWidget(nullptr, Qt::Tool | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint
+                               | Qt::WindowTransparentForInput | Qt::WindowDoesNotAcceptFocus
+                               | Qt::NoDropShadowWindowHint)
+    {
+        setAttribute(Qt::WA_TranslucentBackground);
+        setAttribute(Qt::WA_TransparentForMouseEvents);
+        setAttribute(Qt::WA_ShowWithoutActivating);
+        setAttribute(Qt::WA_NoSystemBackground);
+        setGeometry(screen->geometry());
+    }
+
+    void setGuides(const QVector<AlignmentOverlay::Guide> &guides)
+    {
+        if (guides == m_guides) {
+            return;
+        }
+
+        // 只重绘新旧参考线覆盖的区域
+        QRegion dirty;
+        for (const AlignmentOverlay::Guide &guide : qAsConst(m_guides)) {
+            dirty += toLocal(guide.rect);
+        }
+        for (const AlignmentOverlay::Guide &guide : guides) {
+            dirty += toLocal(guide.rect);
+        }
+        m_guides = guides;
+
+        if (m_guides.isEmpty()) {
+            hide();
+            return;
+        }
+        if (!isVisible()) {
+            show();
+            return;
+        }
+        update(dirty);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+
+        for (const AlignmentOverlay::Guide &guide : qAsConst(m_guides)) {
+            const QRect local = toLocal(guide.rect);
+            if (!event->region().intersects(local)) {
+                continue;
+            }
+            switch (guide.kind) {
+            case AlignmentOverlay::Guide::AlignmentBar: {
+                QPainterPath path;
+                path.addRoundedRect(local, 1, 1);
+                painter.fillPath(path, QColor(100, 150, 255, 220));
+                break;
+            }
+            case AlignmentOverlay::Guide::AlignmentSpan:
+                painter.fillRect(local, QColor(100, 150, 255, 110));
+                break;
+            case AlignmentOverlay::Guide::SnapEdge:
+                painter.fillRect(local, QColor(255, 255, 255, 140));
+                break;
+            case AlignmentOverlay::Guide::Collision:
+                painter.fillRect(local, QColor(255, 90, 90, 200));
+                break;
+            }
+        }
+    }
+
+private:
+    QRect toLocal(const QRect &globalRect) const
+    {
+        // 外扩 1 像素，抗锯齿边缘也能被擦除
+        return globalRect.translated(-geometry().topLeft()).adjusted(-1, -1, 1, 1);
+    }
+
+    QVector<AlignmentOverlay::Guide> m_guides;
+};
+
+AlignmentOverlay *AlignmentOverlay::instance()
+{
+    static AlignmentOverlay *instance = new AlignmentOverlay();
+    return instance;
+}
+
+AlignmentOverlayWindow *AlignmentOverlay::windowFor(QScreen *screen)
+{
+    AlignmentOverlayWindow *window = m_windows.value(screen, nullptr);
+    if (window) {
+        return window;
+    }
+
+    window = new AlignmentOverlayWindow(screen);
+    m_windows.insert(screen, window);
+    connect(screen, &QScreen::geometryChanged, window, [window](const QRect &geometry) {
+        window->setGeometry(geometry);
+    });
+    connect(screen, &QObject::destroyed, this, [this, screen]() {
+        delete m_windows.take(screen);
+    });
+    return window;
+}
+
+void AlignmentOverlay::setGuides(const QVector<Guide> &guides)
+{
+    if (guides == m_guides) {
+        return;
+    }
+    m_guides = guides;
+
+    // 按参考线中心所在的显示器分组
+    QHash<QScreen *, QVector<Guide>> byScreen;
+    for (const Guide &guide : guides) {
+        QScreen *screen = QGuiApplication::screenAt(guide.rect.center());
+        if (!screen) {
+            screen = QGuiApplication::primaryScreen();
+        }
+        if (screen) {
+            byScreen[screen].append(guide);
+        }
+    }
+
+    for (auto it = m_windows.cbegin(); it != m_windows.cend(); ++it) {
+        it.value()->setGuides(byScreen.value(it.key()));
+    }
+    for (auto it = byScreen.cbegin(); it != byScreen.cend(); ++it) {
+        if (!m_windows.contains(it.key())) {
+            windowFor(it.key())->setGuides(it.value());
+        }
+    }
+}
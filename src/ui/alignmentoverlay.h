@@ -0,0 +1,52 @@
+#ifndef ALIGNMENTOVERLAY_H
+#define ALIGNMENTOVERLAY_H
+
+#include <QObject>
+#include <QHash>
+#include <QRect>
+#include <QVector>
+
+class QScreen;
+class AlignmentOverlayWindow;
+
+/**
+ * @brief 对齐参考线覆盖层
+ * 每个显示器一个透明、不接收输入的置顶窗口，统一绘制拖动/调整围栏时的对齐线、吸附边和碰撞提示，
+ * 不再显示/隐藏各个围栏窗口里的子控件，调整大小时不会唤醒无关的围栏。
+ * setGuides 只在参考线集合发生变化时重绘，且只重绘新旧参考线所在的区域。
+ */
+class AlignmentOverlay : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Guide {
+        enum Kind {
+            AlignmentBar,   // 参与对齐的围栏边缘
+            AlignmentSpan,  // 连接对齐围栏的细线
+            SnapEdge,       // 已吸附的边
+            Collision       // 被其他围栏挡住的接触边
+        };
+
+        Kind kind;
+        QRect rect; // 全局坐标
+
+        bool operator==(const Guide &other) const { return kind == other.kind && rect == other.rect; }
+        bool operator!=(const Guide &other) const { return !(*this == other); }
+    };
+
+    static AlignmentOverlay *instance();
+
+    void setGuides(const QVector<Guide> &guides);
+    void clear() { setGuides(QVector<Guide>()); }
+
+private:
+    AlignmentOverlay() = default;
+
+    AlignmentOverlayWindow *windowFor(QScreen *screen);
+
+    QVector<Guide> m_guides;
+    QHash<QScreen *, AlignmentOverlayWindow *> m_windows;
+};
+
+#endif // ALIGNMENTOVERLAY_H
@@ -0,0 +1,123 @@
+#include "fencechromecache.h"
+#include <QHash>
+#include <QPainter>
+#include <QPainterPath>
+#include <QtMath>
+
+namespace {
+// 源图中间可拉伸部分的逻辑尺寸，只需若干像素的均匀区域
+const int kStretch = 8;
+// 键空间很小（颜色 x 缩放比 x 折叠状态，外加折叠动画中的少量高度），按条目数限制
+const int kMaxEntries = 32;
+}
+
+uint qHash(const FenceChromeCache::Key &key, uint seed)
+{
+    return qHash(key.background, seed)
+        ^ qHash((key.dprPercent << 17) | (key.height << 1) | (key.collapsed ? 1 : 0), seed);
+}
+
+FenceChromeCache *FenceChromeCache::instance()
+{
+    static FenceChromeCache cache;
+    return &cache;
+}
+
+FenceChromeCache::FenceChromeCache()
+    : m_cache(kMaxEntries)
+{
+}
+
+QPixmap FenceChromeCache::render(const QSize &logicalSize, qreal dpr, const QColor &background, bool collapsed)
+{
+    QPixmap pixmap(qCeil(logicalSize.width() * dpr), qCeil(logicalSize.height() * dpr));
+    pixmap.setDevicePixelRatio(dpr);
+    pixmap.fill(Qt::transparent);
+
+    const QRect rect(QPoint(0, 0), logicalSize);
+    QPainter p(&pixmap);
+    p.setRenderHint(QPainter::Antialiasing);
+
+    QPainterPath path;
+    path.addRoundedRect(rect, kCornerRadius, kCornerRadius);
+
+    // 绘制背景 (使用自定义颜色)
+    p.fillPath(path, background);
+
+    // 标题栏稍微深一点，与内容区进行视觉区分，减轻一点透明度让它不至于太黑
+    p.setClipPath(path);
+    p.fillRect(QRect(0, 0, rect.width(), kTitleBarHeight), QColor(0, 0, 0, 40));
+    p.setClipping(false);
+
+    // 边框
+    p.setPen(QPen(QColor(255, 255, 255, 30), 1));
+    p.drawPath(path);
+
+    // 标题栏分隔线
+    if (!collapsed) {
+        p.setPen(QPen(QColor(255, 255, 255, 20), 1));
+        p.drawLine(kCornerRadius, kTitleBarHeight, rect.width() - kCornerRadius, kTitleBarHeight);
+    }
+
+    return pixmap;
+}
+
+void FenceChromeCache::paint(QPainter *painter, const QSize &size, qreal dpr, const QColor &background,
+                             bool collapsed)
+{
+    // 切片尺寸按设备像素取整，目标矩形再换算回逻辑坐标，保证切片边界落在整像素上
+    const int capDev = qCeil((kCornerRadius + 1) * dpr);
+    const int topDev = qCeil((kTitleBarHeight + 2) * dpr);
+    const int bottomDev = capDev;
+
+    if (size.width() * dpr < 2 * capDev + 1) {
+        // 窄到放不下左右切片，直接绘制
+        painter->drawPixmap(QPoint(0, 0), render(size, dpr, background, collapsed));
+        return;
+    }
+
+    const bool nine = size.height() * dpr >= topDev + bottomDev + 1;
+    const QSize sourceSize(2 * (kCornerRadius + 1) + kStretch,
+                           nine ? kTitleBarHeight + 2 + kCornerRadius + 1 + kStretch : size.height());
+
+    const Key key{background.rgba(), qRound(dpr * 100), collapsed, nine ? 0 : size.height()};
+    QPixmap source;
+    if (const QPixmap *cached = m_cache.object(key)) {
+        source = *cached;
+    } else {
+        source = render(sourceSize, dpr, background, collapsed);
+        m_cache.insert(key, new QPixmap(source));
+    }
+
+    const qreal w = size.width();
+    const qreal h = size.height();
+    const qreal cap = capDev / dpr;
+    const int srcW = source.width();
+    const int srcH = source.height();
+
+    // 三列：左圆角 | 拉伸 | 右圆角
+    const qreal dstX[4] = {0, cap, w - cap, w};
+    const int srcX[4] = {0, capDev, srcW - capDev, srcW};
+
+    // 九宫格时三行：标题栏与上圆角 | 拉伸 | 下圆角；否则只有一行
+    qreal dstY[4] = {0, h, h, h};
+    int srcY[4] = {0, srcH, srcH, srcH};
+    int rows = 1;
+    if (nine) {
+        dstY[1] = topDev / dpr;
+        dstY[2] = h - bottomDev / dpr;
+        srcY[1] = topDev;
+        srcY[2] = srcH - bottomDev;
+        rows = 3;
+    }
+
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            const QRectF target(QPointF(dstX[col], dstY[row]), QPointF(dstX[col + 1], dstY[row + 1]));
+            const QRectF sourceRect(QPointF(srcX[col], srcY[row]), QPointF(srcX[col + 1], srcY[row + 1]));
+            if (!target.isEmpty() && !sourceRect.isEmpty()) {
+                painter->drawPixmap(target, source, sourceRect);
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef FENCECHROMECACHE_H
+#define FENCECHROMECACHE_H
+
+#include <QCache>
+#include <QColor>
+#include <QPixmap>
+
+class QPainter;
+
+/**
+ * @brief 围栏外框（圆角背景、标题栏、边框、分隔线）的九宫格缓存（仅限 GUI 线程）
+ * 以 背景色 + 设备像素比 + 折叠状态 为键，只渲染一次最小尺寸的外框，
+ * 绘制时按九宫格切片拉伸贴到窗口上，不再每次重绘都构造圆角路径并抗锯齿填充。
+ * 切片边界按设备像素计算，非整数缩放比下也不会出现接缝。
+ * 窗口过矮（如折叠状态）放不下上下两排切片时，按实际高度渲染并只做水平三段拉伸。
+ */
+class FenceChromeCache
+{
+public:
+    static const int kCornerRadius = 10;
+    static const int kTitleBarHeight = 32;
+
+    static FenceChromeCache *instance();
+
+    void paint(QPainter *painter, const QSize &size, qreal dpr, const QColor &background, bool collapsed);
+
+    void clear() { m_cache.clear(); }
+
+private:
+    FenceChromeCache();
+
+    struct Key {
+        QRgb background;
+        int dprPercent;
+        bool collapsed;
+        int height; // 0 表示九宫格源图，否则为三段拉伸源图的实际高度
+        bool operator==(const Key &other) const
+        {
+            return background == other.background && dprPercent == other.dprPercent
+                && collapsed == other.collapsed && height == other.height;
+        }
+    };
+    friend uint qHash(const Key &key, uint seed);
+
+    static QPixmap render(const QSize &logicalSize, qreal dpr, const QColor &background, bool collapsed);
+
+    QCache<Key, QPixmap> m_cache;
+};
+
+#endif // FENCECHROMECACHE_H
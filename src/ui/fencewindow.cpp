@@ -1,10 +1,18 @@
 #include "fencewindow.h"
 #include "iconwidget.h"
+#include "icongridview.h"
 #include "flowlayout.h"
+#include "alignmentoverlay.h"
+#include "fencechromecache.h"
 #include "../platform/blurhelper.h"
 #include "src/core/fencemanager.h"
 #include "src/core/configmanager.h"
 #include "src/core/iconhelper.h"
+#include "src/core/iconcache.h"
+#include "src/core/fileoperationqueue.h"
+#include "src/core/iconloadscheduler.h"
+#include "src/core/storageindex.h"
+#include "src/core/logger.h"
 #include "stylehelper.h"
 
 #include <QPainter>
@@ -12,7 +20,6 @@
 #include <QMouseEvent>
 #include <QMenu>
 #include <QJsonObject>
-#include <QtConcurrent>
 #include <QJsonArray>
 #include <QScreen>
 #include <QApplication>
@@ -29,6 +36,9 @@
 #include <QDebug>
 #include <QTimer>
 #include <QColorDialog>
+#include <QElapsedTimer>
+#include <QSet>
+#include <memory>
 #include "../platform/desktophelper.h"
 
 #ifdef Q_OS_WIN
@@ -54,13 +64,6 @@
 #endif
 #endif
 
-
-
-// 日志记录函数
-void logToDesktop(const QString &msg) {
-    ConfigManager::writeLog(msg);
-}
-
 namespace {
 QString normalizePath(const QString &path)
 {
@@ -80,6 +83,170 @@ QString displayNameForFile(const QFileInfo &fileInfo)
     }
     return name;
 }
+
+// 文件已移回桌面：恢复原来的桌面坐标并通知 Shell 刷新
+void announceRestoredFile(const QString &targetPath, const QPoint &originalPos)
+{
+    // 先设置图标位置（在通知系统之前）
+    if (originalPos.x() >= 0 && originalPos.y() >= 0) {
+        DesktopHelper::setIconPosition(targetPath, originalPos);
+        LOG_DEBUG(Logger::Fence, "[removeIcon] Set icon position immediately: " + QString::number(originalPos.x()) + "," + QString::number(originalPos.y()));
+    }
+
+    // 然后通知系统文件已添加
+    DesktopHelper::notifyFileAdded(targetPath);
+    const QString desktopPath = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
+    std::wstring wDesktop = QDir::toNativeSeparators(desktopPath).toStdWString();
+    SHChangeNotify(SHCNE_UPDATEDIR, SHCNF_PATHW, wDesktop.c_str(), NULL);
+
+    // 再次设置位置（作为保险，因为系统刷新可能会重置位置）
+    if (originalPos.x() >= 0 && originalPos.y() >= 0) {
+        QTimer::singleShot(100, [targetPath, originalPos]() {
+            DesktopHelper::setIconPosition(targetPath, originalPos);
+        });
+    }
+}
+
+struct IconRestoreTask {
+    int index = 0;
+    QString name;
+    QString savedPath;
+    QString originalSourcePath;
+    bool isFromDesktop = false;
+    bool alwaysRunAsAdmin = false;
+    QPoint originalPos;
+};
+
+// 工作线程的产出：只含可跨线程的数据，QPixmap 在 GUI 线程中创建
+struct LoadedIcon {
+    IconRestoreTask task;
+    QString path;
+    bool found = false;
+    QImage image;
+};
+
+struct IconRestoreProgress {
+    int remaining = 0;
+};
+
+// 占位图标：控件模式下是 IconWidget，虚拟化网格模式下是网格中的图标 id
+struct IconPlaceholder {
+    QPointer<IconWidget> widget;
+    quint64 gridId = 0;
+};
+
+// 已提取完成、等待在 GUI 线程中分批套用到占位图标上的结果
+struct PendingIconDelivery {
+    QPointer<FenceWindow> fence;
+    IconPlaceholder placeholder;
+    LoadedIcon loaded;
+    std::shared_ptr<IconRestoreProgress> progress;
+};
+
+// 每帧（约 16ms）最多花 8ms 套用图标，其余时间留给绘制和输入
+const int kIconBatchBudgetMs = 8;
+const int kIconBatchIntervalMs = 16;
+
+QList<PendingIconDelivery> s_pendingIconDeliveries;
+
+// 配置阈值 <= 0 表示不使用虚拟化网格
+bool shouldVirtualize(int iconCount)
+{
+    const int threshold = ConfigManager::instance()->iconVirtualizeThreshold();
+    return threshold > 0 && iconCount >= threshold;
+}
+
+// 在调度器工作线程中执行：解析（必要时修复）图标路径并提取图标
+LoadedIcon loadRestoredIcon(const IconRestoreTask &task, const QString &fenceId,
+                            const QString &storageBase, const QString &storageRoot, int iconPixelSize)
+{
+    LoadedIcon loaded;
+    loaded.task = task;
+
+    QString path = IconHelper::fromStoragePath(task.savedPath, fenceId);
+    QFileInfo fileInfo(path);
+
+    bool exists = fileInfo.exists();
+    LOG_DEBUG(Logger::Icon, "[loadRestoredIcon] Processing: " + task.name + " (" + path + ") exists:" + QString::number(exists));
+
+    if (!exists) {
+#ifdef Q_OS_WIN
+        std::wstring wPath = path.toStdWString();
+        DWORD attr = GetFileAttributesW(wPath.c_str());
+        if (attr != INVALID_FILE_ATTRIBUTES) {
+            exists = true;
+            fileInfo.setFile(path);
+            fileInfo.refresh();
+            LOG_DEBUG(Logger::Icon, "[loadRestoredIcon]   Windows API detected file exists: " + path);
+        }
+#endif
+    }
+
+    bool fixed = false;
+    if (!exists) {
+        QString fileName = fileInfo.fileName();
+        if (fileName.isEmpty()) fileName = task.name + ".lnk";
+
+        // 在共享的存储文件名索引中查找：优先本围栏目录，其次其他围栏目录；
+        // 索引已覆盖全部存储目录，未命中无需再访问文件系统
+        const QString found = StorageIndex::instance()->find(storageRoot, fileName, storageBase);
+        if (!found.isEmpty()) {
+            path = found;
+            fixed = true;
+            LOG_DEBUG(Logger::Icon, "[loadRestoredIcon]   Storage index SUCCESS: fixed path to " + path);
+        }
+    }
+
+    loaded.path = QDir::toNativeSeparators(QDir::cleanPath(path));
+    loaded.found = exists || fixed;
+    if (loaded.found) {
+        loaded.image = IconHelper::getCachedWinImage(loaded.path, iconPixelSize);
+        LOG_DEBUG(Logger::Icon, "[loadRestoredIcon]   Icon extraction: " + QString(loaded.image.isNull() ? "FAILED" : "OK"));
+    } else {
+        LOG_WARN(Logger::Icon, "[loadRestoredIcon]   File not found even after fallback, keeping entry with fallback icon: " + loaded.path);
+    }
+    return loaded;
+}
+
+// GUI 线程：把工作线程结果转换为 IconWidget 数据，提取失败时使用系统图标
+IconWidget::IconData iconDataFromLoaded(const LoadedIcon &loaded)
+{
+    IconWidget::IconData data;
+    data.name = loaded.task.name;
+    data.path = loaded.path;
+    data.targetPath = data.path;
+
+    if (!loaded.image.isNull()) {
+        data.icon = QPixmap::fromImage(loaded.image);
+    } else {
+        QFileIconProvider iconProvider;
+        data.icon = loaded.found
+            ? iconProvider.icon(QFileInfo(loaded.path)).pixmap(48, 48)
+            : iconProvider.icon(QFileIconProvider::File).pixmap(48, 48);
+    }
+
+    if (loaded.task.isFromDesktop) {
+        data.isFromDesktop = true;
+        data.originalPosition = loaded.task.originalPos;
+        data.originalSourcePath = loaded.task.originalSourcePath;
+    }
+    data.alwaysRunAsAdmin = loaded.task.alwaysRunAsAdmin;
+    return data;
+}
+
+// 用保存的图标记录更新已有图标的元数据（名称、桌面来源、启动方式），保留已提取的图标
+void applyIconJson(IconWidget::IconData *data, const QJsonObject &iconObj)
+{
+    data->name = iconObj["name"].toString(data->name);
+    data->isFromDesktop = iconObj["isFromDesktop"].toBool();
+    data->originalPosition = data->isFromDesktop
+        ? QPoint(iconObj["originalX"].toInt(), iconObj["originalY"].toInt())
+        : QPoint(-1, -1);
+    data->originalSourcePath = data->isFromDesktop && iconObj.contains("originalSourcePath")
+        ? normalizePath(iconObj["originalSourcePath"].toString())
+        : QString();
+    data->alwaysRunAsAdmin = iconObj["alwaysRunAsAdmin"].toBool();
+}
 }
 
 // 静态成员初始化
@@ -87,6 +254,7 @@ HHOOK FenceWindow::s_hKeyboardHook = NULL;
 QSet<FenceWindow*> FenceWindow::s_allFences;
 HHOOK FenceWindow::s_hMouseHook = NULL;
 QPointer<FenceWindow> FenceWindow::s_editingFence;
+quint64 FenceWindow::s_nextSerializationRevision = 0;
 
 // 键盘钩子回调函数
 LRESULT CALLBACK FenceWindow::KeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
@@ -236,6 +404,19 @@ FenceWindow::FenceWindow(const QString &title, QWidget *parent)
     m_saveTimer->setSingleShot(true);
     m_saveTimer->setInterval(1000); // 1秒后保存
     connect(m_saveTimer, &QTimer::timeout, this, &FenceWindow::geometryChanged);
+
+    // 拖动/调整大小时按显示帧合并鼠标移动
+    m_moveFrameTimer = new QTimer(this);
+    m_moveFrameTimer->setSingleShot(true);
+    m_moveFrameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_moveFrameTimer, &QTimer::timeout, this, &FenceWindow::flushPendingMove);
+
+    // 所有触发保存的信号都意味着序列化结果可能已变化；
+    // 这些连接先于 FenceManager 建立，因此会在 saveFences 之前执行
+    connect(this, &FenceWindow::geometryChanged, this, &FenceWindow::invalidateSerialization);
+    connect(this, &FenceWindow::titleChanged, this, &FenceWindow::invalidateSerialization);
+    connect(this, &FenceWindow::collapsedChanged, this, &FenceWindow::invalidateSerialization);
+    connect(this, &FenceWindow::collapsedChanged, this, &FenceWindow::updateIconLoadPriority);
     
     // 在 setupUi 之前先隐藏窗口，防止在设置过程中显示
     setVisible(false);
@@ -246,6 +427,16 @@ FenceWindow::FenceWindow(const QString &title, QWidget *parent)
 FenceWindow::~FenceWindow()
 {
     m_isClosing = true;
+
+    // 丢弃尚未开始的图标加载任务和尚未送达的结果
+    IconLoadScheduler::instance()->cancel(this);
+    // 尚未开始的文件操作不再执行（已执行未确认的转为放弃确认，由下次启动时恢复）
+    FileOperationQueue::instance()->cancel(this);
+
+    // 拖动或调整大小途中被销毁时，参考线不能留在屏幕上
+    if (m_isDragging || m_isResizing) {
+        AlignmentOverlay::instance()->clear();
+    }
     
     // 如果当前窗口正在编辑，清理鼠标钩子
     if (s_editingFence.data() == this) {
@@ -328,11 +519,6 @@ void FenceWindow::setupUi()
     
     updatePlaceholder();
 
-    m_bottomAlignmentGuide = new QWidget(this);
-    m_bottomAlignmentGuide->setAttribute(Qt::WA_TransparentForMouseEvents);
-    m_bottomAlignmentGuide->setStyleSheet("background-color: rgba(100, 150, 255, 220); border-radius: 1px;");
-    m_bottomAlignmentGuide->setGeometry(8, height() - 3, qMax(24, width() - 16), 3);
-    m_bottomAlignmentGuide->hide();
 }
 
 void FenceWindow::setupBlurEffect()
@@ -348,6 +534,7 @@ void FenceWindow::setupBlurEffect()
 void FenceWindow::showEvent(QShowEvent *event)
 {
     QWidget::showEvent(event);
+    updateIconLoadPriority();
     
     // 只在第一次显示时调用 setWindowToDesktop
     if (!m_desktopEmbedded) {
@@ -391,14 +578,15 @@ void FenceWindow::resizeEvent(QResizeEvent *event)
     if (!m_collapsed) {
         m_expandedHeight = height();
     }
+    invalidateSerialization();
 
     // 更新占位提示位置
     if (m_placeholderLabel) {
         m_placeholderLabel->setGeometry(m_contentArea->rect());
     }
 
-    // 触发保存（使用防抖动延迟）
-    if (!m_restoringFromJson && m_saveTimer) {
+    // 触发保存（使用防抖动延迟）；拖拽/调整大小结束时会统一保存，过程中不必反复重启定时器
+    if (!m_restoringFromJson && m_saveTimer && !m_isDragging && !m_isResizing) {
         m_saveTimer->start();
     }
 }
@@ -407,6 +595,7 @@ void FenceWindow::setBackgroundColor(const QColor &color)
 {
     if (m_backgroundColor != color) {
         m_backgroundColor = color;
+        invalidateSerialization();
         update(); // 触发重绘
         if (!m_restoringFromJson && m_saveTimer) m_saveTimer->start(); // 触发保存
     }
@@ -440,36 +629,43 @@ void FenceWindow::setCollapsed(bool collapsed)
             finishTitleEdit();
         }
 
-        m_collapsed = collapsed;
-        
-        // 停止现有动画
-        if (m_collapseAnimation) {
+        // 停止现有动画；被打断时从当前显示的高度继续
+        int startHeight = height();
+        if (m_collapseAnimation && m_collapseAnimation->state() != QAbstractAnimation::Stopped) {
             m_collapseAnimation->stop();
+            startHeight = m_revealHeight;
+            endCollapseSnapshot(!m_collapsed);
         }
 
-        int startHeight = height();
+        m_collapsed = collapsed;
         int endHeight = 0;
 
         // 统一在动画开始前解除所有尺寸限制
         setMinimumHeight(0);
         setMaximumHeight(16777215);
 
+        // 动画期间窗口保持两端中较高的尺寸，只按显示高度绘制外框和内容快照：
+        // 真实几何只在开始（展开）和结束（折叠）时各改变一次
         if (collapsed) {
             // 折叠
             m_expandedHeight = height();
             if (m_expandedHeight < 64) m_expandedHeight = 200; 
             
             endHeight = 32;
-            m_contentArea->setVisible(false);
+            beginCollapseSnapshot();
         } else {
-            // 展开
+            // 展开：先一次性调整到最终高度并完成布局，再截取内容快照
             endHeight = m_expandedHeight;
             if (endHeight < 64) endHeight = 200;
             
+            resize(width(), endHeight);
             m_contentArea->setVisible(true);
+            layout()->activate();
+            beginCollapseSnapshot();
         }
+        m_revealHeight = startHeight;
 
-        // 创建新的变量动画直接控制高度
+        // 创建新的变量动画，只控制显示高度
         if (!m_collapseAnimation) {
              m_collapseAnimation = new QVariantAnimation(this);
         }
@@ -483,17 +679,15 @@ void FenceWindow::setCollapsed(bool collapsed)
         m_collapseAnimation->disconnect(this);
 
         connect(m_collapseAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-            // 使用 Windows API 直接设置高度，绕过 Qt 的几何约束
-#ifdef Q_OS_WIN
-            HWND hWnd = (HWND)winId();
-            SetWindowPos(hWnd, NULL, 0, 0, width(), value.toInt(), 
-                        SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-#else
-            resize(width(), value.toInt());
-#endif
+            // 只重绘新旧底边之间（含下圆角）的条带
+            const int previous = m_revealHeight;
+            m_revealHeight = value.toInt();
+            const int top = qMin(previous, m_revealHeight) - FenceChromeCache::kCornerRadius - 2;
+            update(QRect(0, top, width(), qAbs(m_revealHeight - previous) + FenceChromeCache::kCornerRadius + 4));
         });
 
         connect(m_collapseAnimation, &QVariantAnimation::finished, this, [this, collapsed, endHeight]() {
+            endCollapseSnapshot(!collapsed);
             // 动画结束，应用最终状态的限制
             if (collapsed) {
                 setMinimumHeight(32);
@@ -503,6 +697,7 @@ void FenceWindow::setCollapsed(bool collapsed)
                 setMaximumHeight(16777215); // 解除最大高度限制
                 resize(width(), endHeight); // 确保最终高度正确
             }
+            update();
             emit collapsedChanged(collapsed);
             emit geometryChanged();
         });
@@ -511,20 +706,45 @@ void FenceWindow::setCollapsed(bool collapsed)
     }
 }
 
+void FenceWindow::beginCollapseSnapshot()
+{
+    // 内容区只渲染一次；隐藏期间保留其在布局中的位置，避免标题栏被重新布局
+    m_collapseSnapshot = m_contentArea->grab();
+    m_collapseSnapshotPos = m_contentArea->pos();
+
+    QSizePolicy policy = m_contentArea->sizePolicy();
+    policy.setRetainSizeWhenHidden(true);
+    m_contentArea->setSizePolicy(policy);
+    m_contentArea->setVisible(false);
+}
+
+void FenceWindow::endCollapseSnapshot(bool contentVisible)
+{
+    m_collapseSnapshot = QPixmap();
+    m_revealHeight = -1;
+
+    QSizePolicy policy = m_contentArea->sizePolicy();
+    policy.setRetainSizeWhenHidden(false);
+    m_contentArea->setSizePolicy(policy);
+    m_contentArea->setVisible(contentVisible);
+}
+
 void FenceWindow::addIcon(IconWidget *icon)
 {
     if (!icon) return;
 
+    beginIconUpdate();
+    addIconAt(icon, iconCount());
+    endIconUpdate();
+}
 
+bool FenceWindow::addIconAt(IconWidget *icon, int index)
+{
     // 检查是否已存在相同路径的图标 (路径比较不区分大小写且归一化)
-    QString newPath = QDir::toNativeSeparators(QDir::cleanPath(icon->path()));
-    for (IconWidget *existingIcon : qAsConst(m_icons)) {
-        QString existingPath = QDir::toNativeSeparators(QDir::cleanPath(existingIcon->path()));
-        if (QString::compare(existingPath, newPath, Qt::CaseInsensitive) == 0) {
-            logToDesktop("  Icon already exists: " + newPath + ", deleting duplicate");
-            icon->deleteLater();
-            return;
-        }
+    if (containsIconPath(icon->path())) {
+        LOG_DEBUG(Logger::Fence, "  Icon already exists: " + normalizePath(icon->path()) + ", deleting duplicate");
+        icon->deleteLater();
+        return false;
     }
 
     // 连接删除信号
@@ -537,22 +757,30 @@ void FenceWindow::addIcon(IconWidget *icon)
         }
     });
 
-    insertIconAt(icon, m_icons.size());
+    insertIconAt(icon, index);
     
-    logToDesktop("  Icon successfully added to layout. Count: " + QString::number(m_icons.size()));
-    
-    updatePlaceholder();
-    if (!m_restoringFromJson) {
-        emit geometryChanged(); // 保存更改
-    }
+    LOG_DEBUG(Logger::Fence, "  Icon successfully added to layout. Count: " + QString::number(iconCount()));
+    return true;
 }
 
 void FenceWindow::insertIconAt(IconWidget *icon, int index)
 {
     if (!icon) return;
 
+    beginIconUpdate();
+    m_iconsChanged = true;
+
+    if (m_gridView) {
+        // 网格只保存图标数据，控件本身不再需要
+        m_gridView->insertIcon(index, icon->data(), icon->isLoading());
+        icon->deleteLater();
+        endIconUpdate();
+        return;
+    }
+
     const int boundedIndex = qBound(0, index, m_icons.size());
     m_icons.insert(boundedIndex, icon);
+    m_iconIndexValid = false;
 
     icon->setTextVisible(ConfigManager::instance()->iconTextVisible());
     icon->setParent(m_contentArea);
@@ -565,165 +793,508 @@ void FenceWindow::insertIconAt(IconWidget *icon, int index)
 
     icon->show();
 
-    m_contentLayout->invalidate();
-    m_contentLayout->update();
-    m_contentArea->updateGeometry();
-    m_contentArea->update();
-    update();
+    m_iconLayoutDirty = true;
+    endIconUpdate();
+}
+
+void FenceWindow::beginIconUpdate()
+{
+    ++m_iconUpdateDepth;
+}
+
+void FenceWindow::endIconUpdate()
+{
+    Q_ASSERT(m_iconUpdateDepth > 0);
+    if (--m_iconUpdateDepth > 0) {
+        return;
+    }
+
+    if (m_iconLayoutDirty) {
+        m_iconLayoutDirty = false;
+        m_contentLayout->invalidate();
+        m_contentLayout->update();
+        m_contentArea->updateGeometry();
+        m_contentArea->update();
+        update();
+    }
+
+    // 恢复期间的占位图标由 fromJson 统一决定显示方式，此处只处理之后的增长
+    if (!m_restoringFromJson && !m_gridView && shouldVirtualize(m_icons.size())) {
+        switchToGridView();
+    }
+
+    updatePlaceholder();
+
+    if (m_iconsChanged) {
+        m_iconsChanged = false;
+        if (m_restoringFromJson) {
+            invalidateSerialization(); // 恢复期间不触发保存，只让序列化缓存失效
+        } else {
+            emit geometryChanged(); // 保存更改
+        }
+    }
+}
+
+void FenceWindow::switchToGridView()
+{
+    if (m_gridView) return;
+
+    m_gridView = new IconGridView(m_contentArea);
+    m_gridView->setGeometry(m_contentArea->rect());
+    m_gridView->setTextVisible(ConfigManager::instance()->iconTextVisible());
+    // 与内容区域一样参与边缘光标更新
+    m_gridView->viewport()->installEventFilter(this);
+    connect(m_gridView, &IconGridView::removeRequested, this, &FenceWindow::removeGridIcon);
+    connect(m_gridView, &IconGridView::launchPreferenceChanged, this, [this]() {
+        if (!m_restoringFromJson) {
+            emit geometryChanged();
+        }
+    });
+
+    const QList<IconWidget*> widgets = m_icons;
+    m_icons.clear();
+    m_iconIndexValid = false;
+    for (IconWidget *icon : widgets) {
+        m_contentLayout->removeWidget(icon);
+        m_gridView->insertIcon(m_gridView->count(), icon->data(), icon->isLoading());
+        icon->hide();
+        icon->deleteLater();
+    }
+
+    m_gridView->show();
+    LOG_INFO(Logger::Fence, QString("[switchToGridView] %1 now uses the virtualized icon grid (%2 icons)")
+                                .arg(m_title)
+                                .arg(m_gridView->count()));
+}
+
+int FenceWindow::iconCount() const
+{
+    return m_gridView ? m_gridView->count() : m_icons.size();
+}
+
+bool FenceWindow::containsIconPath(const QString &path) const
+{
+    // 路径比较不区分大小写且归一化
+    if (m_gridView) {
+        return m_gridView->indexOfPath(path) >= 0;
+    }
+    const QString normalized = normalizePath(path);
+    for (IconWidget *existingIcon : qAsConst(m_icons)) {
+        if (QString::compare(normalizePath(existingIcon->path()), normalized, Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FenceWindow::discardIconEntry(const QString &path)
+{
+    if (m_gridView) {
+        m_gridView->removeAt(m_gridView->indexOfPath(path));
+    } else {
+        const QString normalized = normalizePath(path);
+        for (IconWidget *icon : qAsConst(m_icons)) {
+            if (QString::compare(normalizePath(icon->path()), normalized, Qt::CaseInsensitive) == 0) {
+                m_icons.removeOne(icon);
+                m_iconIndexValid = false;
+                m_contentLayout->removeWidget(icon);
+                icon->hide();
+                icon->deleteLater();
+                break;
+            }
+        }
+    }
+    updatePlaceholder();
+    invalidateSerialization();
+}
+
+int FenceWindow::indexOfDraggedIcon(const QMimeData *mimeData) const
+{
+    if (m_gridView) {
+        return m_gridView->indexOfPath(QString::fromUtf8(mimeData->data("application/x-deskgo-icon")));
+    }
+
+    // 来自虚拟化网格的拖拽没有 id，这类图标不可能在控件模式的围栏中
+    bool ok = false;
+    const quint64 id = mimeData->data(IconWidget::idMimeType()).toULongLong(&ok);
+    if (!ok) {
+        return -1;
+    }
+    if (!m_iconIndexValid) {
+        m_iconIndexById.clear();
+        m_iconIndexById.reserve(m_icons.size());
+        for (int i = 0; i < m_icons.size(); ++i) {
+            m_iconIndexById.insert(m_icons.at(i)->id(), i);
+        }
+        m_iconIndexValid = true;
+    }
+    return m_iconIndexById.value(id, -1);
+}
+
+QRect FenceWindow::dropIndicatorDirtyRect() const
+{
+    if (!m_showDropIndicator || m_dropIndicatorRect.isNull()) {
+        return QRect();
+    }
+    // 外扩覆盖圆角描边的抗锯齿像素
+    return m_dropIndicatorRect.translated(m_contentArea->pos()).adjusted(-2, -2, 2, 2);
+}
+
+void FenceWindow::setDropIndicator(int index, const QRect &rect)
+{
+    const QRect oldRect = dropIndicatorDirtyRect();
+    m_showDropIndicator = !rect.isNull();
+    m_dropIndicatorIndex = index;
+    m_dropIndicatorRect = rect;
+    const QRect newRect = dropIndicatorDirtyRect();
+    if (newRect != oldRect) {
+        update(oldRect);
+        update(newRect);
+    }
 }
 
 void FenceWindow::clearDropIndicator()
 {
+    const QRect oldRect = dropIndicatorDirtyRect();
     m_showDropIndicator = false;
     m_dropIndicatorIndex = -1;
     m_dropIndicatorRect = QRect();
+    if (!oldRect.isNull()) {
+        update(oldRect);
+    }
+}
+
+QRect FenceWindow::fileOperationProgressRect() const
+{
+    const int inset = FenceChromeCache::kCornerRadius;
+    return QRect(inset, FenceChromeCache::kTitleBarHeight - 2, qMax(0, width() - 2 * inset), 2);
+}
+
+void FenceWindow::beginFileOperations(int count)
+{
+    m_fileOpsTotal += count;
+    update(fileOperationProgressRect());
+}
+
+void FenceWindow::fileOperationDone()
+{
+    ++m_fileOpsDone;
+    if (m_fileOpsDone >= m_fileOpsTotal) {
+        m_fileOpsDone = 0;
+        m_fileOpsTotal = 0;
+    }
+    update(fileOperationProgressRect());
+}
+
+void FenceWindow::completeCrossFenceMove(FenceWindow *sourceFence, const IconWidget::IconData &data,
+                                         const QString &oldPath, int targetIndex, quint64 transaction)
+{
+    // 从源围栏移除（不删除文件，只从列表和布局中移除）
+    if (sourceFence) {
+        sourceFence->discardIconEntry(oldPath);
+        emit sourceFence->geometryChanged();  // 触发源围栏保存
+    }
+
+    // 创建新的 IconWidget 并按插入符位置插入到当前围栏
+    IconWidget *newIcon = new IconWidget(data);
+    connect(newIcon, &IconWidget::removeRequested, [this, newIcon]() {
+        removeIcon(newIcon);
+    });
+    insertIconAt(newIcon, qMin(targetIndex, iconCount()));  // 同时触发当前围栏保存
+
+    FenceManager::instance()->saveFences();
+    if (!ConfigManager::instance()->sync()) {
+        LOG_WARN(Logger::Drag, "[dropEvent] Cross-fence move committed in memory but failed to sync immediately.");
+        if (transaction) {
+            FileOperationQueue::instance()->retire(transaction);
+        }
+    } else if (transaction) {
+        FileOperationQueue::instance()->acknowledge(transaction);
+    }
+}
+
+IconWidget::IconData FenceWindow::iconDataForFile(const QString &path) const
+{
+    // 确保对 path（即移动后的新位置）进行 QFileInfo 包装，获取最新的元数据
+    QFileInfo fileInfo(path);
+    QFileIconProvider iconProvider;
+
+    IconWidget::IconData data;
+    data.name = displayNameForFile(fileInfo);
+    data.path = path;
+    data.targetPath = path;
+    qDebug() << "    Creating icon with name:" << data.name << "path:" << data.path;
+
+    // 优先使用 WinAPI 获取图标（对快捷方式取 .lnk 自身的图标，而不是目标文件）
+    data.icon = IconHelper::getCachedWinIcon(path, IconHelper::kIconDisplaySize * devicePixelRatio());
+    qDebug() << "    getWinIcon result:" << (data.icon.isNull() ? "NULL" : QString("OK, size: %1x%2").arg(data.icon.width()).arg(data.icon.height()));
+
+    if (data.icon.isNull()) {
+        data.icon = iconProvider.icon(fileInfo).pixmap(48, 48);
+        qDebug() << "    iconProvider fallback result:" << (data.icon.isNull() ? "NULL" : "OK");
+    }
+
+    if (data.icon.isNull()) {
+        data.icon = iconProvider.icon(QFileIconProvider::File).pixmap(48, 48);
+        qDebug() << "    Final fallback result:" << (data.icon.isNull() ? "NULL" : "OK");
+    }
+    return data;
+}
+
+void FenceWindow::moveDesktopFilesIn(const QList<FileOperationQueue::Operation> &moves,
+                                     const QVector<QPoint> &positions)
+{
+    auto transaction = std::make_shared<quint64>(0);
+    auto committed = std::make_shared<QList<FileOperationQueue::Result>>();
+    auto failedNames = std::make_shared<QStringList>();
+
+    beginFileOperations(moves.size());
+    *transaction = FileOperationQueue::instance()->submit(this, moves,
+        [this, committed, failedNames](const FileOperationQueue::Result &result) {
+            fileOperationDone();
+            if (!result.committed) {
+                qDebug() << "    Move FATAL! Source:" << result.source << result.error;
+                failedNames->append(QFileInfo(result.source).fileName());
+                return;
+            }
+
+            // 文件已离开桌面，先通知 shell 更新；图标在整批结束后一次加入
+            DesktopHelper::notifyFileRemoved(result.source);
+            committed->append(result);
+        },
+        [this, positions, transaction, committed, failedNames](int, int) {
+            if (!committed->isEmpty()) {
+                // 整批只布局、刷新并标记保存一次
+                beginIconUpdate();
+                for (const FileOperationQueue::Result &result : qAsConst(*committed)) {
+                    IconWidget::IconData data = iconDataForFile(result.destination);
+                    data.originalSourcePath = normalizePath(result.source);
+                    data.originalPosition = positions.value(result.index, QPoint(-1, -1));
+                    data.isFromDesktop = true;
+                    addIcon(new IconWidget(data));
+                }
+                endIconUpdate();
+
+                // 文件已离开桌面，整批结束后立即落盘
+                invalidateSerialization();
+                FenceManager::instance()->saveFences();
+                if (ConfigManager::instance()->sync()) {
+                    FileOperationQueue::instance()->acknowledge(*transaction);
+                } else {
+                    LOG_WARN(Logger::Drag, "[dropEvent] Immediate sync failed after desktop file move, rolling back file move.");
+
+                    QList<FileOperationQueue::Operation> rollback;
+                    QVector<QPoint> rollbackPositions;
+                    for (const FileOperationQueue::Result &result : qAsConst(*committed)) {
+                        discardIconEntry(result.destination);
+                        FileOperationQueue::Operation operation;
+                        operation.source = result.destination;
+                        operation.destination = result.source;
+                        operation.rule = FileOperationQueue::Operation::SourceUnreferenced;
+                        rollback.append(operation);
+                        rollbackPositions.append(positions.value(result.index, QPoint(-1, -1)));
+                    }
+                    FenceManager::instance()->saveFences();
+
+                    // 原事务只在全部文件回到桌面后确认，否则留给下次启动时恢复
+                    const quint64 original = *transaction;
+                    auto rollbackTransaction = std::make_shared<quint64>(0);
+                    beginFileOperations(rollback.size());
+                    *rollbackTransaction = FileOperationQueue::instance()->submit(this, rollback,
+                        [this, rollbackPositions](const FileOperationQueue::Result &result) {
+                            fileOperationDone();
+                            if (result.committed) {
+                                DesktopHelper::notifyFileAdded(result.destination);
+                                const QPoint originalPos = rollbackPositions.value(result.index, QPoint(-1, -1));
+                                if (originalPos.x() >= 0 && originalPos.y() >= 0) {
+                                    DesktopHelper::setIconPosition(result.destination, originalPos);
+                                }
+                            }
+                        },
+                        [original, rollbackTransaction](int, int failed) {
+                            FileOperationQueue::instance()->acknowledge(*rollbackTransaction);
+                            if (failed == 0) {
+                                FileOperationQueue::instance()->acknowledge(original);
+                            } else {
+                                FileOperationQueue::instance()->retire(original);
+                            }
+                        });
+
+                    QMessageBox::critical(this, tr("Save Failed"),
+                        tr("DeskGo moved the desktop file, but could not safely persist the fence state. The file has been restored to the desktop."));
+                }
+            }
+
+            if (!failedNames->isEmpty()) {
+                QMessageBox::critical(this, tr("Permission Error"),
+                    tr("Cannot move file: %1\n\nTry running as administrator, or check if the file is in use.").arg(failedNames->join(", ")));
+            }
+        });
 }
 
 void FenceWindow::removeIcon(IconWidget *icon)
 {
     if (icon && m_icons.contains(icon)) {
-        logToDesktop("[removeIcon] Request to remove: " + icon->name() + " path: " + icon->path());
-
-        // 如果是来自桌面的图标，尝试恢复回去
-        if (icon->data().isFromDesktop) {
-            QString srcPath = normalizePath(icon->path());
-            QString desktopPath = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
-            QFileInfo fileInfo(srcPath);
-            QString targetPath = icon->data().originalSourcePath.isEmpty()
-                ? normalizePath(desktopPath + "/" + fileInfo.fileName())
-                : normalizePath(icon->data().originalSourcePath);
-            
-            logToDesktop("[removeIcon] srcPath: " + srcPath);
-            logToDesktop("[removeIcon] targetPath: " + targetPath);
-            
-            // 增强的文件检测：先刷新文件信息缓存
-            fileInfo.refresh();
-            bool actuallyFound = fileInfo.exists();
-            
-            logToDesktop("[removeIcon] QFileInfo::exists() = " + QString(actuallyFound ? "true" : "false"));
-            
-            // 如果 Qt 检测失败，使用 Windows API 直接检测
-            if (!actuallyFound) {
+        LOG_DEBUG(Logger::Fence, "[removeIcon] Request to remove: " + icon->name() + " path: " + icon->path());
+        restoreIconFile(icon->data());
+    }
+}
+
+void FenceWindow::removeGridIcon(const QString &path)
+{
+    const int index = m_gridView ? m_gridView->indexOfPath(path) : -1;
+    if (index < 0) {
+        return;
+    }
+
+    const IconWidget::IconData data = m_gridView->iconAt(index);
+    LOG_DEBUG(Logger::Fence, "[removeIcon] Request to remove: " + data.name + " path: " + data.path);
+    restoreIconFile(data);
+}
+
+void FenceWindow::restoreIconFile(const IconWidget::IconData &data, bool synchronous)
+{
+    // 如果是来自桌面的图标，尝试恢复回去
+    if (data.isFromDesktop) {
+        QString srcPath = normalizePath(data.path);
+        QString desktopPath = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
+        QFileInfo fileInfo(srcPath);
+        QString targetPath = data.originalSourcePath.isEmpty()
+            ? normalizePath(desktopPath + "/" + fileInfo.fileName())
+            : normalizePath(data.originalSourcePath);
+        
+        LOG_DEBUG(Logger::Fence, "[removeIcon] srcPath: " + srcPath);
+        LOG_DEBUG(Logger::Fence, "[removeIcon] targetPath: " + targetPath);
+        
+        // 增强的文件检测：先刷新文件信息缓存
+        fileInfo.refresh();
+        bool actuallyFound = fileInfo.exists();
+        
+        LOG_DEBUG(Logger::Fence, "[removeIcon] QFileInfo::exists() = " + QString(actuallyFound ? "true" : "false"));
+        
+        // 如果 Qt 检测失败，使用 Windows API 直接检测
+        if (!actuallyFound) {
 #ifdef Q_OS_WIN
-                std::wstring wPath = srcPath.toStdWString();
-                DWORD attr = GetFileAttributesW(wPath.c_str());
-                if (attr != INVALID_FILE_ATTRIBUTES) {
+            std::wstring wPath = srcPath.toStdWString();
+            DWORD attr = GetFileAttributesW(wPath.c_str());
+            if (attr != INVALID_FILE_ATTRIBUTES) {
+                actuallyFound = true;
+                LOG_DEBUG(Logger::Fence, "[removeIcon] Windows API detected file exists!");
+            }
+#endif
+        }
+        
+        // 目录扫描容错：解决中文文件名在 windows 锁定下的 exists() 误报
+        if (!actuallyFound) {
+            LOG_DEBUG(Logger::Fence, "[removeIcon] Direct check failed, scanning dir for fuzzy match...");
+            QDir storageDir(fileInfo.absolutePath());
+            QStringList entries = storageDir.entryList(QDir::Files);
+            LOG_DEBUG(Logger::Fence, "[removeIcon] Found " + QString::number(entries.size()) + " files in directory");
+            for (const QString& entry : qAsConst(entries)) {
+                LOG_DEBUG(Logger::Fence, "[removeIcon] Checking: " + entry + " vs " + fileInfo.fileName());
+                if (QString::compare(entry, fileInfo.fileName(), Qt::CaseInsensitive) == 0) {
+                    srcPath = storageDir.absoluteFilePath(entry);
+                    fileInfo.setFile(srcPath);
                     actuallyFound = true;
-                    logToDesktop("[removeIcon] Windows API detected file exists!");
+                    LOG_DEBUG(Logger::Fence, "[removeIcon] Corrected srcPath via scan: " + srcPath);
+                    break;
                 }
-#endif
             }
-            
-            // 目录扫描容错：解决中文文件名在 windows 锁定下的 exists() 误报
-            if (!actuallyFound) {
-                logToDesktop("[removeIcon] Direct check failed, scanning dir for fuzzy match...");
-                QDir storageDir(fileInfo.absolutePath());
-                QStringList entries = storageDir.entryList(QDir::Files);
-                logToDesktop("[removeIcon] Found " + QString::number(entries.size()) + " files in directory");
-                for (const QString& entry : qAsConst(entries)) {
-                    logToDesktop("[removeIcon] Checking: " + entry + " vs " + fileInfo.fileName());
-                    if (QString::compare(entry, fileInfo.fileName(), Qt::CaseInsensitive) == 0) {
-                        srcPath = storageDir.absoluteFilePath(entry);
-                        fileInfo.setFile(srcPath);
-                        actuallyFound = true;
-                        logToDesktop("[removeIcon] Corrected srcPath via scan: " + srcPath);
-                        break;
-                    }
+        }
+
+        if (actuallyFound) {
+            if (QFile::exists(targetPath)) {
+                LOG_DEBUG(Logger::Fence, "[removeIcon] Target already on desktop, cleaning up storage.");
+                if (QDir::toNativeSeparators(srcPath).compare(QDir::toNativeSeparators(targetPath), Qt::CaseInsensitive) != 0) {
+                    QFile::remove(srcPath);
                 }
+                LOG_INFO(Logger::Fence, "[removeIcon] Restore SUCCESS: " + targetPath);
+                completeIconRemoval(data.path, 0);
+                return;
             }
 
-            if (actuallyFound) {
-                bool restored = false;
-                if (QFile::exists(targetPath)) {
-                    logToDesktop("[removeIcon] Target already on desktop, cleaning up storage.");
-                    if (QDir::toNativeSeparators(srcPath).compare(QDir::toNativeSeparators(targetPath), Qt::CaseInsensitive) != 0) {
-                        QFile::remove(srcPath);
-                    }
-                    restored = true;
+            // 移动回桌面：布局只在文件就位后更新，操作记入文件操作日志
+            FileOperationQueue::Operation operation;
+            operation.source = srcPath;
+            operation.destination = targetPath;
+            operation.rule = FileOperationQueue::Operation::SourceUnreferenced;
+
+            if (synchronous) {
+                quint64 transaction = 0;
+                QString error;
+                if (FileOperationQueue::instance()->runNow(operation, &transaction, &error)) {
+                    LOG_INFO(Logger::Fence, "[removeIcon] Restore SUCCESS: " + targetPath);
+                    announceRestoredFile(targetPath, data.originalPosition);
                 } else {
-                    logToDesktop("[removeIcon] Attempting to move file back to desktop...");
-                    // 移动回桌面
-                    std::wstring wSrc = QDir::toNativeSeparators(srcPath).toStdWString();
-                    std::wstring wDst = QDir::toNativeSeparators(targetPath).toStdWString();
-                    
-                    if (MoveFileExW(wSrc.c_str(), wDst.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED | MOVEFILE_WRITE_THROUGH)) {
-                        restored = true;
-                        logToDesktop("[removeIcon] MoveFileExW SUCCESS");
-                    } else {
-                        DWORD error = GetLastError();
-                        logToDesktop("[removeIcon] MoveFileExW FAILED, error: " + QString::number(error));
-                        
-                        if (QFile::rename(srcPath, targetPath)) {
-                            restored = true;
-                            logToDesktop("[removeIcon] QFile::rename SUCCESS");
-                        } else {
-                            logToDesktop("[removeIcon] QFile::rename FAILED, trying copy...");
-                            if (QFile::copy(srcPath, targetPath)) {
-                                QFile::remove(srcPath);
-                                restored = true;
-                                logToDesktop("[removeIcon] QFile::copy SUCCESS");
-                            } else {
-                                logToDesktop("[removeIcon] QFile::copy FAILED");
-                            }
-                        }
-                    }
+                    LOG_WARN(Logger::Fence, "[removeIcon] Restore IO ERROR for: " + srcPath + " (" + error + ")");
                 }
+                completeIconRemoval(data.path, transaction);
+                return;
+            }
 
-                if (restored) {
-                    logToDesktop("[removeIcon] Restore SUCCESS: " + targetPath);
-                    
-                    QPoint originalPos = icon->data().originalPosition;
-                    
-                    // 先设置图标位置（在通知系统之前）
-                    if (originalPos.x() >= 0 && originalPos.y() >= 0) {
-                        // 立即尝试设置位置
-                        DesktopHelper::setIconPosition(targetPath, originalPos);
-                        logToDesktop("[removeIcon] Set icon position immediately: " + QString::number(originalPos.x()) + "," + QString::number(originalPos.y()));
-                    }
-                    
-                    // 然后通知系统文件已添加
-                    DesktopHelper::notifyFileAdded(targetPath);
-                    std::wstring wDesktop = QDir::toNativeSeparators(desktopPath).toStdWString();
-                    SHChangeNotify(SHCNE_UPDATEDIR, SHCNF_PATHW, wDesktop.c_str(), NULL);
-                    
-                    // 再次设置位置（作为保险，因为系统刷新可能会重置位置）
-                    if (originalPos.x() >= 0 && originalPos.y() >= 0) {
-                        QTimer::singleShot(100, [targetPath, originalPos]() {
-                            DesktopHelper::setIconPosition(targetPath, originalPos);
-                        });
+            LOG_DEBUG(Logger::Fence, "[removeIcon] Queueing move back to desktop...");
+            const QString path = data.path;
+            const QPoint originalPos = data.originalPosition;
+            auto transaction = std::make_shared<quint64>(0);
+            beginFileOperations(1);
+            *transaction = FileOperationQueue::instance()->submit(this, {operation},
+                [this, path, originalPos, transaction](const FileOperationQueue::Result &result) {
+                    fileOperationDone();
+                    if (!result.committed) {
+                        // 文件仍在存储目录中，保留图标
+                        LOG_WARN(Logger::Fence, "[removeIcon] Restore IO ERROR for: " + result.source + " (" + result.error + ")");
+                        return;
                     }
-                } else {
-                    logToDesktop("[removeIcon] Restore IO ERROR for: " + srcPath);
-                }
-            } else {
-                logToDesktop("[removeIcon] FATAL: File GONE from disk: " + srcPath);
-            }
-        } else {
-            // 普通图标，直接物理删除
-            QString srcPath = icon->path();
-            if (QFile::exists(srcPath)) {
-                QFile::remove(srcPath);
-                logToDesktop("[removeIcon] Deleted non-desktop file: " + srcPath);
-            }
+                    LOG_INFO(Logger::Fence, "[removeIcon] Restore SUCCESS: " + result.destination);
+                    announceRestoredFile(result.destination, originalPos);
+                    completeIconRemoval(path, *transaction);
+                },
+                nullptr);
+            return;
         }
-
-        m_icons.removeOne(icon);
-        m_contentLayout->removeWidget(icon);
-        icon->hide();
-        icon->deleteLater();
-        
-        updatePlaceholder();
-        emit geometryChanged();
-        FenceManager::instance()->saveFences();
-        if (!ConfigManager::instance()->sync()) {
-            logToDesktop("[removeIcon] Immediate sync failed after removing icon.");
+        LOG_WARN(Logger::Fence, "[removeIcon] FATAL: File GONE from disk: " + srcPath);
+    } else {
+        // 普通图标，直接物理删除
+        QString srcPath = data.path;
+        if (QFile::exists(srcPath)) {
+            QFile::remove(srcPath);
+            LOG_DEBUG(Logger::Fence, "[removeIcon] Deleted non-desktop file: " + srcPath);
         }
     }
+
+    completeIconRemoval(data.path, 0);
 }
 
+void FenceWindow::completeIconRemoval(const QString &path, quint64 transaction)
+{
+    // 存储目录中的文件已被移走或删除，对应的图标缓存随之失效
+    IconCache::instance()->invalidate(path);
+    discardIconEntry(path);
+    finishIconRemoval(transaction);
+}
+
+void FenceWindow::finishIconRemoval(quint64 transaction)
+{
+    updatePlaceholder();
+    emit geometryChanged();
+    FenceManager::instance()->saveFences();
+    if (!ConfigManager::instance()->sync()) {
+        // 不确认事务：下次启动时按已保存的布局决定文件的去留
+        LOG_WARN(Logger::Fence, "[removeIcon] Immediate sync failed after removing icon.");
+        if (transaction) {
+            FileOperationQueue::instance()->retire(transaction);
+        }
+    } else if (transaction) {
+        FileOperationQueue::instance()->acknowledge(transaction);
+    }
+}
 
 void FenceWindow::setIconTextVisible(bool visible)
 {
+    if (m_gridView) {
+        m_gridView->setTextVisible(visible);
+        return;
+    }
     for (IconWidget *icon : qAsConst(m_icons)) {
         icon->setTextVisible(visible);
     }
@@ -732,7 +1303,7 @@ void FenceWindow::setIconTextVisible(bool visible)
 void FenceWindow::flushPendingSave()
 {
     if (m_saveTimer && m_saveTimer->isActive()) {
-        logToDesktop("[flushPendingSave] Stopping timer and triggering immediate save for: " + m_title);
+        LOG_DEBUG(Logger::Fence, "[flushPendingSave] Stopping timer and triggering immediate save for: " + m_title);
         m_saveTimer->stop();
         emit geometryChanged();
     }
@@ -750,10 +1321,22 @@ void FenceWindow::stopSaveTimer()
 
 void FenceWindow::restoreAllIcons()
 {
-    // 创建一个临时副本，因为 removeIcon 会修改 list
-    QList<IconWidget*> iconsCopy = m_icons;
-    for (IconWidget *icon : qAsConst(iconsCopy)) {
-        removeIcon(icon);
+    // 围栏随后会连同存储目录一起删除，文件必须在返回前回到桌面，这里同步执行。
+    // 先结束本围栏仍在进行的文件操作：已移入存储目录的文件随结果送达加入图标，一并归还
+    FileOperationQueue::instance()->settle(this);
+
+    QList<IconWidget::IconData> entries;
+    if (m_gridView) {
+        for (int i = 0; i < m_gridView->count(); ++i) {
+            entries.append(m_gridView->iconAt(i));
+        }
+    } else {
+        for (IconWidget *icon : qAsConst(m_icons)) {
+            entries.append(icon->data());
+        }
+    }
+    for (const IconWidget::IconData &data : qAsConst(entries)) {
+        restoreIconFile(data, true);
     }
 }
 
@@ -762,10 +1345,18 @@ QList<IconWidget*> FenceWindow::icons() const
     return m_icons;
 }
 
+void FenceWindow::invalidateSerialization()
+{
+    m_cachedJsonValid = false;
+    m_serializationRevision = ++s_nextSerializationRevision;
+}
+
 QJsonObject FenceWindow::toJson() const
 {
-    logToDesktop("[toJson] Serializing fence: " + m_title + " with " + QString::number(m_icons.size()) + " icons");
-    
+    if (m_cachedJsonValid) {
+        return m_cachedJson;
+    }
+
     QJsonObject obj;
     obj["id"] = m_id;
     obj["title"] = m_title;
@@ -778,15 +1369,12 @@ QJsonObject FenceWindow::toJson() const
     obj["backgroundColor"] = m_backgroundColor.name(QColor::HexArgb);
     
     QJsonArray iconsArray;
-    for (IconWidget *icon : qAsConst(m_icons)) {
-        logToDesktop("[toJson]   Icon: " + icon->name() + " path: " + icon->path());
-        
+    auto appendIcon = [this, &iconsArray](const IconWidget::IconData &data) {
         QJsonObject iconObj;
-        iconObj["name"] = icon->name();
+        iconObj["name"] = data.name;
         // 如果路径在当前围栏的存储目录中，则保存为相对路径，避免移动目录后失效
-        iconObj["path"] = IconHelper::toStoragePath(icon->path(), m_id);
+        iconObj["path"] = IconHelper::toStoragePath(data.path, m_id);
         
-        IconWidget::IconData data = icon->data();
         if (data.isFromDesktop) {
             iconObj["isFromDesktop"] = true;
             iconObj["originalX"] = data.originalPosition.x();
@@ -800,9 +1388,20 @@ QJsonObject FenceWindow::toJson() const
         }
         
         iconsArray.append(iconObj);
+    };
+    if (m_gridView) {
+        for (int i = 0; i < m_gridView->count(); ++i) {
+            appendIcon(m_gridView->iconAt(i));
+        }
+    } else {
+        for (IconWidget *icon : qAsConst(m_icons)) {
+            appendIcon(icon->data());
+        }
     }
     obj["icons"] = iconsArray;
 
+    m_cachedJson = obj;
+    m_cachedJsonValid = true;
     return obj;
 }
 
@@ -865,33 +1464,37 @@ FenceWindow* FenceWindow::fromJson(const QJsonObject &json)
     //     fence->m_alwaysOnTop = true;
     // }
 
+    // 强制先显示一个空窗口（避免启动时卡出白板）
+    fence->show();
+    fence->m_contentArea->show();
+    if (!fence->m_collapsed) fence->m_contentArea->raise();
+
     // 恢复图标
-    logToDesktop("[fromJson] Restoring icons for fence: " + fence->title() + " id: " + fence->id());
-    QJsonArray iconsArray = json["icons"].toArray();
-    QFileIconProvider iconProvider;
+    LOG_DEBUG(Logger::Icon, "[fromJson] Restoring icons for fence: " + fence->title() + " id: " + fence->id());
+    QList<QPair<int, QJsonObject>> entries;
+    for (const QJsonValue &val : json["icons"].toArray()) {
+        entries.append(qMakePair(-1, val.toObject()));
+    }
+    fence->restoreIconEntries(entries);
+    return fence;
+}
+
+void FenceWindow::restoreIconEntries(const QList<QPair<int, QJsonObject>> &entries)
+{
     // 使用 ConfigManager 统一的存储路径，与写入时保持一致
     QString storageBase = QDir::toNativeSeparators(QDir::cleanPath(
-        ConfigManager::instance()->fencesStoragePath() + "/" + fence->id()));
+        ConfigManager::instance()->fencesStoragePath() + "/" + m_id));
     
     // 获取全部存储根目录，用于失效时的全局恢复
     QString storageRoot = ConfigManager::instance()->fencesStoragePath();
-    QDir rootDir(storageRoot);
-
-    // 提取解析逻辑至后台线程
-    // 我们先收集要处理的文件列表和配置
-    struct IconTask {
-        QString name;
-        QString savedPath;
-        QString originalSourcePath;
-        bool isFromDesktop = false;
-        bool alwaysRunAsAdmin = false;
-        QPoint originalPos;
-    };
-    
-    QList<IconTask> tasks;
-    for (const QJsonValue &val : iconsArray) {
-        QJsonObject iconObj = val.toObject();
-        IconTask task;
+
+    // 先收集要处理的文件列表和配置，每个图标作为独立任务交给全局调度器
+    QList<IconRestoreTask> tasks;
+    QList<int> positions;
+    for (const auto &entry : entries) {
+        const QJsonObject iconObj = entry.second;
+        IconRestoreTask task;
+        task.index = tasks.size();
         task.name = iconObj["name"].toString();
         task.savedPath = iconObj["path"].toString();
         if (iconObj.contains("isFromDesktop") && iconObj["isFromDesktop"].toBool()) {
@@ -905,156 +1508,358 @@ FenceWindow* FenceWindow::fromJson(const QJsonObject &json)
             task.alwaysRunAsAdmin = iconObj["alwaysRunAsAdmin"].toBool();
         }
         tasks.append(task);
+        positions.append(entry.first);
     }
     
-    // 强制先显示一个空窗口（避免启动时卡出白板）
-    fence->show();
-    fence->m_contentArea->show();
-    if (!fence->m_collapsed) fence->m_contentArea->raise();
-    
     if (tasks.isEmpty()) {
-        if (fence->m_saveTimer) {
-            fence->m_saveTimer->stop();
+        if (m_saveTimer) {
+            m_saveTimer->stop();
         }
-        fence->m_restoringFromJson = false;
-        return fence;
+        m_restoringFromJson = false;
+        return;
     }
+    m_restoringFromJson = true;
+
+    // 先按保存顺序放入占位图标，占住最终位置，加载结果到达时原地替换，布局不会跳动
+    // 图标很多时改用虚拟化网格，占位只是网格中的一条数据
+    if (shouldVirtualize(iconCount() + tasks.size())) {
+        switchToGridView();
+    }
+
+    const QString fenceId = m_id;
+    QList<QPair<IconRestoreTask, IconPlaceholder>> placeholders;
+    beginIconUpdate();
+    for (int i = 0; i < tasks.size(); ++i) {
+        const IconRestoreTask &task = tasks.at(i);
+        const int position = positions.at(i) < 0 ? iconCount() : qMin(positions.at(i), iconCount());
+        IconWidget::IconData data;
+        data.name = task.name;
+        data.path = normalizePath(IconHelper::fromStoragePath(task.savedPath, fenceId));
+        data.targetPath = data.path;
+        IconPlaceholder placeholder;
+        if (m_gridView) {
+            if (containsIconPath(data.path)) {
+                LOG_DEBUG(Logger::Fence, "  Icon already exists: " + data.path + ", deleting duplicate");
+                continue;
+            }
+            placeholder.gridId = m_gridView->insertIcon(position, data, true);
+            m_iconsChanged = true;
+        } else {
+            IconWidget *widget = new IconWidget(data);
+            widget->setLoading(true);
+            if (!addIconAt(widget, position)) {
+                continue;
+            }
+            placeholder.widget = widget;
+        }
+        placeholders.append(qMakePair(task, placeholder));
+    }
+    endIconUpdate();
 
-    // 后台并发执行图标读取
-    QFutureWatcher<QList<IconWidget::IconData>>* watcher = new QFutureWatcher<QList<IconWidget::IconData>>(fence);
-    // fence 是这个 watcher 的 parent，即使 fence 销毁 watcher 也会随之释放
+    auto progress = std::make_shared<IconRestoreProgress>();
+    progress->remaining = placeholders.size();
+    if (progress->remaining == 0) {
+        if (m_saveTimer) {
+            m_saveTimer->stop();
+        }
+        m_restoringFromJson = false;
+        return;
+    }
+
+    // 与 IconWidget 的缩放尺寸一致，缓存中的位图即可直接显示
+    const int iconPixelSize = IconHelper::kIconDisplaySize * devicePixelRatio();
+    const IconLoadScheduler::Priority priority = iconLoadPriority();
+
+    for (const auto &entry : qAsConst(placeholders)) {
+        const IconRestoreTask task = entry.first;
+        const IconPlaceholder placeholder = entry.second;
+        IconLoadScheduler::instance()->submit<LoadedIcon>(
+            this, priority,
+            [task, fenceId, storageBase, storageRoot, iconPixelSize]() {
+                return loadRestoredIcon(task, fenceId, storageBase, storageRoot, iconPixelSize);
+            },
+            [this, placeholder, progress](const LoadedIcon &loaded) {
+                s_pendingIconDeliveries.append({this, placeholder, loaded, progress});
+                if (!iconDeliveryTimer()->isActive()) {
+                    iconDeliveryTimer()->start();
+                }
+            });
+    }
 
-    QObject::connect(watcher, &QFutureWatcher<QList<IconWidget::IconData>>::finished, fence, [fence, watcher]() {
-        QList<IconWidget::IconData> results = watcher->result();
-        for (const auto& data : qAsConst(results)) {
-            IconWidget *icon = new IconWidget(data);
-            if (data.icon.isNull()) {
-                icon->setData(data); // 内部仍有后备 fallback
+    LOG_DEBUG(Logger::Icon, QString("[restoreIconEntries] Queued %1 icon loads for: %2").arg(placeholders.size()).arg(m_title));
+}
+
+void FenceWindow::applyJson(const QJsonObject &json)
+{
+    if (m_titleEdit) {
+        finishTitleEdit();
+    }
+
+    setTitle(json["title"].toString(m_title));
+    if (json.contains("backgroundColor")) {
+        setBackgroundColor(QColor(json["backgroundColor"].toString()));
+    }
+
+    // 几何与折叠状态：与 fromJson 相同的默认值和最小尺寸规则
+    const int x = json.contains("x") ? json["x"].toInt() : this->x();
+    const int y = json.contains("y") ? json["y"].toInt() : this->y();
+    int w = json.contains("width") ? json["width"].toInt() : width();
+    int h = json.contains("height") ? json["height"].toInt() : height();
+    if (w < 100) w = 280;
+    if (h < 50) h = 200;
+
+    if (json["collapsed"].toBool()) {
+        const int expandedHeight = json.contains("expandedHeight") ? json["expandedHeight"].toInt() : 300;
+        if (m_collapsed) {
+            m_expandedHeight = expandedHeight;
+            setGeometry(x, y, w, height());
+        } else {
+            // setCollapsed 以折叠前的高度作为展开高度
+            setGeometry(x, y, w, expandedHeight);
+            setCollapsed(true);
+        }
+    } else if (m_collapsed) {
+        setGeometry(x, y, w, height());
+        m_expandedHeight = h;
+        setCollapsed(false);
+    } else {
+        setGeometry(x, y, w, h);
+    }
+
+    // 图标按路径比对：已有的图标保留（不重新提取），只移除备份中没有的、补上新增的，并按备份顺序排列
+    const QJsonArray iconsArray = json["icons"].toArray();
+    QList<QString> targetPaths;
+    QHash<QString, QJsonObject> targetByPath; // 小写路径 -> 图标记录
+    for (const QJsonValue &value : iconsArray) {
+        const QJsonObject iconObj = value.toObject();
+        const QString path = normalizePath(IconHelper::fromStoragePath(iconObj["path"].toString(), m_id));
+        if (targetByPath.contains(path.toLower())) {
+            continue;
+        }
+        targetPaths.append(path);
+        targetByPath.insert(path.toLower(), iconObj);
+    }
+
+    beginIconUpdate();
+
+    QList<IconWidget::IconData> current;
+    if (m_gridView) {
+        for (int i = 0; i < m_gridView->count(); ++i) {
+            current.append(m_gridView->iconAt(i));
+        }
+    } else {
+        for (IconWidget *icon : qAsConst(m_icons)) {
+            current.append(icon->data());
+        }
+    }
+
+    QSet<QString> keptPaths;
+    for (const IconWidget::IconData &data : qAsConst(current)) {
+        const QString key = normalizePath(data.path).toLower();
+        if (targetByPath.contains(key) && !keptPaths.contains(key)) {
+            keptPaths.insert(key);
+        } else {
+            discardIconEntry(data.path);
+        }
+    }
+
+    // 保留的图标依备份顺序排在前面，新增图标再按其在备份中的下标插入，最终顺序与备份一致
+    QList<QPair<int, QJsonObject>> additions;
+    int position = 0;
+    for (int i = 0; i < targetPaths.size(); ++i) {
+        const QString key = targetPaths.at(i).toLower();
+        const QJsonObject iconObj = targetByPath.value(key);
+        if (!keptPaths.contains(key)) {
+            additions.append(qMakePair(i, iconObj));
+            continue;
+        }
+
+        if (m_gridView) {
+            const int index = m_gridView->indexOfPath(targetPaths.at(i));
+            IconWidget::IconData data = m_gridView->iconAt(index);
+            applyIconJson(&data, iconObj);
+            if (index != position) {
+                m_gridView->removeAt(index);
+                m_gridView->insertIcon(position, data, false);
+            } else {
+                m_gridView->setIconData(index, data);
+            }
+        } else {
+            int index = 0;
+            while (QString::compare(normalizePath(m_icons.at(index)->path()), targetPaths.at(i), Qt::CaseInsensitive) != 0) {
+                ++index;
+            }
+            IconWidget *icon = m_icons.at(index);
+            IconWidget::IconData data = icon->data();
+            applyIconJson(&data, iconObj);
+            icon->setData(data);
+            if (index != position) {
+                m_icons.removeAt(index);
+                m_iconIndexValid = false;
+                m_contentLayout->removeWidget(icon);
+                insertIconAt(icon, position);
             }
-            fence->addIcon(icon);
         }
-        
-        // 最后统一强制刷新布局
-        if (fence->m_contentLayout) {
-            fence->m_contentLayout->invalidate();
-            fence->m_contentArea->updateGeometry();
-            fence->m_contentArea->update();
-            for (IconWidget* icon : qAsConst(fence->m_icons)) {
-                icon->update();
-                icon->show();
+        ++position;
+    }
+
+    endIconUpdate();
+    invalidateSerialization();
+
+    restoreIconEntries(additions);
+}
+
+void FenceWindow::rebaseStoragePaths(const QString &oldRoot, const QString &newRoot)
+{
+    const QString oldPrefix = normalizePath(oldRoot) + QDir::separator();
+    const QString newPrefix = normalizePath(newRoot) + QDir::separator();
+    auto rebase = [&oldPrefix, &newPrefix](QString *path) {
+        const QString normalized = normalizePath(*path);
+        if (!normalized.startsWith(oldPrefix, Qt::CaseInsensitive)) {
+            return false;
+        }
+        *path = newPrefix + normalized.mid(oldPrefix.size());
+        return true;
+    };
+
+    // 加载中的图标不改写：其路径随后按新存储目录重新比对，由 applyJson 重新加载
+    bool changed = false;
+    if (m_gridView) {
+        for (int i = 0; i < m_gridView->count(); ++i) {
+            if (m_gridView->isLoading(i)) {
+                continue;
+            }
+            IconWidget::IconData data = m_gridView->iconAt(i);
+            const bool pathChanged = rebase(&data.path);
+            const bool targetChanged = rebase(&data.targetPath);
+            if (pathChanged || targetChanged) {
+                m_gridView->setIconData(i, data);
+                changed = true;
             }
         }
-        logToDesktop("[fromJson] All async icons restored for: " + fence->title());
-        if (fence->m_saveTimer) {
-            fence->m_saveTimer->stop();
+    } else {
+        for (IconWidget *icon : qAsConst(m_icons)) {
+            if (icon->isLoading()) {
+                continue;
+            }
+            IconWidget::IconData data = icon->data();
+            const bool pathChanged = rebase(&data.path);
+            const bool targetChanged = rebase(&data.targetPath);
+            if (pathChanged || targetChanged) {
+                icon->setData(data);
+                changed = true;
+            }
         }
-        fence->m_restoringFromJson = false;
-        watcher->deleteLater();
-    });
+    }
 
-    QString fenceId = fence->id();
-    auto parseTask = [fenceId, storageBase, storageRoot, tasks]() -> QList<IconWidget::IconData> {
-        // [关键] 在后台线程初始化 COM 环境，否则 SHGetImageList 等 Shell API 可能会在某些环境下失效或挂起
-        HRESULT hr_com = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
-        logToDesktop(QString("[parseTask] Worker thread started for %1. COM init: %2").arg(fenceId).arg(hr_com == S_OK ? "OK" : "Already Init/Error"));
-        QList<IconWidget::IconData> loadedDatas;
-        QDir rootDir(storageRoot);
-        QFileIconProvider iconProvider;
+    if (changed) {
+        invalidateSerialization();
+    }
+}
 
-        for (const auto& task : qAsConst(tasks)) {
-            QString path = IconHelper::fromStoragePath(task.savedPath, fenceId);
-            QFileInfo fileInfo(path);
+QTimer *FenceWindow::iconDeliveryTimer()
+{
+    static QTimer *timer = []() {
+        QTimer *t = new QTimer();
+        t->setInterval(kIconBatchIntervalMs);
+        QObject::connect(t, &QTimer::timeout, &FenceWindow::applyPendingIconBatch);
+        return t;
+    }();
+    return timer;
+}
 
-            bool exists = fileInfo.exists();
-            logToDesktop("[parseTask] Processing: " + task.name + " (" + path + ") exists:" + QString::number(exists));
+void FenceWindow::applyPendingIconBatch()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // 每批对每个围栏只开一次批量更新范围：结束时统一布局、刷新占位提示并标记序列化失效
+    QSet<FenceWindow*> touchedFences;
+    QList<QPointer<FenceWindow>> finishedFences;
+    int applied = 0;
+
+    while (!s_pendingIconDeliveries.isEmpty() && elapsed.elapsed() < kIconBatchBudgetMs) {
+        const PendingIconDelivery delivery = s_pendingIconDeliveries.takeFirst();
+        FenceWindow *fence = delivery.fence.data();
+        IconWidget *icon = delivery.placeholder.widget.data();
+        if (!fence) {
+            continue;
+        }
+        if (!touchedFences.contains(fence)) {
+            touchedFences.insert(fence);
+            fence->beginIconUpdate();
+        }
 
-            if (!exists) {
-#ifdef Q_OS_WIN
-                std::wstring wPath = path.toStdWString();
-                DWORD attr = GetFileAttributesW(wPath.c_str());
-                if (attr != INVALID_FILE_ATTRIBUTES) {
-                    exists = true;
-                    fileInfo.setFile(path);
-                    fileInfo.refresh();
-                    logToDesktop("[parseTask]   Windows API detected file exists: " + path);
-                }
-#endif
+        const int gridIndex = fence->m_gridView ? fence->m_gridView->indexOfId(delivery.placeholder.gridId) : -1;
+        if (gridIndex >= 0) {
+            const IconWidget::IconData data = iconDataFromLoaded(delivery.loaded);
+            const int existing = fence->m_gridView->indexOfPath(data.path);
+            if (existing >= 0 && existing != gridIndex) {
+                LOG_DEBUG(Logger::Fence, "  Icon already exists: " + data.path + ", deleting duplicate");
+                fence->m_gridView->removeAt(gridIndex);
+            } else {
+                fence->m_gridView->setIconData(gridIndex, data);
             }
-            
-            if (!exists) {
-                QString fileName = fileInfo.fileName();
-                if (fileName.isEmpty()) fileName = task.name + ".lnk"; 
-
-                bool fixed = false;
-                QString autoPath = QDir::toNativeSeparators(QDir::cleanPath(storageBase + "/" + fileName));
-                logToDesktop("[parseTask]   Attempt fallback check: " + autoPath);
-                if (QFile::exists(autoPath)) {
-                    path = autoPath;
-                    fixed = true;
-                    logToDesktop("[parseTask]   Fallback SUCCESS: fixed path to " + path);
-                }
-                
-                if (!fixed) {
-                    QStringList subDirs = rootDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-                    for (const QString& subDir : qAsConst(subDirs)) {
-                        QString searchPath = QDir::toNativeSeparators(QDir::cleanPath(storageRoot + "/" + subDir + "/" + fileName));
-                        if (QFile::exists(searchPath)) {
-                            path = searchPath;
-                            fixed = true;
-                            logToDesktop("[parseTask]   Global Search SUCCESS: found in " + path);
-                            break;
-                        }
+            fence->m_iconsChanged = true;
+            ++applied;
+        } else if (icon && fence->m_icons.contains(icon)) {
+            const IconWidget::IconData data = iconDataFromLoaded(delivery.loaded);
+
+            // 路径经回退修复后可能与已有图标重复，与 addIcon 的去重规则一致
+            bool duplicate = false;
+            if (QString::compare(data.path, icon->path(), Qt::CaseInsensitive) != 0) {
+                for (IconWidget *other : qAsConst(fence->m_icons)) {
+                    if (other != icon && QString::compare(normalizePath(other->path()), data.path, Qt::CaseInsensitive) == 0) {
+                        duplicate = true;
+                        break;
                     }
                 }
-                if (fixed) fileInfo.setFile(path);
             }
 
-            if (exists || fileInfo.exists()) {
-                 IconWidget::IconData data;
-                 data.name = task.name;
-                 data.path = QDir::toNativeSeparators(QDir::cleanPath(path));
-                 data.targetPath = data.path;
-                 
-                 data.icon = IconHelper::getWinIcon(data.path);
-                 logToDesktop("[parseTask]   Icon extraction: " + QString(data.icon.isNull() ? "FAILED" : "OK"));
-                 if (data.icon.isNull()) {
-                     data.icon = iconProvider.icon(fileInfo).pixmap(48, 48);
-                 }
-                 
-                 if (task.isFromDesktop) {
-                     data.isFromDesktop = true;
-                     data.originalPosition = task.originalPos;
-                     data.originalSourcePath = task.originalSourcePath;
-                 }
-                 data.alwaysRunAsAdmin = task.alwaysRunAsAdmin;
-                 loadedDatas.append(data);
+            if (duplicate) {
+                LOG_DEBUG(Logger::Fence, "  Icon already exists: " + data.path + ", deleting duplicate");
+                fence->m_icons.removeOne(icon);
+                fence->m_iconIndexValid = false;
+                fence->m_contentLayout->removeWidget(icon);
+                icon->deleteLater();
+                fence->m_iconLayoutDirty = true;
             } else {
-                 logToDesktop("[parseTask]   FATAL: File not found even after fallback!");
-                 IconWidget::IconData data;
-                 data.name = task.name;
-                 data.path = QDir::toNativeSeparators(QDir::cleanPath(path));
-                 data.targetPath = data.path;
-                 data.icon = iconProvider.icon(QFileIconProvider::File).pixmap(48, 48);
-                 if (task.isFromDesktop) {
-                     data.isFromDesktop = true;
-                     data.originalPosition = task.originalPos;
-                     data.originalSourcePath = task.originalSourcePath;
-                 }
-                 data.alwaysRunAsAdmin = task.alwaysRunAsAdmin;
-                 loadedDatas.append(data);
-                 logToDesktop("[parseTask]   Preserved missing icon entry with fallback icon: " + data.path);
+                icon->setData(data);
+                icon->setLoading(false);
             }
+            fence->m_iconsChanged = true;
+            ++applied;
         }
-        logToDesktop(QString("[parseTask] Worker thread finished for %1. Loaded %2 icons").arg(fenceId).arg(loadedDatas.size()));
-        CoUninitialize();
-        return loadedDatas;
-    };
 
-    QFuture<QList<IconWidget::IconData>> future = QtConcurrent::run(parseTask);
-    watcher->setFuture(future);
+        if (--delivery.progress->remaining == 0) {
+            finishedFences.append(delivery.fence);
+        }
+    }
 
-    logToDesktop("[fromJson] Spawned async icon loading for: " + fence->title());
-    return fence;
+    // 占位图标尺寸与最终图标一致，只有删除重复项时才需要重新布局
+    for (FenceWindow *fence : qAsConst(touchedFences)) {
+        fence->endIconUpdate();
+    }
+
+    for (const QPointer<FenceWindow> &fence : qAsConst(finishedFences)) {
+        if (!fence) {
+            continue;
+        }
+        LOG_DEBUG(Logger::Icon, "[fromJson] All async icons restored for: " + fence->title());
+        if (fence->m_saveTimer) {
+            fence->m_saveTimer->stop();
+        }
+        fence->m_restoringFromJson = false;
+    }
+
+    LOG_DEBUG(Logger::Icon, QString("[applyPendingIconBatch] Applied %1 icons in %2 ms, %3 pending")
+                                .arg(applied)
+                                .arg(elapsed.elapsed())
+                                .arg(s_pendingIconDeliveries.size()));
+
+    if (s_pendingIconDeliveries.isEmpty()) {
+        iconDeliveryTimer()->stop();
+    }
 }
 
 bool FenceWindow::nativeEvent(const QByteArray &eventType, void *message, long *result)
@@ -1254,26 +2059,18 @@ bool FenceWindow::nativeEvent(const QByteArray &eventType, void *message, long *
     }
 
     if (msg->message == WM_ENTERSIZEMOVE) {
-        m_alignmentGuideDebugState.clear();
+        m_alignmentGuideDebugState = GuideDebugState();
+        m_nativeSizingDebugState = GuideDebugState();
         if (m_nativeHitResizeEdge != None) {
             m_isResizing = true;
             m_resizeEdge = m_nativeHitResizeEdge;
             m_resizeStartGeo = geometry();
-            m_snapRectsCache.clear();
-            for (FenceWindow *other : qAsConst(s_allFences)) {
-                if (other != this) {
-                    m_snapRectsCache.append(other->geometry());
-                }
-            }
+            rebuildSnapIndex();
 
-            qDebug() << "[AlignmentGuide] native-enter" << m_id
-                     << "edge=" << m_resizeEdge
-                     << "cache=" << m_snapRectsCache.size()
-                     << "geo=" << geometry();
-            logToDesktop(QString("[AlignmentGuide] native-enter %1 edge=%2 cache=%3 geo=(%4,%5,%6,%7)")
+            LOG_DEBUG(Logger::Snap, QString("[AlignmentGuide] native-enter %1 edge=%2 cache=%3 geo=(%4,%5,%6,%7)")
                              .arg(m_id)
                              .arg(m_resizeEdge)
-                             .arg(m_snapRectsCache.size())
+                             .arg(m_snapIndex.obstacleCount())
                              .arg(x())
                              .arg(y())
                              .arg(width())
@@ -1292,20 +2089,16 @@ bool FenceWindow::nativeEvent(const QByteArray &eventType, void *message, long *
             rect->right = snappedGeo.left() + snappedGeo.width();
             rect->bottom = snappedGeo.top() + snappedGeo.height();
 
-            if (m_resizeEdge & Bottom) {
-                updateBottomAlignmentGuide(snappedGeo);
-            } else {
-                clearBottomAlignmentGuides();
-            }
+            updateAlignmentGuides(snappedGeo, m_resizeEdge, false);
 
-            const QString state = QString("native-sizing edge=%1 targetBottom=%2 snappedBottom=%3")
-                                      .arg(m_resizeEdge)
-                                      .arg(targetGeo.bottom() + 1)
-                                      .arg(snappedGeo.bottom() + 1);
-            if (m_alignmentGuideDebugState != state) {
-                m_alignmentGuideDebugState = state;
-                qDebug() << "[AlignmentGuide]" << m_id << state;
-                logToDesktop(QString("[AlignmentGuide] %1 %2").arg(m_id, state));
+            const GuideDebugState state{0, m_resizeEdge, targetGeo.bottom() + 1, snappedGeo.bottom() + 1};
+            if (m_nativeSizingDebugState != state) {
+                m_nativeSizingDebugState = state;
+                LOG_DEBUG(Logger::Snap, QString("[AlignmentGuide] %1 native-sizing edge=%2 targetBottom=%3 snappedBottom=%4")
+                                            .arg(m_id)
+                                            .arg(state.first)
+                                            .arg(state.second)
+                                            .arg(state.third));
             }
         }
     }
@@ -1315,9 +2108,8 @@ bool FenceWindow::nativeEvent(const QByteArray &eventType, void *message, long *
     // 但是我们需要在大小改变后保存位置。
     if (msg->message == WM_EXITSIZEMOVE) {
         if (m_isResizing) {
-            clearBottomAlignmentGuides();
-            qDebug() << "[AlignmentGuide] native-exit" << m_id << "geo=" << geometry();
-            logToDesktop(QString("[AlignmentGuide] native-exit %1 geo=(%2,%3,%4,%5)")
+            AlignmentOverlay::instance()->clear();
+            LOG_DEBUG(Logger::Snap, QString("[AlignmentGuide] native-exit %1 geo=(%2,%3,%4,%5)")
                              .arg(m_id)
                              .arg(x())
                              .arg(y())
@@ -1327,7 +2119,8 @@ bool FenceWindow::nativeEvent(const QByteArray &eventType, void *message, long *
         m_isResizing = false;
         m_resizeEdge = None;
         m_nativeHitResizeEdge = None;
-        m_alignmentGuideDebugState.clear();
+        m_alignmentGuideDebugState = GuideDebugState();
+        m_nativeSizingDebugState = GuideDebugState();
         emit geometryChanged();
     }
     
@@ -1374,30 +2167,22 @@ void FenceWindow::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event)
 
-    // 绘制圆角背景和边框
+    // 圆角背景、标题栏、边框和分隔线按九宫格从缓存贴图，只重绘脏区域
     QPainter p(this);
-    p.setRenderHint(QPainter::Antialiasing);
-    
-    QPainterPath path;
-    path.addRoundedRect(rect(), 10, 10);
-    
-    // 绘制背景 (使用自定义颜色)
-    p.fillPath(path, m_backgroundColor);
-    
-    // 标题栏稍微深一点，与内容区进行视觉区分，减轻一点透明度让它不至于太黑
-    p.setClipPath(path);
-    p.fillRect(QRect(0, 0, width(), 32), QColor(0, 0, 0, 40));
-    p.setClipping(false);
-
-    // 边框
-    p.setPen(QPen(QColor(255, 255, 255, 30), 1));
-    p.drawPath(path);
-
-    // 标题栏分隔线
-    if (!m_collapsed) {
-        p.setPen(QPen(QColor(255, 255, 255, 20), 1));
-        p.drawLine(10, 32, width() - 10, 32);
+    if (m_revealHeight >= 0) {
+        // 折叠/展开动画：外框按当前显示高度绘制，内容区使用快照并裁剪到显示高度内
+        FenceChromeCache::instance()->paint(&p, QSize(width(), m_revealHeight), devicePixelRatioF(),
+                                            m_backgroundColor, m_collapsed);
+        if (!m_collapseSnapshot.isNull()) {
+            p.save();
+            p.setClipRect(QRect(0, 0, width(), m_revealHeight - 1));
+            p.drawPixmap(m_collapseSnapshotPos, m_collapseSnapshot);
+            p.restore();
+        }
+        return;
     }
+    FenceChromeCache::instance()->paint(&p, size(), devicePixelRatioF(), m_backgroundColor, m_collapsed);
+    p.setRenderHint(QPainter::Antialiasing);
     
     // 绘制拖拽插入位置指示器
     if (m_showDropIndicator && !m_dropIndicatorRect.isNull()) {
@@ -1415,6 +2200,13 @@ void FenceWindow::paintEvent(QPaintEvent *event)
         p.drawRoundedRect(indicatorRect, 2, 2);
     }
 
+    // 后台文件操作进度条
+    if (m_fileOpsTotal > 0) {
+        const QRect track = fileOperationProgressRect();
+        p.fillRect(track, QColor(255, 255, 255, 30));
+        p.fillRect(QRect(track.topLeft(), QSize(track.width() * m_fileOpsDone / m_fileOpsTotal, track.height())),
+                   QColor(100, 150, 255, 220));
+    }
 }
 
 QRect FenceWindow::titleBarRect() const
@@ -1422,192 +2214,125 @@ QRect FenceWindow::titleBarRect() const
     return QRect(0, 0, width(), 32);
 }
 
-void FenceWindow::updateBottomAlignmentGuide(const QRect &targetGeo)
+void FenceWindow::updateAlignmentGuides(const QRect &targetGeo, int snapEdges, bool blocked)
 {
-    if (!(m_resizeEdge & Bottom) || m_snapRectsCache.isEmpty() || !m_bottomAlignmentGuide) {
-        const QString state = QString("skip edge=%1 cache=%2 guide=%3")
-                                  .arg(m_resizeEdge)
-                                  .arg(m_snapRectsCache.size())
-                                  .arg(m_bottomAlignmentGuide ? "yes" : "no");
-        if (m_alignmentGuideDebugState != state) {
-            m_alignmentGuideDebugState = state;
-            qDebug() << "[AlignmentGuide]" << m_id << state;
-            logToDesktop(QString("[AlignmentGuide] %1 %2").arg(m_id, state));
-        }
-        clearBottomAlignmentGuides();
-        return;
-    }
+    QVector<AlignmentOverlay::Guide> guides;
+    int alignedEdges = None;
 
+    // 1. 底边对齐：调整下边缘时与其他围栏的下边缘对齐
     const int targetBottom = targetGeo.bottom() + 1;
     int closestBottom = -1;
-    int minDistance = SNAP_THRESHOLD + 1;
-
-    for (const QRect &otherRect : qAsConst(m_snapRectsCache)) {
-        const int otherBottom = otherRect.bottom() + 1;
-        const int distance = qAbs(targetBottom - otherBottom);
-        if (distance <= SNAP_THRESHOLD && distance < minDistance) {
-            minDistance = distance;
-            closestBottom = otherBottom;
-        }
-    }
-
-    if (closestBottom < 0) {
-        const QString state = QString("miss targetBottom=%1 cache=%2")
-                                  .arg(targetBottom)
-                                  .arg(m_snapRectsCache.size());
-        if (m_alignmentGuideDebugState != state) {
-            m_alignmentGuideDebugState = state;
-            qDebug() << "[AlignmentGuide]" << m_id << state;
-            logToDesktop(QString("[AlignmentGuide] %1 %2").arg(m_id, state));
+    enum { GuideSkip, GuideMiss, GuideHit };
+    GuideDebugState state{GuideSkip, m_resizeEdge, targetBottom, m_snapIndex.obstacleCount()};
+    if (!m_isResizing || !(m_resizeEdge & Bottom) || m_snapIndex.obstacleCount() == 0) {
+        state.second = 0;
+    } else if (!m_snapIndex.nearestObstacleBottom(targetBottom, SNAP_THRESHOLD, &closestBottom)) {
+        state.kind = GuideMiss;
+        state.first = 0;
+    } else {
+        state.kind = GuideHit;
+        state.first = closestBottom;
+
+        // 先放连接线，再放各围栏底边上的对齐条
+        QVector<AlignmentOverlay::Guide> bars;
+        int spanLeft = targetGeo.left();
+        int spanRight = targetGeo.right();
+        const int barY = closestBottom - 2;
+        bars.append({AlignmentOverlay::Guide::AlignmentBar,
+                     QRect(targetGeo.left() + 8, barY, qMax(24, targetGeo.width() - 16), 3)});
+        for (FenceWindow *fence : qAsConst(s_allFences)) {
+            if (!fence || fence == this || !fence->isVisible()) {
+                continue;
+            }
+            const QRect fenceGeo = fence->geometry();
+            if (qAbs(fenceGeo.bottom() + 1 - closestBottom) <= 1) {
+                bars.append({AlignmentOverlay::Guide::AlignmentBar,
+                             QRect(fenceGeo.left() + 8, barY, qMax(24, fenceGeo.width() - 16), 3)});
+                spanLeft = qMin(spanLeft, fenceGeo.left());
+                spanRight = qMax(spanRight, fenceGeo.right());
+            }
         }
-        clearBottomAlignmentGuides();
-        return;
+        guides.append({AlignmentOverlay::Guide::AlignmentSpan,
+                       QRect(QPoint(spanLeft, closestBottom - 1), QPoint(spanRight, closestBottom - 1))});
+        guides += bars;
+        alignedEdges |= Bottom;
     }
-
-    const QString state = QString("hit targetBottom=%1 closestBottom=%2 cache=%3")
-                              .arg(targetBottom)
-                              .arg(closestBottom)
-                              .arg(m_snapRectsCache.size());
     if (m_alignmentGuideDebugState != state) {
         m_alignmentGuideDebugState = state;
-        qDebug() << "[AlignmentGuide]" << m_id << state;
-        logToDesktop(QString("[AlignmentGuide] %1 %2").arg(m_id, state));
+        LOG_DEBUG(Logger::Snap, state.kind == GuideSkip
+            ? QString("[AlignmentGuide] %1 skip edge=%2 cache=%3").arg(m_id).arg(state.first).arg(state.third)
+            : state.kind == GuideMiss
+            ? QString("[AlignmentGuide] %1 miss targetBottom=%2 cache=%3").arg(m_id).arg(state.second).arg(state.third)
+            : QString("[AlignmentGuide] %1 hit targetBottom=%2 closestBottom=%3 cache=%4")
+                  .arg(m_id).arg(state.second).arg(state.first).arg(state.third));
     }
 
-    clearBottomAlignmentGuides();
-
-    for (FenceWindow *fence : qAsConst(s_allFences)) {
-        if (!fence || !fence->isVisible()) {
-            continue;
-        }
-
-        if (fence == this) {
-            const int currentLocalY = qMin(targetGeo.height() - 3, qMax(2, closestBottom - targetGeo.top() - 1));
-            fence->showBottomAlignmentGuideAt(currentLocalY);
-            continue;
-        }
-
-        const int fenceBottom = fence->geometry().bottom() + 1;
-        if (qAbs(fenceBottom - closestBottom) <= 1) {
-            fence->showBottomAlignmentGuideAt(qMax(2, fence->height() - 3));
-        }
+    // 2. 落在吸附目标（围栏边缘、工作区边缘或网格线）上的边
+    int edge = 0;
+    snapEdges &= ~alignedEdges;
+    if ((snapEdges & Left) && m_snapIndex.nearestX(targetGeo.left(), 0, &edge)) {
+        guides.append({AlignmentOverlay::Guide::SnapEdge, QRect(edge - 1, targetGeo.top(), 2, targetGeo.height())});
     }
-}
-
-void FenceWindow::showBottomAlignmentGuideAt(int localY)
-{
-    if (!m_bottomAlignmentGuide) {
-        return;
+    if ((snapEdges & Right) && m_snapIndex.nearestX(targetGeo.right() + 1, 0, &edge)) {
+        guides.append({AlignmentOverlay::Guide::SnapEdge, QRect(edge - 1, targetGeo.top(), 2, targetGeo.height())});
     }
-
-    const int guideY = qBound(2, localY, qMax(2, height() - 3));
-    m_bottomAlignmentGuide->setGeometry(8, guideY, qMax(24, width() - 16), 3);
-    m_bottomAlignmentGuide->raise();
-    m_bottomAlignmentGuide->show();
-    qDebug() << "[AlignmentGuide] show" << m_id << "localY=" << guideY
-             << "geo=" << m_bottomAlignmentGuide->geometry();
-    logToDesktop(QString("[AlignmentGuide] show %1 localY=%2 geo=(%3,%4,%5,%6)")
-                     .arg(m_id)
-                     .arg(guideY)
-                     .arg(m_bottomAlignmentGuide->x())
-                     .arg(m_bottomAlignmentGuide->y())
-                     .arg(m_bottomAlignmentGuide->width())
-                     .arg(m_bottomAlignmentGuide->height()));
-}
-
-void FenceWindow::clearBottomAlignmentGuide()
-{
-    if (!m_bottomAlignmentGuide || !m_bottomAlignmentGuide->isVisible()) {
-        return;
+    if ((snapEdges & Top) && m_snapIndex.nearestY(targetGeo.top(), 0, &edge)) {
+        guides.append({AlignmentOverlay::Guide::SnapEdge, QRect(targetGeo.left(), edge - 1, targetGeo.width(), 2)});
+    }
+    if ((snapEdges & Bottom) && m_snapIndex.nearestY(targetGeo.bottom() + 1, 0, &edge)) {
+        guides.append({AlignmentOverlay::Guide::SnapEdge, QRect(targetGeo.left(), edge - 1, targetGeo.width(), 2)});
     }
 
-    m_bottomAlignmentGuide->hide();
-    qDebug() << "[AlignmentGuide] hide" << m_id;
-    logToDesktop(QString("[AlignmentGuide] hide %1").arg(m_id));
-}
-
-void FenceWindow::clearBottomAlignmentGuides()
-{
-    for (FenceWindow *fence : qAsConst(s_allFences)) {
-        if (fence) {
-            fence->clearBottomAlignmentGuide();
+    // 3. 被其他围栏挡住时，标出接触的边
+    if (blocked) {
+        for (const QRect &contact : m_snapIndex.contacts(targetGeo)) {
+            guides.append({AlignmentOverlay::Guide::Collision, contact});
         }
     }
+
+    AlignmentOverlay::instance()->setGuides(guides);
 }
 
 // 边缘吸附：拖动时计算吸附后的位置
 QPoint FenceWindow::snapPositionToOtherFences(const QPoint& targetPos, const QSize& targetSize) const
 {
     QPoint snappedPos = targetPos;
-    int snapX = SNAP_THRESHOLD + 1; // 当前最小X吸附距离
-    int snapY = SNAP_THRESHOLD + 1; // 当前最小Y吸附距离
-    
-    // 当前围栏的目标边缘
-    int myLeft = targetPos.x();
-    int myRight = targetPos.x() + targetSize.width();
-    int myTop = targetPos.y();
-    int myBottom = targetPos.y() + targetSize.height();
-    
-    // 遍历所有其他围栏的缓存
-    for (const QRect& otherRect : qAsConst(m_snapRectsCache)) {
-        int otherLeft = otherRect.left();
-        int otherRight = otherRect.right() + 1; // Qt的right()是width()-1
-        int otherTop = otherRect.top();
-        int otherBottom = otherRect.bottom() + 1;
-        
-        // 水平方向吸附检测
-        // 左边缘对齐其他围栏的左边缘
-        int dist = qAbs(myLeft - otherLeft);
-        if (dist < snapX && dist <= SNAP_THRESHOLD) {
-            snapX = dist;
-            snappedPos.setX(otherLeft);
-        }
-        // 左边缘对齐其他围栏的右边缘
-        dist = qAbs(myLeft - otherRight);
-        if (dist < snapX && dist <= SNAP_THRESHOLD) {
-            snapX = dist;
-            snappedPos.setX(otherRight);
-        }
-        // 右边缘对齐其他围栏的左边缘
-        dist = qAbs(myRight - otherLeft);
-        if (dist < snapX && dist <= SNAP_THRESHOLD) {
-            snapX = dist;
-            snappedPos.setX(otherLeft - targetSize.width());
-        }
-        // 右边缘对齐其他围栏的右边缘
-        dist = qAbs(myRight - otherRight);
-        if (dist < snapX && dist <= SNAP_THRESHOLD) {
-            snapX = dist;
-            snappedPos.setX(otherRight - targetSize.width());
-        }
-        
-        // 垂直方向吸附检测
-        // 上边缘对齐其他围栏的上边缘
-        dist = qAbs(myTop - otherTop);
-        if (dist < snapY && dist <= SNAP_THRESHOLD) {
-            snapY = dist;
-            snappedPos.setY(otherTop);
-        }
-        // 上边缘对齐其他围栏的下边缘
-        dist = qAbs(myTop - otherBottom);
-        if (dist < snapY && dist <= SNAP_THRESHOLD) {
-            snapY = dist;
-            snappedPos.setY(otherBottom);
-        }
-        // 下边缘对齐其他围栏的上边缘
-        dist = qAbs(myBottom - otherTop);
-        if (dist < snapY && dist <= SNAP_THRESHOLD) {
-            snapY = dist;
-            snappedPos.setY(otherTop - targetSize.height());
-        }
-        // 下边缘对齐其他围栏的下边缘
-        dist = qAbs(myBottom - otherBottom);
-        if (dist < snapY && dist <= SNAP_THRESHOLD) {
-            snapY = dist;
-            snappedPos.setY(otherBottom - targetSize.height());
-        }
+    int edge = 0;
+    int leftDistance = SNAP_THRESHOLD + 1;
+    int rightDistance = SNAP_THRESHOLD + 1;
+
+    // 水平方向：左边缘、右边缘各自查找最近的边，取距离更近的一侧
+    int leftEdge = 0;
+    if (m_snapIndex.nearestX(targetPos.x(), SNAP_THRESHOLD, &edge, &leftDistance)) {
+        leftEdge = edge;
     }
-    
+    int rightEdge = 0;
+    if (m_snapIndex.nearestX(targetPos.x() + targetSize.width(), SNAP_THRESHOLD, &edge, &rightDistance)) {
+        rightEdge = edge;
+    }
+    if (leftDistance <= SNAP_THRESHOLD && leftDistance <= rightDistance) {
+        snappedPos.setX(leftEdge);
+    } else if (rightDistance <= SNAP_THRESHOLD) {
+        snappedPos.setX(rightEdge - targetSize.width());
+    }
+
+    // 垂直方向：同理比较上边缘和下边缘
+    int topDistance = SNAP_THRESHOLD + 1;
+    int bottomDistance = SNAP_THRESHOLD + 1;
+    int topEdge = 0;
+    if (m_snapIndex.nearestY(targetPos.y(), SNAP_THRESHOLD, &edge, &topDistance)) {
+        topEdge = edge;
+    }
+    int bottomEdge = 0;
+    if (m_snapIndex.nearestY(targetPos.y() + targetSize.height(), SNAP_THRESHOLD, &edge, &bottomDistance)) {
+        bottomEdge = edge;
+    }
+    if (topDistance <= SNAP_THRESHOLD && topDistance <= bottomDistance) {
+        snappedPos.setY(topEdge);
+    } else if (bottomDistance <= SNAP_THRESHOLD) {
+        snappedPos.setY(bottomEdge - targetSize.height());
+    }
+
     return snappedPos;
 }
 
@@ -1615,65 +2340,50 @@ QPoint FenceWindow::snapPositionToOtherFences(const QPoint& targetPos, const QSi
 QRect FenceWindow::snapGeometryToOtherFences(const QRect& targetGeo, int resizeEdge) const
 {
     QRect snappedGeo = targetGeo;
-    
-    // 遍历所有其他围栏缓存
-    for (const QRect& otherRect : qAsConst(m_snapRectsCache)) {
-        int otherLeft = otherRect.left();
-        int otherRight = otherRect.right() + 1;
-        int otherTop = otherRect.top();
-        int otherBottom = otherRect.bottom() + 1;
-        
-        // 根据调整的边缘进行吸附
-        if (resizeEdge & Left) {
-            int myLeft = snappedGeo.left();
-            // 左边缘对齐其他围栏的左边缘
-            if (qAbs(myLeft - otherLeft) <= SNAP_THRESHOLD) {
-                snappedGeo.setLeft(otherLeft);
-            }
-            // 左边缘对齐其他围栏的右边缘
-            else if (qAbs(myLeft - otherRight) <= SNAP_THRESHOLD) {
-                snappedGeo.setLeft(otherRight);
-            }
-        }
-        
-        if (resizeEdge & Right) {
-            int myRight = snappedGeo.right() + 1;
-            // 右边缘对齐其他围栏的左边缘
-            if (qAbs(myRight - otherLeft) <= SNAP_THRESHOLD) {
-                snappedGeo.setRight(otherLeft - 1);
-            }
-            // 右边缘对齐其他围栏的右边缘
-            else if (qAbs(myRight - otherRight) <= SNAP_THRESHOLD) {
-                snappedGeo.setRight(otherRight - 1);
-            }
-        }
-        
-        if (resizeEdge & Top) {
-            int myTop = snappedGeo.top();
-            // 上边缘对齐其他围栏的上边缘
-            if (qAbs(myTop - otherTop) <= SNAP_THRESHOLD) {
-                snappedGeo.setTop(otherTop);
-            }
-            // 上边缘对齐其他围栏的下边缘
-            else if (qAbs(myTop - otherBottom) <= SNAP_THRESHOLD) {
-                snappedGeo.setTop(otherBottom);
-            }
+    int edge = 0;
+
+    // 只吸附正在调整的边缘
+    if ((resizeEdge & Left) && m_snapIndex.nearestX(snappedGeo.left(), SNAP_THRESHOLD, &edge)) {
+        snappedGeo.setLeft(edge);
+    }
+    if ((resizeEdge & Right) && m_snapIndex.nearestX(snappedGeo.right() + 1, SNAP_THRESHOLD, &edge)) {
+        snappedGeo.setRight(edge - 1);
+    }
+    if ((resizeEdge & Top) && m_snapIndex.nearestY(snappedGeo.top(), SNAP_THRESHOLD, &edge)) {
+        snappedGeo.setTop(edge);
+    }
+    if ((resizeEdge & Bottom) && m_snapIndex.nearestY(snappedGeo.bottom() + 1, SNAP_THRESHOLD, &edge)) {
+        snappedGeo.setBottom(edge - 1);
+    }
+
+    return snappedGeo;
+}
+
+void FenceWindow::rebuildSnapIndex()
+{
+    m_snapIndex.clear();
+    for (FenceWindow* other : qAsConst(s_allFences)) {
+        if (other != this) {
+            m_snapIndex.addObstacle(other->geometry());
         }
-        
-        if (resizeEdge & Bottom) {
-            int myBottom = snappedGeo.bottom() + 1;
-            // 下边缘对齐其他围栏的上边缘
-            if (qAbs(myBottom - otherTop) <= SNAP_THRESHOLD) {
-                snappedGeo.setBottom(otherTop - 1);
-            }
-            // 下边缘对齐其他围栏的下边缘
-            else if (qAbs(myBottom - otherBottom) <= SNAP_THRESHOLD) {
-                snappedGeo.setBottom(otherBottom - 1);
-            }
+    }
+
+    // 所有显示器的工作区边缘（不含任务栏）
+    for (QScreen *screen : QApplication::screens()) {
+        m_snapIndex.addWorkArea(screen->availableGeometry());
+    }
+
+    // 网格以当前所在显示器工作区左上角为原点
+    const int gridSize = ConfigManager::instance()->snapGridSize();
+    if (gridSize > 0) {
+        QScreen *screen = QApplication::screenAt(geometry().center());
+        if (!screen) {
+            screen = QApplication::primaryScreen();
         }
+        m_snapIndex.setGrid(screen ? screen->availableGeometry().topLeft() : QPoint(), gridSize);
     }
-    
-    return snappedGeo;
+
+    m_snapIndex.build();
 }
 
 void FenceWindow::mousePressEvent(QMouseEvent *event)
@@ -1683,7 +2393,7 @@ void FenceWindow::mousePressEvent(QMouseEvent *event)
         m_isResizing = false;
         m_resizeEdge = None;
         m_nativeHitResizeEdge = None;
-        clearBottomAlignmentGuide();
+        AlignmentOverlay::instance()->clear();
         event->ignore();
         return;
     }
@@ -1696,13 +2406,13 @@ void FenceWindow::mousePressEvent(QMouseEvent *event)
         
         // 记录拖曳/调整前的几何状态并刷新吸咐缓存
         m_resizeEdge = None;
-        m_snapRectsCache.clear();
-        clearBottomAlignmentGuide();
-        for (FenceWindow* other : qAsConst(s_allFences)) {
-            if (other != this) {
-                m_snapRectsCache.append(other->geometry());
-            }
-        }
+        AlignmentOverlay::instance()->clear();
+        rebuildSnapIndex();
+        m_moveFrameTimer->stop();
+        m_movePending = false;
+        m_movesReceived = 0;
+        m_movesApplied = 0;
+        m_lastMoveApplied.invalidate();
 
         int x = event->x();
         int y = event->y();
@@ -1723,16 +2433,12 @@ void FenceWindow::mousePressEvent(QMouseEvent *event)
 
         if (m_resizeEdge != None) {
             m_isResizing = true;
-            m_alignmentGuideDebugState.clear();
-            qDebug() << "[AlignmentGuide] press" << m_id
-                     << "edge=" << m_resizeEdge
-                     << "cache=" << m_snapRectsCache.size()
-                     << "geo=" << geometry();
+            m_alignmentGuideDebugState = GuideDebugState();
             const QRect currentGeo = geometry();
-            logToDesktop(QString("[AlignmentGuide] press %1 edge=%2 cache=%3 geo=(%4,%5,%6,%7)")
+            LOG_DEBUG(Logger::Snap, QString("[AlignmentGuide] press %1 edge=%2 cache=%3 geo=(%4,%5,%6,%7)")
                              .arg(m_id)
                              .arg(m_resizeEdge)
-                             .arg(m_snapRectsCache.size())
+                             .arg(m_snapIndex.obstacleCount())
                              .arg(currentGeo.x())
                              .arg(currentGeo.y())
                              .arg(currentGeo.width())
@@ -1770,86 +2476,9 @@ void FenceWindow::mouseMoveEvent(QMouseEvent *event)
         return;
     }
 
-    // 如果正在拖拽
-    if (m_isDragging && (event->buttons() & Qt::LeftButton)) {
-        clearBottomAlignmentGuide();
-        QPoint delta = event->globalPos() - m_dragStartGlobalPos;
-        QPoint newPos = m_resizeStartGeo.topLeft() + delta; // 使用起始几何位置
-        
-        // 1. 应用围栏间边缘吸附
-        QPoint snappedPos = snapPositionToOtherFences(newPos, size());
-        QRect candidateRect(snappedPos, size());
-        
-        // 2. 强制性碰撞检查：禁止重叠
-        for (const QRect& other : qAsConst(m_snapRectsCache)) {
-            if (candidateRect.intersects(other)) {
-                // 根据起始位置判断碰撞面，将其推回边缘
-                if (m_resizeStartGeo.right() <= other.left()) {
-                    candidateRect.moveRight(other.left());
-                } else if (m_resizeStartGeo.left() >= other.right() + 1) {
-                    candidateRect.moveLeft(other.right() + 1);
-                }
-                
-                // 二次检查垂直撞击（处理对角线或已经水平对齐后的碰撞）
-                if (candidateRect.intersects(other)) {
-                    if (m_resizeStartGeo.bottom() <= other.top()) {
-                        candidateRect.moveBottom(other.top());
-                    } else if (m_resizeStartGeo.top() >= other.bottom() + 1) {
-                        candidateRect.moveTop(other.bottom() + 1);
-                    }
-                }
-            }
-        }
-        
-        move(candidateRect.topLeft());
-        event->accept();
-        return;
-    }
-    
-    // 如果正在调整大小
-    if (m_isResizing && (event->buttons() & Qt::LeftButton)) {
-        QPoint delta = event->globalPos() - m_dragStartGlobalPos;
-        QRect newGeo = m_resizeStartGeo;
-        
-        if (m_resizeEdge & Left) {
-            newGeo.setLeft(m_resizeStartGeo.left() + delta.x());
-            if (newGeo.width() < minimumWidth()) newGeo.setLeft(m_resizeStartGeo.right() - minimumWidth());
-        }
-        if (m_resizeEdge & Right) {
-            newGeo.setRight(m_resizeStartGeo.right() + delta.x());
-            if (newGeo.width() < minimumWidth()) newGeo.setRight(m_resizeStartGeo.left() + minimumWidth());
-        }
-        if (m_resizeEdge & Top) {
-            newGeo.setTop(m_resizeStartGeo.top() + delta.y());
-            if (newGeo.height() < minimumHeight()) newGeo.setTop(m_resizeStartGeo.bottom() - minimumHeight());
-        }
-        if (m_resizeEdge & Bottom) {
-            newGeo.setBottom(m_resizeStartGeo.bottom() + delta.y());
-            if (newGeo.height() < minimumHeight()) newGeo.setBottom(m_resizeStartGeo.top() + minimumHeight());
-        }
-        
-        // 1. 应用围栏间边缘吸附
-        newGeo = snapGeometryToOtherFences(newGeo, m_resizeEdge);
-        
-        // 2. 强制性碰撞检查：禁止重叠
-        for (const QRect& other : qAsConst(m_snapRectsCache)) {
-            if (newGeo.intersects(other)) {
-                // 仅限制当前正在调整的边缘，使其不能穿过障碍物边框
-                if (m_resizeEdge & Left) newGeo.setLeft(qMax(newGeo.left(), other.right() + 1));
-                if (m_resizeEdge & Right) newGeo.setRight(qMin(newGeo.right(), other.left() - 1));
-                if (m_resizeEdge & Top) newGeo.setTop(qMax(newGeo.top(), other.bottom() + 1));
-                if (m_resizeEdge & Bottom) newGeo.setBottom(qMin(newGeo.bottom(), other.top() - 1));
-            }
-        }
-        
-        // 3. 确保吸附和碰撞处理后仍满足最小尺寸约束
-        if (newGeo.width() < minimumWidth() || newGeo.height() < minimumHeight()) {
-            // 如果处理导致尺寸过小，回退到逻辑计算的非吸附状态（这是为了防止因吸附死锁而无法反向调整）
-            // 但仍需由 setGeometry 的底层逻辑保证有效性
-        }
-
-        updateBottomAlignmentGuide(newGeo);
-        setGeometry(newGeo);
+    // 拖拽或调整大小：只记录最新的鼠标位置，按显示帧合并后再应用
+    if ((m_isDragging || m_isResizing) && (event->buttons() & Qt::LeftButton)) {
+        queuePointerMove(event->globalPos());
         event->accept();
         return;
     }
@@ -1889,9 +2518,116 @@ void FenceWindow::mouseMoveEvent(QMouseEvent *event)
     event->ignore();
 }
 
+int FenceWindow::frameIntervalNs() const
+{
+    // Qt 5 没有与垂直同步对齐的回调，按所在显示器的刷新率节拍应用几何变化
+    QScreen *currentScreen = screen();
+    const qreal refreshRate = currentScreen ? currentScreen->refreshRate() : 60.0;
+    return int(1000000000.0 / qBound<qreal>(30.0, refreshRate, 360.0));
+}
+
+void FenceWindow::queuePointerMove(const QPoint &globalPos)
+{
+    ++m_movesReceived;
+    m_pendingMoveGlobalPos = globalPos;
+    m_movePending = true;
+
+    if (m_moveFrameTimer->isActive()) {
+        return;
+    }
+
+    // 距上次应用已满一帧则立即应用，否则等到下一帧
+    const qint64 interval = frameIntervalNs();
+    const qint64 elapsed = m_lastMoveApplied.isValid() ? m_lastMoveApplied.nsecsElapsed() : interval;
+    if (elapsed >= interval) {
+        flushPendingMove();
+        return;
+    }
+    m_moveFrameTimer->start(int((interval - elapsed + 999999) / 1000000));
+}
+
+void FenceWindow::flushPendingMove()
+{
+    m_moveFrameTimer->stop();
+    if (!m_movePending) {
+        return;
+    }
+    m_movePending = false;
+    m_lastMoveApplied.start();
+    ++m_movesApplied;
+
+    if (m_isDragging) {
+        applyDragMove(m_pendingMoveGlobalPos);
+    } else if (m_isResizing) {
+        applyResizeMove(m_pendingMoveGlobalPos);
+    }
+}
+
+void FenceWindow::applyDragMove(const QPoint &globalPos)
+{
+    QPoint delta = globalPos - m_dragStartGlobalPos;
+    QPoint newPos = m_resizeStartGeo.topLeft() + delta; // 使用起始几何位置
+    
+    // 1. 应用围栏间边缘吸附
+    QPoint snappedPos = snapPositionToOtherFences(newPos, size());
+    QRect candidateRect(snappedPos, size());
+    
+    // 2. 强制性碰撞检查：禁止重叠（只检查与目标位置相交的候选围栏）
+    candidateRect = m_snapIndex.resolveMove(m_resizeStartGeo, candidateRect);
+    
+    updateAlignmentGuides(candidateRect, Left | Top | Right | Bottom, candidateRect.topLeft() != snappedPos);
+    move(candidateRect.topLeft());
+}
+
+void FenceWindow::applyResizeMove(const QPoint &globalPos)
+{
+    QPoint delta = globalPos - m_dragStartGlobalPos;
+    QRect newGeo = m_resizeStartGeo;
+    
+    if (m_resizeEdge & Left) {
+        newGeo.setLeft(m_resizeStartGeo.left() + delta.x());
+        if (newGeo.width() < minimumWidth()) newGeo.setLeft(m_resizeStartGeo.right() - minimumWidth());
+    }
+    if (m_resizeEdge & Right) {
+        newGeo.setRight(m_resizeStartGeo.right() + delta.x());
+        if (newGeo.width() < minimumWidth()) newGeo.setRight(m_resizeStartGeo.left() + minimumWidth());
+    }
+    if (m_resizeEdge & Top) {
+        newGeo.setTop(m_resizeStartGeo.top() + delta.y());
+        if (newGeo.height() < minimumHeight()) newGeo.setTop(m_resizeStartGeo.bottom() - minimumHeight());
+    }
+    if (m_resizeEdge & Bottom) {
+        newGeo.setBottom(m_resizeStartGeo.bottom() + delta.y());
+        if (newGeo.height() < minimumHeight()) newGeo.setBottom(m_resizeStartGeo.top() + minimumHeight());
+    }
+    
+    // 1. 应用围栏间边缘吸附
+    newGeo = snapGeometryToOtherFences(newGeo, m_resizeEdge);
+    const QRect snappedGeo = newGeo;
+    
+    // 2. 强制性碰撞检查：禁止重叠，仅限制当前正在调整的边缘，使其不能穿过障碍物边框
+    newGeo = m_snapIndex.resolveResize(m_resizeStartGeo, newGeo, m_resizeEdge);
+    
+    // 3. 确保吸附和碰撞处理后仍满足最小尺寸约束
+    if (newGeo.width() < minimumWidth() || newGeo.height() < minimumHeight()) {
+        // 如果处理导致尺寸过小，回退到逻辑计算的非吸附状态（这是为了防止因吸附死锁而无法反向调整）
+        // 但仍需由 setGeometry 的底层逻辑保证有效性
+    }
+
+    updateAlignmentGuides(newGeo, m_resizeEdge, newGeo != snappedGeo);
+    setGeometry(newGeo);
+}
+
 void FenceWindow::mouseReleaseEvent(QMouseEvent *event)
 {
     if (m_isDragging || m_isResizing) {
+        // 先应用尚未到帧的最后一次移动，保证松开时的位置准确
+        flushPendingMove();
+        LOG_DEBUG(Logger::Snap, QString("[FrameMove] %1 received=%2 applied=%3")
+                         .arg(m_id)
+                         .arg(m_movesReceived)
+                         .arg(m_movesApplied));
+
         if (m_isResizing) {
             QApplication::restoreOverrideCursor();
         }
@@ -1932,10 +2668,9 @@ void FenceWindow::mouseReleaseEvent(QMouseEvent *event)
         
         m_isDragging = false;
         m_isResizing = false;
-        clearBottomAlignmentGuide();
-        m_alignmentGuideDebugState.clear();
-        qDebug() << "[AlignmentGuide] release" << m_id << "geo=" << geometry();
-        logToDesktop(QString("[AlignmentGuide] release %1 geo=(%2,%3,%4,%5)")
+        AlignmentOverlay::instance()->clear();
+        m_alignmentGuideDebugState = GuideDebugState();
+        LOG_DEBUG(Logger::Snap, QString("[AlignmentGuide] release %1 geo=(%2,%3,%4,%5)")
                          .arg(m_id)
                          .arg(x())
                          .arg(y())
@@ -1965,15 +2700,16 @@ void FenceWindow::mouseDoubleClickEvent(QMouseEvent *event)
 void FenceWindow::moveEvent(QMoveEvent *event)
 {
     QWidget::moveEvent(event);
-    // 移动时重置定时器，停止移动1秒后触发保存
-    if (!m_restoringFromJson && m_saveTimer) m_saveTimer->start();
+    invalidateSerialization();
+    // 移动时重置定时器，停止移动1秒后触发保存；拖拽中由松开鼠标时统一保存
+    if (!m_restoringFromJson && m_saveTimer && !m_isDragging && !m_isResizing) m_saveTimer->start();
 }
 
 
 void FenceWindow::enterEvent(QEvent *event)
 {
+    // 外框不随悬停变化，无需重绘
     m_hovered = true;
-    update();
     QWidget::enterEvent(event);
 }
 
@@ -1981,7 +2717,6 @@ void FenceWindow::leaveEvent(QEvent *event)
 {
     m_hovered = false;
     setCursor(Qt::ArrowCursor);
-    update();
     QWidget::leaveEvent(event);
 }
 
@@ -1993,7 +2728,21 @@ void FenceWindow::hideEvent(QHideEvent *event)
         show(); // 强制保持显示
     } else {
         QWidget::hideEvent(event);
+        updateIconLoadPriority();
+    }
+}
+
+IconLoadScheduler::Priority FenceWindow::iconLoadPriority() const
+{
+    if (!isVisible()) {
+        return IconLoadScheduler::HiddenPriority;
     }
+    return m_collapsed ? IconLoadScheduler::CollapsedPriority : IconLoadScheduler::VisiblePriority;
+}
+
+void FenceWindow::updateIconLoadPriority()
+{
+    IconLoadScheduler::instance()->setPriority(this, iconLoadPriority());
 }
 
 void FenceWindow::closeEvent(QCloseEvent *event)
@@ -2263,7 +3012,6 @@ void FenceWindow::dragEnterEvent(QDragEnterEvent *event)
         event->setDropAction(Qt::MoveAction);
         event->accept();
         m_hovered = true;
-        update();
     }
 }
 
@@ -2272,7 +3020,6 @@ void FenceWindow::dragMoveEvent(QDragMoveEvent *event)
     if (ConfigManager::instance()->layoutLocked()) {
         clearDropIndicator();
         event->ignore();
-        update();
         return;
     }
 
@@ -2282,44 +3029,35 @@ void FenceWindow::dragMoveEvent(QDragMoveEvent *event)
         
         // 如果是内部图标拖拽，显示插入位置指示器
         if (event->mimeData()->hasFormat("application/x-deskgo-icon")) {
-            // ... (保持原有指示器计算逻辑)
-            QString iconPath = QString::fromUtf8(event->mimeData()->data("application/x-deskgo-icon"));
-            int draggedIconIndex = -1;
-            for (int i = 0; i < m_icons.size(); ++i) {
-                if (m_icons[i]->path() == iconPath) { draggedIconIndex = i; break; }
-            }
-            QPoint contentPos = m_contentArea->mapFrom(this, event->pos());
-            int targetIndex = m_icons.size();
-            QRect indicatorRect;
-            for (int i = 0; i < m_icons.size(); ++i) {
-                IconWidget *icon = m_icons[i];
-                QRect iconRect = icon->geometry();
-                if (contentPos.x() < iconRect.center().x()) {
-                    if (contentPos.y() < iconRect.bottom() + 20) {
-                        targetIndex = i;
-                        indicatorRect = QRect(iconRect.left() - 1, iconRect.top(), 2, iconRect.height());
-                        break;
-                    }
-                }
-            }
-            if (targetIndex == m_icons.size() && !m_icons.isEmpty()) {
-                IconWidget *lastIcon = m_icons.last();
-                QRect lastRect = lastIcon->geometry();
-                indicatorRect = QRect(lastRect.right() + 1, lastRect.top(), 2, lastRect.height());
-            }
-            if (draggedIconIndex != -1) {
-                if ((draggedIconIndex == 0 && targetIndex == 0) ||
-                    (draggedIconIndex == m_icons.size() - 1 && targetIndex == m_icons.size()) ||
+            const int draggedIconIndex = indexOfDraggedIcon(event->mimeData());
+            if (m_gridView) {
+                // 网格按行列直接算出插入位置，不逐个比较图标几何
+                QWidget *viewport = m_gridView->viewport();
+                const QPoint viewportPos = viewport->mapFrom(this, event->pos());
+                m_gridView->autoScrollForDrag(viewportPos);
+                QRect indicatorRect;
+                const int targetIndex = m_gridView->insertionIndexAt(viewportPos, &indicatorRect);
+                if (draggedIconIndex != -1 &&
                     (targetIndex == draggedIconIndex || targetIndex == draggedIconIndex + 1)) {
                     clearDropIndicator();
-                    update();
                     return;
                 }
+                setDropIndicator(targetIndex, indicatorRect.translated(viewport->mapTo(m_contentArea, QPoint(0, 0))));
+                return;
             }
-            m_showDropIndicator = !indicatorRect.isNull();
-            m_dropIndicatorIndex = targetIndex;
-            m_dropIndicatorRect = indicatorRect;
-            update();
+            // 插入位置由 FlowLayout 的行结构二分得出，拖拽中的图标按 id 查表
+            QPoint contentPos = m_contentArea->mapFrom(this, event->pos());
+            QRect indicatorRect;
+            int targetIndex = m_icons.size();
+            if (FlowLayout *flowLayout = dynamic_cast<FlowLayout*>(m_contentLayout)) {
+                targetIndex = flowLayout->insertionIndexAt(contentPos, &indicatorRect);
+            }
+            if (draggedIconIndex != -1 &&
+                (targetIndex == draggedIconIndex || targetIndex == draggedIconIndex + 1)) {
+                clearDropIndicator();
+                return;
+            }
+            setDropIndicator(targetIndex, indicatorRect);
         }
     }
 }
@@ -2329,7 +3067,6 @@ void FenceWindow::dragLeaveEvent(QDragLeaveEvent *event)
     Q_UNUSED(event)
     m_hovered = false;
     clearDropIndicator();
-    update();
 }
 
 
@@ -2340,56 +3077,59 @@ void FenceWindow::dropEvent(QDropEvent *event)
         m_hovered = false;
         clearDropIndicator();
         event->ignore();
-        update();
         return;
     }
 
     const QMimeData *mimeData = event->mimeData();
-    logToDesktop("[dropEvent] Fence: " + m_title);
-    logToDesktop("  hasFormat(x-deskgo-icon): " + QString(mimeData->hasFormat("application/x-deskgo-icon") ? "true" : "false"));
-    logToDesktop("  hasUrls: " + QString(mimeData->hasUrls() ? "true" : "false"));
+    LOG_DEBUG(Logger::Drag, "[dropEvent] Fence: " + m_title);
+    LOG_DEBUG(Logger::Drag, "  hasFormat(x-deskgo-icon): " + QString(mimeData->hasFormat("application/x-deskgo-icon") ? "true" : "false"));
+    LOG_DEBUG(Logger::Drag, "  hasUrls: " + QString(mimeData->hasUrls() ? "true" : "false"));
     
     // 处理内部图标拖放（围栏之间移动图标）
     if (mimeData->hasFormat("application/x-deskgo-icon")) {
         QString iconPath = QString::fromUtf8(mimeData->data("application/x-deskgo-icon"));
-        logToDesktop("  iconPath: " + iconPath);
+        LOG_DEBUG(Logger::Drag, "  iconPath: " + iconPath);
         
-        // 检查图标是否在当前围栏（同围栏内排序）
-        IconWidget *existingIcon = nullptr;
-        int existingIndex = -1;
-        for (int i = 0; i < m_icons.size(); ++i) {
-            if (m_icons[i]->path() == iconPath) {
-                existingIcon = m_icons[i];
-                existingIndex = i;
-                break;
+        // 虚拟化网格内排序
+        const int draggedIndex = indexOfDraggedIcon(mimeData);
+        const int gridIndex = m_gridView ? draggedIndex : -1;
+        if (gridIndex >= 0) {
+            const QPoint viewportPos = m_gridView->viewport()->mapFrom(this, event->pos());
+            int targetIndex = m_gridView->insertionIndexAt(viewportPos, nullptr);
+            LOG_DEBUG(Logger::Drag, "  existingIndex: " + QString::number(gridIndex) + " targetIndex: " + QString::number(targetIndex));
+            if (targetIndex != gridIndex && targetIndex != gridIndex + 1) {
+                if (gridIndex < targetIndex) {
+                    targetIndex--;
+                }
+                m_gridView->moveIcon(gridIndex, targetIndex);
+                emit geometryChanged();
+                LOG_DEBUG(Logger::Drag, "  Reorder completed!");
             }
+
+            event->acceptProposedAction();
+            m_hovered = false;
+            clearDropIndicator();
+            return;
         }
+
+        // 检查图标是否在当前围栏（同围栏内排序）
+        const int existingIndex = m_gridView ? -1 : draggedIndex;
+        IconWidget *existingIcon = existingIndex >= 0 ? m_icons.at(existingIndex) : nullptr;
         
         if (existingIcon) {
             // 图标在同一围栏内，执行拖拽排序
             QPoint dropPos = event->pos();
             QPoint contentPos = m_contentArea->mapFrom(this, dropPos);
             
-            logToDesktop("  Same fence reorder - dropPos: " + QString::number(contentPos.x()) + "," + QString::number(contentPos.y()));
+            LOG_DEBUG(Logger::Drag, "  Same fence reorder - dropPos: " + QString::number(contentPos.x()) + "," + QString::number(contentPos.y()));
             
-            // 计算目标插入位置
+            // 计算目标插入位置：如果放置位置在图标的左半部分且不低于该行下方 20 像素，插入到该图标之前
             int targetIndex = m_icons.size(); // 默认放到末尾
-            
-            for (int i = 0; i < m_icons.size(); ++i) {
-                IconWidget *icon = m_icons[i];
-                QRect iconRect = icon->geometry();
-                
-                // 如果放置位置在图标的左半部分，插入到该位置之前
-                if (contentPos.x() < iconRect.center().x()) {
-                    // 检查 Y 坐标是否在同一行或之前的行
-                    if (contentPos.y() < iconRect.bottom() + 20) {
-                        targetIndex = i;
-                        break;
-                    }
-                }
+            if (FlowLayout *flowLayout = dynamic_cast<FlowLayout*>(m_contentLayout)) {
+                targetIndex = flowLayout->insertionIndexAt(contentPos);
             }
             
-            logToDesktop("  existingIndex: " + QString::number(existingIndex) + " targetIndex: " + QString::number(targetIndex));
+            LOG_DEBUG(Logger::Drag, "  existingIndex: " + QString::number(existingIndex) + " targetIndex: " + QString::number(targetIndex));
             
             // 如果需要移动
             if (targetIndex != existingIndex && targetIndex != existingIndex + 1) {
@@ -2397,6 +3137,7 @@ void FenceWindow::dropEvent(QDropEvent *event)
                 
                 // 从当前位置移除
                 m_icons.removeAt(existingIndex);
+                m_iconIndexValid = false;
                 if (flowLayout) {
                     int layoutIdx = flowLayout->indexOf(existingIcon);
                     if (layoutIdx >= 0) {
@@ -2428,48 +3169,46 @@ void FenceWindow::dropEvent(QDropEvent *event)
                 m_contentArea->update();
                 
                 emit geometryChanged();
-                logToDesktop("  Reorder completed!");
+                LOG_DEBUG(Logger::Drag, "  Reorder completed!");
             }
             
             event->acceptProposedAction();
             m_hovered = false;
             clearDropIndicator();
-            update();
             return;
         }
         
         // 通过 FenceManager 查找源围栏和图标
         // 先获取拖拽源（IconWidget 的父围栏）
         QObject *source = event->source();
-        logToDesktop("  event->source(): " + QString(source ? source->metaObject()->className() : "nullptr"));
+        LOG_DEBUG(Logger::Drag, "  event->source(): " + QString(source ? source->metaObject()->className() : "nullptr"));
         IconWidget *sourceIcon = qobject_cast<IconWidget*>(source);
-        logToDesktop("  sourceIcon: " + QString(sourceIcon ? "found" : "nullptr"));
+        IconGridView *sourceGrid = qobject_cast<IconGridView*>(source);
+        QWidget *sourceWidget = sourceIcon ? static_cast<QWidget*>(sourceIcon) : sourceGrid;
+        LOG_DEBUG(Logger::Drag, "  sourceIcon: " + QString(sourceWidget ? "found" : "nullptr"));
         
-        if (sourceIcon) {
+        if (sourceWidget) {
             // 找到源围栏
             FenceWindow *sourceFence = nullptr;
-            QWidget *parent = sourceIcon->parentWidget();
-            logToDesktop("  Looking for source fence...");
+            QWidget *parent = sourceWidget->parentWidget();
+            LOG_DEBUG(Logger::Drag, "  Looking for source fence...");
             while (parent) {
-                logToDesktop("    parent: " + QString(parent->metaObject()->className()));
+                LOG_DEBUG(Logger::Drag, "    parent: " + QString(parent->metaObject()->className()));
                 sourceFence = qobject_cast<FenceWindow*>(parent);
                 if (sourceFence) break;
                 parent = parent->parentWidget();
             }
-            logToDesktop("  sourceFence: " + QString(sourceFence ? sourceFence->title() : "nullptr"));
+            LOG_DEBUG(Logger::Drag, "  sourceFence: " + QString(sourceFence ? sourceFence->title() : "nullptr"));
             
-            if (sourceFence && sourceFence != this) {
+            const int sourceGridIndex = sourceGrid ? sourceGrid->indexOfPath(iconPath) : -1;
+            if (sourceFence && sourceFence != this && (sourceIcon || sourceGridIndex >= 0)) {
                 // 保存图标数据
-                IconWidget::IconData data = sourceIcon->data();
+                IconWidget::IconData data = sourceIcon ? sourceIcon->data() : sourceGrid->iconAt(sourceGridIndex);
                 const int targetIndex = (m_showDropIndicator && m_dropIndicatorIndex >= 0)
-                    ? qMin(m_dropIndicatorIndex, m_icons.size())
-                    : m_icons.size();
+                    ? qMin(m_dropIndicatorIndex, iconCount())
+                    : iconCount();
                 
-                // 从源围栏移除（不删除文件，只从列表和布局中移除）
-                sourceFence->m_icons.removeOne(sourceIcon);
-                sourceFence->m_contentLayout->removeWidget(sourceIcon);
                 sourceFence->clearDropIndicator();
-                sourceFence->update();
                 
                 // 移动文件到新围栏的存储目录
                 QString storagePath = ConfigManager::instance()->fencesStoragePath() + "/" + m_id;
@@ -2480,47 +3219,29 @@ void FenceWindow::dropEvent(QDropEvent *event)
                 QString newPath = storagePath + QDir::separator() + fileInfo.fileName();
                 newPath = QDir::toNativeSeparators(QDir::cleanPath(newPath));
                 
-                // 如果文件在其他围栏的存储目录中，移动到新位置
+                // 如果文件在其他围栏的存储目录中，后台移动到新位置，移动完成后再把图标从源围栏移过来
                 if (data.path != newPath && QFile::exists(data.path)) {
-                    if (QFile::exists(newPath)) {
-                        QFile::remove(newPath);
-                    }
-                    
-                    bool ok = QFile::rename(data.path, newPath);
-                    if (!ok) {
-                        // 跨驱动器 fallback
-                        if (QFile::copy(data.path, newPath)) {
-                            if (QFile::remove(data.path)) {
-                                ok = true;
-                            } else {
-                                ok = true; // 视为成功
+                    FileOperationQueue::Operation operation;
+                    operation.source = data.path;
+                    operation.destination = newPath;
+
+                    const QPointer<FenceWindow> sourceGuard(sourceFence);
+                    auto transaction = std::make_shared<quint64>(0);
+                    beginFileOperations(1);
+                    *transaction = FileOperationQueue::instance()->submit(this, {operation},
+                        [this, data, sourceGuard, targetIndex, transaction](const FileOperationQueue::Result &result) {
+                            fileOperationDone();
+                            IconWidget::IconData moved = data;
+                            if (result.committed) {
+                                moved.path = result.destination;
+                                moved.targetPath = result.destination;
                             }
-                        }
-                    }
-
-                    if (ok) {
-                        data.path = newPath;
-                        data.targetPath = newPath;
-                    }
-                }
-                
-                // 销毁旧的 IconWidget
-                sourceIcon->deleteLater();
-                
-                // 创建新的 IconWidget 并按插入符位置插入到当前围栏
-                IconWidget *newIcon = new IconWidget(data);
-                connect(newIcon, &IconWidget::removeRequested, [this, newIcon]() {
-                    removeIcon(newIcon);
-                });
-                insertIconAt(newIcon, targetIndex);
-                updatePlaceholder();
-                
-                emit sourceFence->geometryChanged();  // 触发源围栏保存
-                emit geometryChanged();  // 触发当前围栏保存
-
-                FenceManager::instance()->saveFences();
-                if (!ConfigManager::instance()->sync()) {
-                    logToDesktop("[dropEvent] Cross-fence move committed in memory but failed to sync immediately.");
+                            completeCrossFenceMove(sourceGuard, moved, data.path, targetIndex,
+                                                   result.committed ? *transaction : 0);
+                        },
+                        nullptr);
+                } else {
+                    completeCrossFenceMove(sourceFence, data, data.path, targetIndex, 0);
                 }
             }
         }
@@ -2528,7 +3249,6 @@ void FenceWindow::dropEvent(QDropEvent *event)
         event->acceptProposedAction();
         m_hovered = false;
         clearDropIndicator();
-        update();
         return;
     }
     
@@ -2537,8 +3257,6 @@ void FenceWindow::dropEvent(QDropEvent *event)
         qDebug() << "[dropEvent] Processing URLs...";
         qDebug() << "  URL count:" << mimeData->urls().count();
         
-        QFileIconProvider iconProvider;
-        
         // 确保存储目录存在
         // 使用 ConfigManager 统一的存储路径
         QString storagePath = ConfigManager::instance()->fencesStoragePath() + "/" + m_id;
@@ -2550,6 +3268,10 @@ void FenceWindow::dropEvent(QDropEvent *event)
         QString publicDesktopPath = "C:/Users/Public/Desktop"; // 常见公共桌面路径
         qDebug() << "  desktopPath:" << desktopPath;
         
+        // 桌面文件整批交给后台移动；其他文件留在原处，直接添加，只在最后布局、刷新并标记保存一次
+        QList<FileOperationQueue::Operation> moves;
+        QVector<QPoint> movePositions;
+        beginIconUpdate();
         for (const QUrl &url : mimeData->urls()) {
             qDebug() << "  Processing URL:" << url;
             if (url.isLocalFile()) {
@@ -2564,151 +3286,31 @@ void FenceWindow::dropEvent(QDropEvent *event)
                                      absolutePath.compare(normalizedPublicDesktopPath, Qt::CaseInsensitive) == 0;
                 qDebug() << "    isDesktopFile:" << isDesktopFile;
 
-                QPoint originalPos(-1, -1);
-                QString targetPath = srcPath;
-                QString originalSourcePath;
-                bool moved = false;
-
                 if (isDesktopFile) {
-                    originalPos = DesktopHelper::getIconPosition(srcPath);
-                    qDebug() << "    originalPos:" << originalPos;
-                    originalSourcePath = normalizePath(srcPath);
-                    
-                    // 先移动文件到存储目录，确认成功后再通知 shell 更新
-                    QString newPath = storagePath + QDir::separator() + fileInfo.fileName();
-                    newPath = normalizePath(newPath);
-                    qDebug() << "    newPath:" << newPath;
-                    
-                    qDebug() << "    Attempting to move file...";
-                    if (!QDir().mkpath(storagePath)) {
-                        qDebug() << "    Failed to create storage directory:" << storagePath;
-                    }
-
-                    // 确保 srcPath 确实是指向 .lnk 本身而非被解析后的目标
-                    // 有时拖放过来的 URL 会被 Qt 自动解析
-                    qDebug() << "    Final Source check:" << srcPath;
-
-                    bool ok = QFile::rename(srcPath, newPath);
-                    if (!ok) {
-                        qDebug() << "    Rename failed:" << QFile(srcPath).errorString() << ". Attempting copy + remove...";
-                        if (QFile::exists(newPath)) {
-                            QFile::remove(newPath);
-                        }
-                        
-                        // 尝试 Qt 复制
-                        if (QFile::copy(srcPath, newPath)) {
-                            ok = QFile::remove(srcPath);
-                        } else {
-                            // 终极回退：使用 Windows 原生 WinAPI 进行复制
-                            // 这通常能解决 Qt 报 "Unknown error" 的底层权限/锁定问题
-                            qDebug() << "    Qt copy failed, trying WinAPI CopyFileW...";
-                            if (CopyFileW((const wchar_t*)srcPath.utf16(), (const wchar_t*)newPath.utf16(), FALSE)) {
-                                ok = QFile::remove(srcPath);
-                            }
-                        }
-
-                        if (!ok) {
-                            QFile::remove(newPath);
-                            qDebug() << "    Move FAILED even with WinAPI!";
-                        }
-                    }
-
-                    if (ok) {
-                        targetPath = newPath;
-                        moved = true;
-                        DesktopHelper::notifyFileRemoved(srcPath);
-                        qDebug() << "    Move SUCCESS!";
-                    } else {
-                        qDebug() << "    Move FATAL! Source:" << srcPath;
-                        QMessageBox::critical(this, tr("Permission Error"),
-                            tr("Cannot move file: %1\n\nTry running as administrator, or check if the file is in use.").arg(fileInfo.fileName()));
-                        continue;
-                    }
-                } else {
-                    qDebug() << "    Not a desktop file, keeping at original location";
-                }
-                
-                if (srcPath.endsWith(".lnk", Qt::CaseInsensitive)) {
-                     // 对于快捷方式，我们需要确保图标是针对 .lnk 获取的，而不是目标文件
-                     // getWinIcon 已经处理了这个问题
-                }
-                
-                // 确保对 targetPath（即移动后的新位置）进行 QFileInfo 包装，获取最新的元数据
-                QFileInfo newFileInfo(targetPath);
-                
-                IconWidget::IconData data;
-                data.name = displayNameForFile(newFileInfo);
-                
-                data.path = targetPath;
-                data.targetPath = targetPath;
-                data.originalSourcePath = originalSourcePath;
-                qDebug() << "    Creating icon with name:" << data.name << "path:" << data.path;
-                
-                // 优先使用 WinAPI 获取图标
-                data.icon = IconHelper::getWinIcon(targetPath);
-                qDebug() << "    getWinIcon result:" << (data.icon.isNull() ? "NULL" : QString("OK, size: %1x%2").arg(data.icon.width()).arg(data.icon.height()));
-                
-                if (data.icon.isNull()) {
-                    data.icon = iconProvider.icon(newFileInfo).pixmap(48, 48);
-                    qDebug() << "    iconProvider fallback result:" << (data.icon.isNull() ? "NULL" : "OK");
+                    FileOperationQueue::Operation operation;
+                    operation.source = srcPath;
+                    operation.destination = normalizePath(storagePath + QDir::separator() + fileInfo.fileName());
+                    qDebug() << "    newPath:" << operation.destination;
+                    moves.append(operation);
+                    movePositions.append(DesktopHelper::getIconPosition(srcPath));
+                    qDebug() << "    originalPos:" << movePositions.last();
+                    continue;
                 }
-                
-                if (data.icon.isNull()) {
-                     data.icon = iconProvider.icon(QFileIconProvider::File).pixmap(48, 48);
-                     qDebug() << "    Final fallback result:" << (data.icon.isNull() ? "NULL" : "OK");
-                }
-
-                data.originalPosition = originalPos;
-                data.isFromDesktop = moved;
-                
-                IconWidget *iconWidget = new IconWidget(data);
-                addIcon(iconWidget);
 
-                if (moved) {
-                    FenceManager::instance()->saveFences();
-                    if (!ConfigManager::instance()->sync()) {
-                        logToDesktop("[dropEvent] Immediate sync failed after desktop file move, rolling back file move.");
-                        m_icons.removeOne(iconWidget);
-                        m_contentLayout->removeWidget(iconWidget);
-                        iconWidget->hide();
-                        iconWidget->deleteLater();
-                        updatePlaceholder();
-
-                        QString rollbackTarget = originalSourcePath;
-                        if (!rollbackTarget.isEmpty() &&
-                            normalizePath(targetPath).compare(rollbackTarget, Qt::CaseInsensitive) != 0 &&
-                            QFile::exists(targetPath)) {
-                            if (QFile::exists(rollbackTarget)) {
-                                QFile::remove(rollbackTarget);
-                            }
-                            if (QFile::rename(targetPath, rollbackTarget) || QFile::copy(targetPath, rollbackTarget)) {
-                                if (QFile::exists(targetPath) &&
-                                    normalizePath(targetPath).compare(rollbackTarget, Qt::CaseInsensitive) != 0) {
-                                    QFile::remove(targetPath);
-                                }
-                                DesktopHelper::notifyFileAdded(rollbackTarget);
-                                if (originalPos.x() >= 0 && originalPos.y() >= 0) {
-                                    DesktopHelper::setIconPosition(rollbackTarget, originalPos);
-                                }
-                            }
-                        }
-
-                        FenceManager::instance()->saveFences();
-                        QMessageBox::critical(this, tr("Save Failed"),
-                            tr("DeskGo moved the desktop file, but could not safely persist the fence state. The file has been restored to the desktop."));
-                        continue;
-                    }
-                }
+                qDebug() << "    Not a desktop file, keeping at original location";
+                addIcon(new IconWidget(iconDataForFile(srcPath)));
             }
         }
-        
+        endIconUpdate();
+
+        if (!moves.isEmpty()) {
+            moveDesktopFilesIn(moves, movePositions);
+        }
         event->acceptProposedAction();
-        emit geometryChanged();
     }
     
     m_hovered = false;
     clearDropIndicator();
-    update();
 }
 
 void FenceWindow::startTitleEdit()
@@ -2830,6 +3432,11 @@ void FenceWindow::finishTitleEdit()
 
 bool FenceWindow::eventFilter(QObject *watched, QEvent *event)
 {
+    // 虚拟化网格始终铺满内容区域
+    if (watched == m_contentArea && event->type() == QEvent::Resize && m_gridView) {
+        m_gridView->setGeometry(m_contentArea->rect());
+    }
+
     // 只处理当前窗口及其子控件的事件
     if (event->type() == QEvent::MouseMove) {
         // 如果正在调整大小或拖拽，不需要额外处理光标，交由 mouseMoveEvent 处理
@@ -2913,7 +3520,7 @@ bool FenceWindow::eventFilter(QObject *watched, QEvent *event)
 void FenceWindow::updatePlaceholder()
 {
     if (m_placeholderLabel) {
-        m_placeholderLabel->setVisible(m_icons.isEmpty());
+        m_placeholderLabel->setVisible(iconCount() == 0);
         if (m_placeholderLabel->isVisible()) {
             m_placeholderLabel->setGeometry(m_contentArea->rect());
         }
@@ -1,21 +1,29 @@
 #ifndef FENCEWINDOW_H
 #define FENCEWINDOW_H
 
+#include <QJsonObject>
+#include <QHash>
 #include <QLabel>
 #include <QLineEdit>
 #include <QVBoxLayout>
 #include <QPropertyAnimation>
 #include <QUuid>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QPointer>
 #include <QMoveEvent>
 #include <QResizeEvent>
+#include "fileoperationqueue.h"
+#include "iconloadscheduler.h"
+#include "iconwidget.h"
+#include "snapedgeindex.h"
 
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
 
-class IconWidget;
+class IconGridView;
+class QMimeData;
 
 /**
  * @brief 桌面围栏窗口
@@ -31,7 +39,7 @@ public:
     ~FenceWindow();
 
     QString id() const { return m_id; }
-    void setId(const QString &id) { m_id = id; }
+    void setId(const QString &id) { m_id = id; invalidateSerialization(); }
 
     QString title() const;
     void setTitle(const QString &title);
@@ -40,9 +48,14 @@ public:
     void setCollapsed(bool collapsed);
 
     void addIcon(IconWidget *icon);
+    // 显式批量更新范围，可嵌套；最外层 endIconUpdate 时统一布局、刷新占位提示并标记保存
+    void beginIconUpdate();
+    void endIconUpdate();
     void removeIcon(IconWidget *icon);
     void restoreAllIcons();
+    // 控件模式下的图标控件；虚拟化网格模式下图标只存在于网格中，返回空列表
     QList<IconWidget*> icons() const;
+    int iconCount() const;
     
     // 标记窗口已经嵌入桌面
     void setDesktopEmbedded(bool embedded) { m_desktopEmbedded = embedded; }
@@ -71,14 +84,23 @@ public:
     void flushPendingSave();
 
     bool isRestoringFromJson() const { return m_restoringFromJson; }
+    // 正在拖动或调整围栏大小
+    bool isInteracting() const { return m_isDragging || m_isResizing; }
     
     // 仅停止保存定时器，不触发任何保存信号（用于还原场景，防止覆盖已还原数据）
     void stopSaveTimer();
 
 
-    // 序列化
+    // 序列化（结果会被缓存，直到围栏的持久化状态再次变化）
     QJsonObject toJson() const;
     static FenceWindow* fromJson(const QJsonObject &json);
+    // 在线还原：按保存的记录原地更新标题、几何、折叠状态和图标，已有的图标不重新加载
+    void applyJson(const QJsonObject &json);
+    // 存储目录切换到新一代后，把指向旧目录的图标路径改写到新目录下（文件内容相同，不重新加载）
+    void rebaseStoragePaths(const QString &oldRoot, const QString &newRoot);
+
+    // 序列化版本号：持久化状态每变化一次就取一个新的全局递增值
+    quint64 serializationRevision() const { return m_serializationRevision; }
 
 signals:
     void collapsedChanged(bool collapsed);
@@ -115,20 +137,50 @@ protected:
 private:
     void setupUi();
     void setupBlurEffect();
+    void invalidateSerialization();
+    IconLoadScheduler::Priority iconLoadPriority() const;
+    void updateIconLoadPriority();
+    // 把后台加载完成的图标分批套用到占位图标上（每批受时间预算限制）
+    static QTimer *iconDeliveryTimer();
+    static void applyPendingIconBatch();
+    // 插入位置指示器变化时只重绘新旧指示器所在的区域
+    void setDropIndicator(int index, const QRect &rect);
     void clearDropIndicator();
+    QRect dropIndicatorDirtyRect() const;
+    // 拖拽中的图标在本围栏中的下标：网格模式按路径、控件模式按 IconWidget id 查表，不在本围栏返回 -1
+    int indexOfDraggedIcon(const QMimeData *mimeData) const;
+    bool addIconAt(IconWidget *icon, int index);
     void insertIconAt(IconWidget *icon, int index);
+    // 图标数达到配置阈值后改用 IconGridView 显示，已有图标按顺序迁入
+    void switchToGridView();
+    bool containsIconPath(const QString &path) const;
+    // 按保存的图标记录放入占位图标并提交异步加载；每条记录自带插入位置（超出范围时截到末尾），负数表示追加
+    void restoreIconEntries(const QList<QPair<int, QJsonObject>> &entries);
+    // 把图标对应的文件移回桌面（来自桌面）或删除（其他），文件就位后移除图标条目。
+    // 移回桌面默认交给 FileOperationQueue 在后台执行，synchronous 时在当前线程完成（删除围栏）
+    void restoreIconFile(const IconWidget::IconData &data, bool synchronous = false);
+    void completeIconRemoval(const QString &path, quint64 transaction);
+    // transaction 非 0 时，布局落盘成功后确认该文件操作事务
+    void finishIconRemoval(quint64 transaction = 0);
+    // 桌面文件移入围栏：整批作为一个事务在后台移动，每个文件移动完成后才加入图标
+    void moveDesktopFilesIn(const QList<FileOperationQueue::Operation> &moves, const QVector<QPoint> &positions);
+    void completeCrossFenceMove(FenceWindow *sourceFence, const IconWidget::IconData &data,
+                                const QString &oldPath, int targetIndex, quint64 transaction);
+    IconWidget::IconData iconDataForFile(const QString &path) const;
+    void removeGridIcon(const QString &path);
+    // 只从围栏中移除图标条目，不处理文件
+    void discardIconEntry(const QString &path);
     QRect titleBarRect() const;
-    void updateBottomAlignmentGuide(const QRect &targetGeo);
-    void showBottomAlignmentGuideAt(int localY);
-    void clearBottomAlignmentGuide();
-    static void clearBottomAlignmentGuides();
+    // 计算底边对齐线、已吸附的边（snapEdges 中的边）和碰撞接触边，交给 AlignmentOverlay 绘制
+    void updateAlignmentGuides(const QRect &targetGeo, int snapEdges, bool blocked);
     
     // 边缘吸附功能
     static const int SNAP_THRESHOLD = 10; // 吸附阈值（像素）
     QPoint snapPositionToOtherFences(const QPoint& targetPos, const QSize& targetSize) const;
     QRect snapGeometryToOtherFences(const QRect& targetGeo, int resizeEdge) const;
-    // 缓存其他围栏尺寸以防止高频对象访问
-    QList<QRect> m_snapRectsCache;
+    // 按下鼠标开始拖动/调整大小时构建：其他围栏、显示器工作区边缘和网格
+    void rebuildSnapIndex();
+    SnapEdgeIndex m_snapIndex;
 
     QString m_id;
     QLabel *m_titleLabel;
@@ -136,6 +188,14 @@ private:
     QWidget *m_contentArea;
     QLayout *m_contentLayout;
     QList<IconWidget*> m_icons;
+    mutable QHash<quint64, int> m_iconIndexById;
+    mutable bool m_iconIndexValid = false;
+    IconGridView *m_gridView = nullptr;
+
+    // 批量更新状态
+    int m_iconUpdateDepth = 0;
+    bool m_iconLayoutDirty = false;
+    bool m_iconsChanged = false;
 
     QString m_title;
     bool m_collapsed = false;
@@ -160,10 +220,37 @@ private:
     QPoint m_dragStartPos;
     QPoint m_dragStartGlobalPos;
 
+    // 拖拽/调整大小的帧节流：鼠标事件只记录最新位置，每个显示帧最多应用一次几何变化
+    QTimer *m_moveFrameTimer = nullptr;
+    QElapsedTimer m_lastMoveApplied;
+    QPoint m_pendingMoveGlobalPos;
+    bool m_movePending = false;
+    // 统计：收到的鼠标移动次数 / 实际应用的次数，松开鼠标时写入日志
+    quint64 m_movesReceived = 0;
+    quint64 m_movesApplied = 0;
+    int frameIntervalNs() const;
+    void queuePointerMove(const QPoint &globalPos);
+    void flushPendingMove();
+    void applyDragMove(const QPoint &globalPos);
+    void applyResizeMove(const QPoint &globalPos);
+
 
     // 视觉效果
     bool m_hovered = false;
     QVariantAnimation *m_collapseAnimation = nullptr;
+    // 折叠/展开动画期间的显示高度（-1 表示不在动画中）和内容区快照
+    int m_revealHeight = -1;
+    QPixmap m_collapseSnapshot;
+    QPoint m_collapseSnapshotPos;
+    void beginCollapseSnapshot();
+    void endCollapseSnapshot(bool contentVisible);
+
+    // 后台文件操作进度（本围栏提交的全部事务合计），显示在标题栏下方
+    int m_fileOpsDone = 0;
+    int m_fileOpsTotal = 0;
+    void beginFileOperations(int count);
+    void fileOperationDone();
+    QRect fileOperationProgressRect() const;
     
     // 桌面嵌入状态
     bool m_desktopEmbedded = false;
@@ -194,13 +281,30 @@ private:
     int m_dropIndicatorIndex = -1;
     QRect m_dropIndicatorRect;
 
-    // 底边缩放对齐线
-    QWidget *m_bottomAlignmentGuide = nullptr;
-    QString m_alignmentGuideDebugState;
+    // 底边缩放对齐线：上一次记录的调试状态，每次移动只比较数值，变化时才格式化日志
+    struct GuideDebugState {
+        int kind = -1; // -1 表示尚未记录
+        int first = 0;
+        int second = 0;
+        int third = 0;
+
+        bool operator!=(const GuideDebugState &other) const
+        {
+            return kind != other.kind || first != other.first || second != other.second || third != other.third;
+        }
+    };
+    GuideDebugState m_alignmentGuideDebugState;
+    GuideDebugState m_nativeSizingDebugState;
 
     // 视觉样式
     QColor m_backgroundColor = QColor(30, 30, 35, 200);
 
+    // 序列化缓存
+    mutable QJsonObject m_cachedJson;
+    mutable bool m_cachedJsonValid = false;
+    quint64 m_serializationRevision = 0;
+    static quint64 s_nextSerializationRevision;
+
     // 标题编辑
     // 状态保存
     QTimer *m_saveTimer;
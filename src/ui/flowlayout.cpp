@@ -1,5 +1,7 @@
 #include "flowlayout.h"
 #include <QWidget>
+#include <algorithm>
+#include <climits>
 
 FlowLayout::FlowLayout(QWidget *parent, int margin, int hSpacing, int vSpacing)
     : QLayout(parent), m_hSpace(hSpacing), m_vSpace(vSpacing)
@@ -22,14 +24,17 @@ FlowLayout::~FlowLayout()
 
 void FlowLayout::addItem(QLayoutItem *item)
 {
+    markDirtyFrom(m_itemList.size());
     m_itemList.append(item);
 }
 
 void FlowLayout::insertItem(int index, QLayoutItem *item)
 {
     if (index < 0 || index > m_itemList.size()) {
+        markDirtyFrom(m_itemList.size());
         m_itemList.append(item);
     } else {
+        markDirtyFrom(index);
         m_itemList.insert(index, item);
     }
 }
@@ -74,11 +79,68 @@ QLayoutItem *FlowLayout::itemAt(int index) const
 
 QLayoutItem *FlowLayout::takeAt(int index)
 {
-    if (index >= 0 && index < m_itemList.size())
+    if (index >= 0 && index < m_itemList.size()) {
+        markDirtyFrom(index);
         return m_itemList.takeAt(index);
+    }
     return nullptr;
 }
 
+void FlowLayout::invalidate()
+{
+    // 子控件 updateGeometry()/显示隐藏都会走到这里，尺寸提示可能已变化
+    m_itemCacheValid = false;
+    m_heightForWidth.clear();
+    m_dirtyFrom = 0;
+    m_rowsValid = false;
+    QLayout::invalidate();
+}
+
+void FlowLayout::markDirtyFrom(int index)
+{
+    m_itemCacheValid = false;
+    m_heightForWidth.clear();
+    m_dirtyFrom = qMin(m_dirtyFrom, index);
+    m_rowsValid = false;
+    if (m_placedGeometry.size() > index) {
+        m_placedGeometry.resize(index);
+    }
+}
+
+void FlowLayout::ensureItemCache() const
+{
+    if (m_itemCacheValid) {
+        return;
+    }
+
+    m_sizeHints.resize(m_itemList.size());
+    QSize minimum;
+    for (int i = 0; i < m_itemList.size(); ++i) {
+        const QLayoutItem *item = m_itemList.at(i);
+        m_sizeHints[i] = item->sizeHint();
+        minimum = minimum.expandedTo(item->minimumSize());
+    }
+    const QMargins margins = contentsMargins();
+    m_minimumSize = minimum + QSize(margins.left() + margins.right(), margins.top() + margins.bottom());
+
+    // 控件提供的默认 spacing 只需在缓存失效时取一次
+    int defaultSpaceX = -1;
+    int defaultSpaceY = -1;
+    if (!m_itemList.isEmpty()) {
+        const QWidget *wid = m_itemList.first()->widget();
+        if (wid) {
+            defaultSpaceX = wid->style()->layoutSpacing(QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Horizontal);
+            defaultSpaceY = wid->style()->layoutSpacing(QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Vertical);
+        }
+    }
+    m_spaceX = horizontalSpacing();
+    if (m_spaceX == -1) m_spaceX = (defaultSpaceX != -1) ? defaultSpaceX : 0;
+    m_spaceY = verticalSpacing();
+    if (m_spaceY == -1) m_spaceY = (defaultSpaceY != -1) ? defaultSpaceY : 0;
+
+    m_itemCacheValid = true;
+}
+
 Qt::Orientations FlowLayout::expandingDirections() const
 {
     return {};
@@ -91,7 +153,16 @@ bool FlowLayout::hasHeightForWidth() const
 
 int FlowLayout::heightForWidth(int width) const
 {
-    int height = doLayout(QRect(0, 0, width, 0), true);
+    // 调整大小时 Qt 会对同一宽度反复询问
+    const auto it = m_heightForWidth.constFind(width);
+    if (it != m_heightForWidth.constEnd()) {
+        return it.value();
+    }
+    if (m_heightForWidth.size() >= 256) {
+        m_heightForWidth.clear();
+    }
+    const int height = doLayout(QRect(0, 0, width, 0), true);
+    m_heightForWidth.insert(width, height);
     return height;
 }
 
@@ -108,13 +179,8 @@ QSize FlowLayout::sizeHint() const
 
 QSize FlowLayout::minimumSize() const
 {
-    QSize size;
-    for (const QLayoutItem *item : qAsConst(m_itemList))
-        size = size.expandedTo(item->minimumSize());
-
-    const QMargins margins = contentsMargins();
-    size += QSize(margins.left() + margins.right(), margins.top() + margins.bottom());
-    return size;
+    ensureItemCache();
+    return m_minimumSize;
 }
 
 int FlowLayout::doLayout(const QRect &rect, bool testOnly) const
@@ -126,48 +192,167 @@ int FlowLayout::doLayout(const QRect &rect, bool testOnly) const
     // 安全检查：如果空间太小，直接返回
     if (effectiveRect.isValid() == false || effectiveRect.width() <= 0) {
         // 由于 flowlayout.cpp 无法直接访问 logToDesktop，我们暂时用 qDebug
+        if (!testOnly) {
+            m_rows.clear();
+            m_tailMaxCenterX.clear();
+            m_rowsValid = true;
+        }
         return top + bottom; 
     }
     
+    ensureItemCache();
+
     int x = effectiveRect.x();
     int y = effectiveRect.y();
     int lineHeight = 0;
 
-    // 提前在循环外计算控件提供的默认 spacing，避免循环内的高频阻塞
-    int defaultSpaceX = -1;
-    int defaultSpaceY = -1;
-    if (!m_itemList.isEmpty()) {
-        const QWidget *wid = m_itemList.first()->widget();
-        if (wid) {
-            defaultSpaceX = wid->style()->layoutSpacing(QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Horizontal);
-            defaultSpaceY = wid->style()->layoutSpacing(QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Vertical);
-        }
+    if (!testOnly) {
+        m_placedGeometry.resize(m_itemList.size());
+        m_rows.clear();
     }
 
-    for (QLayoutItem *item : qAsConst(m_itemList)) {
-        int spaceX = horizontalSpacing();
-        if (spaceX == -1) spaceX = (defaultSpaceX != -1) ? defaultSpaceX : 0;
-            
-        int spaceY = verticalSpacing();
-        if (spaceY == -1) spaceY = (defaultSpaceY != -1) ? defaultSpaceY : 0;
+    for (int i = 0; i < m_itemList.size(); ++i) {
+        const QSize &hint = m_sizeHints.at(i);
 
-        int nextX = x + item->sizeHint().width() + spaceX;
-        if (nextX - spaceX > effectiveRect.right() && lineHeight > 0) {
+        int nextX = x + hint.width() + m_spaceX;
+        if (nextX - m_spaceX > effectiveRect.right() && lineHeight > 0) {
+            if (!testOnly) {
+                m_rows.last().bottom = y + lineHeight - 1;
+            }
             x = effectiveRect.x();
-            y = y + lineHeight + spaceY;
-            nextX = x + item->sizeHint().width() + spaceX;
+            y = y + lineHeight + m_spaceY;
+            nextX = x + hint.width() + m_spaceX;
             lineHeight = 0;
         }
 
-        if (!testOnly)
-            item->setGeometry(QRect(QPoint(x, y), item->sizeHint()));
+        if (!testOnly) {
+            if (lineHeight == 0 && (m_rows.isEmpty() || m_rows.last().top != y)) {
+                Row row;
+                row.first = i;
+                row.top = y;
+                m_rows.append(row);
+            }
+            Row &row = m_rows.last();
+            ++row.count;
+            row.lastCenterX = x + (hint.width() - 1) / 2;
+
+            // 只重新放置新插入之后或位置确实变化的子项
+            const QRect geometry(QPoint(x, y), hint);
+            if (i >= m_dirtyFrom || m_placedGeometry.at(i) != geometry) {
+                m_itemList.at(i)->setGeometry(geometry);
+                m_placedGeometry[i] = geometry;
+            }
+        }
 
         x = nextX;
-        lineHeight = qMax(lineHeight, item->sizeHint().height());
+        lineHeight = qMax(lineHeight, hint.height());
+    }
+
+    if (!testOnly) {
+        m_dirtyFrom = m_itemList.size();
+        if (!m_rows.isEmpty()) {
+            m_rows.last().bottom = y + lineHeight - 1;
+        }
+        m_tailMaxCenterX.resize(m_rows.size());
+        int tailMax = INT_MIN;
+        for (int r = m_rows.size() - 1; r >= 0; --r) {
+            tailMax = qMax(tailMax, m_rows.at(r).lastCenterX);
+            m_tailMaxCenterX[r] = tailMax;
+        }
+        m_rowsValid = true;
     }
     return y + lineHeight - rect.y() + bottom;
 }
 
+void FlowLayout::ensureRows() const
+{
+    if (!m_rowsValid || m_placedGeometry.size() != m_itemList.size()) {
+        doLayout(geometry(), false);
+    }
+}
+
+int FlowLayout::rowCount() const
+{
+    ensureRows();
+    return m_rows.size();
+}
+
+int FlowLayout::columnCount(int row) const
+{
+    ensureRows();
+    return (row >= 0 && row < m_rows.size()) ? m_rows.at(row).count : 0;
+}
+
+int FlowLayout::indexAt(int row, int column) const
+{
+    ensureRows();
+    if (row < 0 || row >= m_rows.size() || column < 0 || column >= m_rows.at(row).count) {
+        return -1;
+    }
+    return m_rows.at(row).first + column;
+}
+
+QRect FlowLayout::itemGeometry(int index) const
+{
+    ensureRows();
+    return m_placedGeometry.value(index);
+}
+
+int FlowLayout::insertionIndexAt(const QPoint &pos, QRect *indicatorRect) const
+{
+    ensureRows();
+
+    const int itemCount = m_itemList.size();
+    int index = itemCount;
+
+    // 区域过小（如折叠状态还原的围栏）时没有排布结果，只能追加到末尾
+    if (m_placedGeometry.size() != itemCount) {
+        if (indicatorRect) {
+            *indicatorRect = QRect();
+        }
+        return index;
+    }
+
+    // 行底边自上而下递增：二分找到第一行满足 y 条件的行，之后各行都满足
+    auto row = std::partition_point(m_rows.constBegin(), m_rows.constEnd(), [&pos](const Row &r) {
+        return pos.y() >= r.bottom + 20;
+    });
+    for (; row != m_rows.constEnd(); ++row) {
+        // 之后各行的行尾中线都不在点的右侧时不可能再命中
+        if (pos.x() >= m_tailMaxCenterX.at(row - m_rows.constBegin())) {
+            break;
+        }
+        // 行内中线随 x 递增，二分找第一个中线在点右侧的子项
+        int low = row->first;
+        int high = row->first + row->count;
+        while (low < high) {
+            const int mid = (low + high) / 2;
+            if (pos.x() < m_placedGeometry.at(mid).center().x()) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        if (low < row->first + row->count) {
+            index = low;
+            break;
+        }
+    }
+
+    if (indicatorRect) {
+        if (index < itemCount) {
+            const QRect geometry = m_placedGeometry.at(index);
+            *indicatorRect = QRect(geometry.left() - 1, geometry.top(), 2, geometry.height());
+        } else if (itemCount > 0) {
+            const QRect geometry = m_placedGeometry.at(itemCount - 1);
+            *indicatorRect = QRect(geometry.right() + 1, geometry.top(), 2, geometry.height());
+        } else {
+            *indicatorRect = QRect();
+        }
+    }
+    return index;
+}
+
 int FlowLayout::smartSpacing(QStyle::PixelMetric pm) const
 {
     QObject *parent = this->parent();
@@ -1,13 +1,19 @@
 #ifndef FLOWLAYOUT_H
 #define FLOWLAYOUT_H
 
+#include <QHash>
 #include <QLayout>
 #include <QRect>
 #include <QStyle>
+#include <QVector>
 
 /**
  * @brief 流式布局
  * 水平排列子项，放不下时自动换行
+ *
+ * 子项尺寸提示、间距和 宽度->高度 结果都会缓存，直到增删子项或 invalidate()；
+ * setGeometry 只对位置发生变化（或新插入之后）的子项调用 setGeometry。
+ * 布局时同时记录行结构，拖放定位可按行、列二分查找，无需逐项比较几何。
  */
 class FlowLayout : public QLayout
 {
@@ -30,14 +36,54 @@ public:
     void setGeometry(const QRect &rect) override;
     QSize sizeHint() const override;
     QLayoutItem *takeAt(int index) override;
+    void invalidate() override;
+
+    // 最近一次布局的行结构（行自上而下，行内子项按 x 递增），必要时先完成布局
+    int rowCount() const;
+    int columnCount(int row) const;
+    int indexAt(int row, int column) const;
+    QRect itemGeometry(int index) const;
+
+    // 拖放插入位置：第一个满足“点在其水平中线左侧且不低于所在行底边以下 20 像素”的子项之前，
+    // 都不满足时为 count()。indicatorRect 返回插入符矩形（父控件坐标）
+    int insertionIndexAt(const QPoint &pos, QRect *indicatorRect = nullptr) const;
 
 private:
+    struct Row {
+        int first = 0;          // 行首子项下标
+        int count = 0;
+        int top = 0;
+        int bottom = 0;         // 按行高计算（含）
+        int lastCenterX = 0;    // 行尾子项的水平中线
+    };
+
+    void ensureRows() const;
+
     int doLayout(const QRect &rect, bool testOnly) const;
     int smartSpacing(QStyle::PixelMetric pm) const;
+    void ensureItemCache() const;
+    void markDirtyFrom(int index);
 
     QList<QLayoutItem *> m_itemList;
     int m_hSpace;
     int m_vSpace;
+
+    // 以下缓存在增删子项或 invalidate() 时失效
+    mutable bool m_itemCacheValid = false;
+    mutable QVector<QSize> m_sizeHints;
+    mutable QSize m_minimumSize;
+    mutable int m_spaceX = 0;
+    mutable int m_spaceY = 0;
+    mutable QHash<int, int> m_heightForWidth;
+
+    // 上一次 setGeometry 给各子项设置的位置；m_dirtyFrom 之后的子项必须重新设置
+    mutable QVector<QRect> m_placedGeometry;
+    mutable int m_dirtyFrom = 0;
+
+    // 上一次 setGeometry 的行结构；m_tailMaxCenterX[r] 为第 r 行及之后各行行尾中线的最大值
+    mutable QVector<Row> m_rows;
+    mutable QVector<int> m_tailMaxCenterX;
+    mutable bool m_rowsValid = false;
 };
 
 #endif // FLOWLAYOUT_H
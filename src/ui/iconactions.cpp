@@ -0,0 +1,233 @@
+#include "iconactions.h"
+#include <QPainter>
+#include <QMenu>
+#include <QDesktopServices>
+#include <QUrl>
+#include <QDir>
+#include <QDebug>
+#include <QTimer>
+#include "../platform/blurhelper.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <shellapi.h>
+#endif
+
+bool IconActions::launch(QWidget *source, const QString &path, bool runAsAdmin)
+{
+    if (path.isEmpty()) {
+        return false;
+    }
+
+#ifdef Q_OS_WIN
+    if (runAsAdmin) {
+        SHELLEXECUTEINFOW sei = {};
+        sei.cbSize = sizeof(SHELLEXECUTEINFOW);
+        sei.fMask = SEE_MASK_NOASYNC;
+        sei.hwnd = (HWND)source->window()->winId();
+        sei.lpVerb = L"runas";
+
+        const QString nativePath = QDir::toNativeSeparators(path);
+        const std::wstring wPath = nativePath.toStdWString();
+        sei.lpFile = wPath.c_str();
+        sei.nShow = SW_SHOWNORMAL;
+
+        if (!ShellExecuteExW(&sei)) {
+            const DWORD error = GetLastError();
+            qWarning() << "[IconActions] Failed to launch as admin:" << nativePath
+                       << "error:" << error;
+            return false;
+        }
+
+        resetWindowZOrder(source->window());
+        return true;
+    }
+#endif
+
+    if (!QDesktopServices::openUrl(QUrl::fromLocalFile(path))) {
+        qWarning() << "[IconActions] Failed to open path:" << path;
+        return false;
+    }
+
+    resetWindowZOrder(source->window());
+    return true;
+}
+
+void IconActions::resetWindowZOrder(QWidget *window)
+{
+#ifdef Q_OS_WIN
+    QWidget *parentWidget = window;
+    if (!parentWidget) {
+        return;
+    }
+
+    QTimer::singleShot(10, parentWidget, [parentWidget]() {
+        HWND hWnd = (HWND)parentWidget->winId();
+
+        HWND hProgman = FindWindow(L"Progman", NULL);
+        HWND hDefView = FindWindowEx(hProgman, NULL, L"SHELLDLL_DefView", NULL);
+
+        if (!hDefView) {
+            HWND hWorkerW = NULL;
+            while ((hWorkerW = FindWindowEx(NULL, hWorkerW, L"WorkerW", NULL)) != NULL) {
+                hDefView = FindWindowEx(hWorkerW, NULL, L"SHELLDLL_DefView", NULL);
+                if (hDefView) {
+                    break;
+                }
+            }
+        }
+
+        HWND hListView = NULL;
+        if (hDefView) {
+            hListView = FindWindowEx(hDefView, NULL, L"SysListView32", NULL);
+        }
+
+        if (hListView) {
+            SetWindowPos(hWnd, HWND_BOTTOM, 0, 0, 0, 0,
+                         SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+            SetWindowPos(hWnd, hListView, 0, 0, 0, 0,
+                         SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+        }
+    });
+#endif
+}
+
+IconActions::MenuChoice IconActions::execContextMenu(QWidget *source, const QPoint &globalPos,
+                                                     bool alwaysRunAsAdmin)
+{
+    QMenu menu(source);
+    menu.setAttribute(Qt::WA_TranslucentBackground);
+    menu.setAttribute(Qt::WA_NoSystemBackground);
+    // 给边框留出 1px 的边距，防止边缘毛刺
+    menu.setContentsMargins(1, 1, 1, 1);
+    
+    menu.setWindowFlags(Qt::Popup | Qt::FramelessWindowHint | Qt::NoDropShadowWindowHint);
+
+    const QPixmap checkedPixmap = []() {
+        QPixmap pixmap(16, 16);
+        pixmap.fill(Qt::transparent);
+
+        QPainter painter(&pixmap);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(QPen(QColor("#4CAF50"), 2.2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter.drawLine(QPointF(3.0, 8.5), QPointF(6.5, 12.0));
+        painter.drawLine(QPointF(6.5, 12.0), QPointF(13.0, 4.0));
+        return pixmap;
+    }();
+    const QPixmap emptyPixmap = []() {
+        QPixmap pixmap(16, 16);
+        pixmap.fill(Qt::transparent);
+        return pixmap;
+    }();
+    
+    menu.setStyleSheet(R"(
+        QMenu {
+            background-color: rgba(45, 45, 50, 240);
+            border: 1px solid rgba(255, 255, 255, 0.1);
+            border-radius: 12px;
+            padding: 8px;
+            font-family: "Microsoft YaHei", "Segoe UI", sans-serif;
+            font-size: 13px;
+            icon-size: 14px;
+        }
+        QMenu::item {
+            background: transparent;
+            color: #ffffff;
+            padding: 4px 36px 4px 4px;
+            min-height: 22px;
+            border: 1px solid transparent;
+            border-radius: 6px;
+            margin: 1px 4px;
+        }
+        QMenu::item:selected {
+            background-color: rgba(255, 255, 255, 0.1);
+            border: 1px solid rgba(255, 255, 255, 0.15);
+        }
+        QMenu::right-arrow {
+            width: 12px;
+            height: 12px;
+            right: 8px;
+        }
+        QMenu::separator {
+            height: 1px;
+            background: rgba(255, 255, 255, 0.15);
+            margin: 4px 8px;
+        }
+    )");
+
+#ifdef Q_OS_WIN
+    QObject::connect(&menu, &QMenu::aboutToShow, source, [source, &menu]() {
+        QTimer::singleShot(10, source, [source, &menu]() {
+            HWND hMenu = (HWND)menu.winId();
+            HWND hFence = (HWND)source->window()->winId();
+            
+            // 1. 移除 TOPMOST
+            LONG_PTR exStyle = GetWindowLongPtr(hMenu, GWL_EXSTYLE);
+            if (exStyle & WS_EX_TOPMOST) {
+                SetWindowLongPtr(hMenu, GWL_EXSTYLE, exStyle & ~WS_EX_TOPMOST);
+            }
+            
+            // 2. 物理裁剪圆角 (解决黑点问题)
+            BlurHelper::enableRoundedCorners(&menu, 8);
+            
+            // 3. 确保能点击外部关闭
+            SetForegroundWindow(hMenu);
+
+            // 4. 调整 Z-order 到围栏上方
+            HWND hPrev = GetWindow(hFence, GW_HWNDPREV);
+            UINT flags = SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_FRAMECHANGED;
+            
+            if (hPrev) {
+                SetWindowPos(hMenu, hPrev, 0, 0, 0, 0, flags);
+            } else {
+                SetWindowPos(hMenu, HWND_TOP, 0, 0, 0, 0, flags);
+            }
+        });
+    });
+#endif
+
+    QAction *alwaysRunAsAdminAction = menu.addAction("总是以管理员身份运行");
+    alwaysRunAsAdminAction->setIcon(QIcon(alwaysRunAsAdmin ? checkedPixmap : emptyPixmap));
+    alwaysRunAsAdminAction->setIconVisibleInMenu(true);
+
+    QAction *runAsAdminAction = menu.addAction("以管理员身份运行");
+    runAsAdminAction->setIcon(QIcon(emptyPixmap));
+    runAsAdminAction->setIconVisibleInMenu(true);
+    menu.addSeparator();
+    QAction *deleteAction = menu.addAction("删除");
+    deleteAction->setIcon(QIcon(emptyPixmap));
+    deleteAction->setIconVisibleInMenu(true);
+    QAction *propertiesAction = menu.addAction("属性");
+    propertiesAction->setIcon(QIcon(emptyPixmap));
+    propertiesAction->setIconVisibleInMenu(true);
+    QAction *selected = menu.exec(globalPos);
+
+    if (selected == alwaysRunAsAdminAction) {
+        return ToggleAlwaysRunAsAdmin;
+    } else if (selected == runAsAdminAction) {
+        return RunAsAdmin;
+    } else if (selected == deleteAction) {
+        return Remove;
+    } else if (selected == propertiesAction) {
+        return Properties;
+    }
+    return NoChoice;
+}
+
+void IconActions::showProperties(QWidget *source, const QString &path)
+{
+#ifdef Q_OS_WIN
+    SHELLEXECUTEINFOW sei = {};
+    sei.cbSize = sizeof(SHELLEXECUTEINFOW);
+    sei.fMask = SEE_MASK_INVOKEIDLIST;
+    sei.hwnd = (HWND)source->window()->winId();
+    sei.lpVerb = L"properties";
+    std::wstring wPath = path.toStdWString();
+    sei.lpFile = wPath.c_str();
+    sei.nShow = SW_SHOWNORMAL;
+    ShellExecuteExW(&sei);
+#else
+    Q_UNUSED(source)
+    Q_UNUSED(path)
+#endif
+}
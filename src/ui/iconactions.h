@@ -0,0 +1,36 @@
+#ifndef ICONACTIONS_H
+#define ICONACTIONS_H
+
+#include <QString>
+#include <QPoint>
+
+class QWidget;
+
+/**
+ * @brief 图标操作
+ * 打开文件、查看属性、图标右键菜单等与具体控件无关的操作，
+ * 由 IconWidget 和 IconGridView 共用，保证两种显示方式行为一致。
+ */
+class IconActions
+{
+public:
+    enum MenuChoice {
+        NoChoice,
+        ToggleAlwaysRunAsAdmin,
+        RunAsAdmin,
+        Remove,
+        Properties
+    };
+
+    // 打开文件（可选以管理员身份），成功后把 source 所在窗口重新放回桌面图标层之上
+    static bool launch(QWidget *source, const QString &path, bool runAsAdmin);
+    // 打开系统属性对话框
+    static void showProperties(QWidget *source, const QString &path);
+    // 在 globalPos 处弹出图标右键菜单并返回用户的选择
+    static MenuChoice execContextMenu(QWidget *source, const QPoint &globalPos, bool alwaysRunAsAdmin);
+
+private:
+    static void resetWindowZOrder(QWidget *window);
+};
+
+#endif // ICONACTIONS_H
@@ -0,0 +1,513 @@
+#include "icongridview.h"
+#include "fencewindow.h"
+#include "iconactions.h"
+#include "scalediconcache.h"
+#include "src/core/iconhelper.h"
+#include "src/core/logger.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QContextMenuEvent>
+#include <QHelpEvent>
+#include <QScrollBar>
+#include <QDrag>
+#include <QMimeData>
+#include <QStyle>
+#include <QToolTip>
+#include <QDir>
+
+namespace {
+// 与 IconWidget 内部布局一致：图标 48x48，名称标签宽 72、文字最多 68，图标与名称间距 4
+const int kTextWidth = 72;
+const int kTextElideWidth = 68;
+const int kTextSpacing = 4;
+// 拖拽经过上下边缘该范围内时自动滚动
+const int kAutoScrollZone = 24;
+}
+
+IconGridView::IconGridView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFrameShape(QFrame::NoFrame);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    setAutoFillBackground(false);
+    viewport()->setAutoFillBackground(false);
+    viewport()->setMouseTracking(true);
+
+    verticalScrollBar()->setStyleSheet(R"(
+        QScrollBar:vertical {
+            background: transparent;
+            width: 6px;
+            margin: 4px 0px 4px 0px;
+        }
+        QScrollBar::handle:vertical {
+            background: rgba(255, 255, 255, 60);
+            border-radius: 3px;
+            min-height: 24px;
+        }
+        QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical {
+            height: 0px;
+        }
+        QScrollBar::add-page:vertical, QScrollBar::sub-page:vertical {
+            background: transparent;
+        }
+    )");
+
+    m_textFont = font();
+    m_textFont.setPixelSize(12);
+    m_fallbackIcon = style()->standardIcon(QStyle::SP_FileIcon).pixmap(IconHelper::kIconDisplaySize,
+                                                                        IconHelper::kIconDisplaySize);
+}
+
+QString IconGridView::pathKey(const QString &path)
+{
+    return QDir::toNativeSeparators(QDir::cleanPath(path)).toCaseFolded();
+}
+
+int IconGridView::indexOfPath(const QString &path) const
+{
+    return m_indexByPath.value(pathKey(path), -1);
+}
+
+void IconGridView::prepareItem(Item &item) const
+{
+    item.pathKey = pathKey(item.data.path);
+    item.elidedName = QFontMetrics(m_textFont).elidedText(item.data.name, Qt::ElideMiddle, kTextElideWidth);
+    if (!item.data.icon.isNull()) {
+        // 与 IconWidget 相同，只保留共享缓存中显示尺寸的句柄
+        item.data.icon = ScaledIconCache::instance()->scaled(item.data.icon, IconHelper::kIconDisplaySize,
+                                                             devicePixelRatio());
+    }
+}
+
+void IconGridView::reindexFrom(int first)
+{
+    for (int i = first; i < m_items.size(); ++i) {
+        m_indexByPath.insert(m_items.at(i).pathKey, i);
+        m_indexById.insert(m_items.at(i).id, i);
+    }
+}
+
+quint64 IconGridView::insertIcon(int index, const IconWidget::IconData &data, bool loading)
+{
+    const int boundedIndex = qBound(0, index, m_items.size());
+
+    Item item;
+    item.id = m_nextId++;
+    item.data = data;
+    item.loading = loading;
+    prepareItem(item);
+    m_items.insert(boundedIndex, item);
+    reindexFrom(boundedIndex);
+
+    m_hoverIndex = -1;
+    m_pressIndex = -1;
+    updateScrollRange();
+    viewport()->update();
+    return item.id;
+}
+
+void IconGridView::setIconData(int index, const IconWidget::IconData &data)
+{
+    if (index < 0 || index >= m_items.size()) {
+        return;
+    }
+
+    Item &item = m_items[index];
+    m_indexByPath.remove(item.pathKey);
+    item.data = data;
+    item.loading = false;
+    prepareItem(item);
+    m_indexByPath.insert(item.pathKey, index);
+
+    viewport()->update(tileRect(index).translated(0, -verticalScrollBar()->value()));
+}
+
+void IconGridView::removeAt(int index)
+{
+    if (index < 0 || index >= m_items.size()) {
+        return;
+    }
+
+    m_indexByPath.remove(m_items.at(index).pathKey);
+    m_indexById.remove(m_items.at(index).id);
+    m_items.remove(index);
+    reindexFrom(index);
+
+    m_hoverIndex = -1;
+    m_pressIndex = -1;
+    updateScrollRange();
+    viewport()->update();
+}
+
+void IconGridView::moveIcon(int from, int to)
+{
+    if (from < 0 || from >= m_items.size()) {
+        return;
+    }
+    to = qBound(0, to, m_items.size() - 1);
+    if (from == to) {
+        return;
+    }
+
+    const Item item = m_items.takeAt(from);
+    m_items.insert(to, item);
+    reindexFrom(qMin(from, to));
+
+    m_hoverIndex = -1;
+    viewport()->update();
+}
+
+void IconGridView::setTextVisible(bool visible)
+{
+    if (m_textVisible != visible) {
+        m_textVisible = visible;
+        viewport()->update();
+    }
+}
+
+int IconGridView::columnCount() const
+{
+    // 与 FlowLayout 的换行条件一致：格子右边缘不超过内容区域 right()
+    const int available = viewport()->width() - 2 * kMargin - 1 + kSpacing;
+    return qMax(1, available / (kTileWidth + kSpacing));
+}
+
+QRect IconGridView::tileRect(int index) const
+{
+    const int columns = columnCount();
+    const int row = index / columns;
+    const int column = index % columns;
+    return QRect(kMargin + column * (kTileWidth + kSpacing),
+                 kMargin + row * (kTileHeight + kSpacing),
+                 kTileWidth, kTileHeight);
+}
+
+void IconGridView::updateScrollRange()
+{
+    const int columns = columnCount();
+    const int rows = (m_items.size() + columns - 1) / columns;
+    const int contentHeight = rows > 0
+        ? 2 * kMargin + rows * kTileHeight + (rows - 1) * kSpacing
+        : 0;
+
+    QScrollBar *bar = verticalScrollBar();
+    bar->setRange(0, qMax(0, contentHeight - viewport()->height()));
+    bar->setPageStep(viewport()->height());
+    bar->setSingleStep((kTileHeight + kSpacing) / 2);
+}
+
+int IconGridView::indexAt(const QPoint &pos) const
+{
+    const int x = pos.x() - kMargin;
+    const int y = pos.y() + verticalScrollBar()->value() - kMargin;
+    if (x < 0 || y < 0) {
+        return -1;
+    }
+
+    const int column = x / (kTileWidth + kSpacing);
+    const int row = y / (kTileHeight + kSpacing);
+    if (column >= columnCount() ||
+        x % (kTileWidth + kSpacing) >= kTileWidth ||
+        y % (kTileHeight + kSpacing) >= kTileHeight) {
+        return -1;
+    }
+
+    const int index = row * columnCount() + column;
+    return index < m_items.size() ? index : -1;
+}
+
+int IconGridView::insertionIndexAt(const QPoint &pos, QRect *indicatorRect) const
+{
+    // 与 FenceWindow 中逐个比较 IconWidget 几何的规则相同：
+    // 第一个满足“位于图标中线左侧且不低于图标底边以下 20 像素”的图标之前。
+    // 行、列条件各自单调，可直接算出首个满足条件的行和列。
+    const int x = pos.x();
+    const int y = pos.y() + verticalScrollBar()->value();
+    const int columns = columnCount();
+
+    const int rowLimit = y - kMargin - (kTileHeight - 1) - 20;
+    const int firstRow = rowLimit < 0 ? 0 : rowLimit / (kTileHeight + kSpacing) + 1;
+    const int columnLimit = x - kMargin - (kTileWidth - 1) / 2;
+    const int firstColumn = columnLimit < 0 ? 0 : columnLimit / (kTileWidth + kSpacing) + 1;
+
+    int index = m_items.size();
+    if (firstColumn < columns) {
+        index = qMin(index, firstRow * columns + firstColumn);
+    }
+
+    if (indicatorRect) {
+        const int offset = verticalScrollBar()->value();
+        if (index < m_items.size()) {
+            const QRect tile = tileRect(index).translated(0, -offset);
+            *indicatorRect = QRect(tile.left() - 1, tile.top(), 2, tile.height());
+        } else if (!m_items.isEmpty()) {
+            const QRect tile = tileRect(m_items.size() - 1).translated(0, -offset);
+            *indicatorRect = QRect(tile.right() + 1, tile.top(), 2, tile.height());
+        } else {
+            *indicatorRect = QRect();
+        }
+    }
+    return index;
+}
+
+void IconGridView::autoScrollForDrag(const QPoint &pos)
+{
+    QScrollBar *bar = verticalScrollBar();
+    if (pos.y() < kAutoScrollZone) {
+        bar->setValue(bar->value() - bar->singleStep());
+    } else if (pos.y() > viewport()->height() - kAutoScrollZone) {
+        bar->setValue(bar->value() + bar->singleStep());
+    }
+}
+
+bool IconGridView::viewportEvent(QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::ToolTip: {
+        QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+        const int index = indexAt(helpEvent->pos());
+        if (index >= 0) {
+            const QRect tile = tileRect(index).translated(0, -verticalScrollBar()->value());
+            QToolTip::showText(helpEvent->globalPos(), m_items.at(index).data.name, viewport(), tile);
+        } else {
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    case QEvent::Leave:
+        setHoverIndex(-1);
+        if (m_pressIndex >= 0) {
+            m_pressIndex = -1;
+            viewport()->update();
+        }
+        break;
+    default:
+        break;
+    }
+    return QAbstractScrollArea::viewportEvent(event);
+}
+
+void IconGridView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollRange();
+}
+
+void IconGridView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx)
+    Q_UNUSED(dy)
+    setHoverIndex(-1);
+    viewport()->update();
+}
+
+void IconGridView::paintEvent(QPaintEvent *event)
+{
+    if (m_items.isEmpty()) {
+        return;
+    }
+
+    QPainter painter(viewport());
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setFont(m_textFont);
+
+    const int offset = verticalScrollBar()->value();
+    const int columns = columnCount();
+    const int rowStride = kTileHeight + kSpacing;
+    const QRect exposed = event->rect();
+
+    // 只遍历与重绘区域相交的行
+    const int firstRow = qMax(0, (exposed.top() + offset - kMargin) / rowStride);
+    const int lastRow = qMax(0, (exposed.bottom() + offset - kMargin) / rowStride);
+
+    const int textHeight = QFontMetrics(m_textFont).height();
+    const int blockHeight = IconHelper::kIconDisplaySize + (m_textVisible ? kTextSpacing + textHeight : 0);
+    const int iconTop = (kTileHeight - blockHeight) / 2;
+    const int iconLeft = (kTileWidth - IconHelper::kIconDisplaySize) / 2;
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            const int index = row * columns + column;
+            if (index >= m_items.size()) {
+                return;
+            }
+
+            const QRect tile = tileRect(index).translated(0, -offset);
+            if (!tile.intersects(exposed)) {
+                continue;
+            }
+
+            const Item &item = m_items.at(index);
+            const QRect iconRect(tile.left() + iconLeft, tile.top() + iconTop,
+                                 IconHelper::kIconDisplaySize, IconHelper::kIconDisplaySize);
+
+            if (item.loading) {
+                QPainterPath path;
+                path.addRoundedRect(iconRect.adjusted(4, 4, -4, -4), 8, 8);
+                painter.fillPath(path, QColor(255, 255, 255, 20));
+            } else {
+                const bool pressed = index == m_pressIndex;
+                if (pressed || index == m_hoverIndex) {
+                    QPainterPath path;
+                    path.addRoundedRect(tile.adjusted(2, 2, -2, -2), 6, 6);
+                    painter.fillPath(path, pressed ? QColor(255, 255, 255, 40) : QColor(255, 255, 255, 25));
+                    painter.setPen(QPen(QColor(255, 255, 255, 50), 1));
+                    painter.drawPath(path);
+                }
+
+                const QPixmap &pixmap = item.data.icon.isNull() ? m_fallbackIcon : item.data.icon;
+                QRect target(QPoint(0, 0), pixmap.size() / pixmap.devicePixelRatio());
+                target.moveCenter(iconRect.center());
+                painter.drawPixmap(target, pixmap);
+            }
+
+            if (m_textVisible) {
+                const QRect textRect(tile.left() + (kTileWidth - kTextWidth) / 2,
+                                     iconRect.bottom() + 1 + kTextSpacing, kTextWidth, textHeight);
+                painter.setPen(Qt::white);
+                painter.drawText(textRect, Qt::AlignCenter, item.elidedName);
+            }
+        }
+    }
+}
+
+void IconGridView::setHoverIndex(int index)
+{
+    if (index >= 0 && m_items.at(index).loading) {
+        index = -1; // 加载中的占位图标不响应鼠标
+    }
+    if (m_hoverIndex == index) {
+        return;
+    }
+
+    const int offset = verticalScrollBar()->value();
+    if (m_hoverIndex >= 0 && m_hoverIndex < m_items.size()) {
+        viewport()->update(tileRect(m_hoverIndex).translated(0, -offset));
+    }
+    m_hoverIndex = index;
+    if (m_hoverIndex >= 0) {
+        viewport()->update(tileRect(m_hoverIndex).translated(0, -offset));
+        viewport()->setCursor(Qt::PointingHandCursor);
+    } else {
+        viewport()->unsetCursor();
+    }
+}
+
+void IconGridView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        const int index = indexAt(event->pos());
+        if (index >= 0 && !m_items.at(index).loading) {
+            m_pressIndex = index;
+            m_pressPos = event->pos();
+            viewport()->update(tileRect(index).translated(0, -verticalScrollBar()->value()));
+        }
+    }
+    // 与 IconWidget 一样继续交给围栏，以便边缘缩放
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void IconGridView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (m_pressIndex >= 0) {
+        if ((event->pos() - m_pressPos).manhattanLength() > 10) {
+            startDrag(m_pressIndex);
+        }
+    } else if (!(event->buttons() & Qt::LeftButton)) {
+        setHoverIndex(indexAt(event->pos()));
+    }
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void IconGridView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && m_pressIndex >= 0) {
+        const int index = m_pressIndex;
+        m_pressIndex = -1;
+        viewport()->update(tileRect(index).translated(0, -verticalScrollBar()->value()));
+        // 单击打开（不是拖拽），且松开时仍在同一个图标上
+        if (indexAt(event->pos()) == index) {
+            const IconWidget::IconData &data = m_items.at(index).data;
+            IconActions::launch(this, data.path, data.alwaysRunAsAdmin);
+        }
+    }
+    QAbstractScrollArea::mouseReleaseEvent(event);
+}
+
+void IconGridView::startDrag(int index)
+{
+    QToolTip::hideText();
+    m_pressIndex = -1;
+    viewport()->update();
+
+    // 拖拽期间图标可能被移到其他围栏，之后只通过路径引用
+    const QString path = m_items.at(index).data.path;
+    LOG_DEBUG(Logger::Drag, "[IconGridView] Starting drag for: " + path);
+
+    QDrag *drag = new QDrag(this);
+    QMimeData *mimeData = new QMimeData();
+    mimeData->setData("application/x-deskgo-icon", path.toUtf8());
+    drag->setMimeData(mimeData);
+
+    const QPixmap &icon = m_items.at(index).data.icon;
+    drag->setPixmap(icon.isNull() ? m_fallbackIcon : icon);
+
+    Qt::DropAction result = drag->exec(Qt::MoveAction);
+    LOG_DEBUG(Logger::Drag, QString("[IconGridView] Drag finished, result: %1").arg(int(result)));
+
+    // 拖出恢复：放在所有围栏之外视为拖回桌面
+    if (result == Qt::IgnoreAction) {
+        QPoint globalPos = QCursor::pos();
+        bool outsideAll = true;
+        for (FenceWindow *fence : FenceWindow::allFences()) {
+            if (fence && fence->isVisible() && fence->geometry().contains(globalPos)) {
+                outsideAll = false;
+                break;
+            }
+        }
+        if (outsideAll) {
+            LOG_DEBUG(Logger::Drag, "[IconGridView] Dragged outside all fences, requesting restoration to desktop.");
+            emit removeRequested(path);
+        }
+    }
+}
+
+void IconGridView::contextMenuEvent(QContextMenuEvent *event)
+{
+    const int index = indexAt(event->pos());
+    if (index < 0 || m_items.at(index).loading) {
+        event->ignore(); // 空白处交给围栏的右键菜单
+        return;
+    }
+
+    // 菜单是模态的，期间图标列表可能变化，返回后按路径重新定位
+    const QString path = m_items.at(index).data.path;
+    const IconActions::MenuChoice choice =
+        IconActions::execContextMenu(this, event->globalPos(), m_items.at(index).data.alwaysRunAsAdmin);
+    const int current = indexOfPath(path);
+    if (current < 0) {
+        return;
+    }
+
+    switch (choice) {
+    case IconActions::ToggleAlwaysRunAsAdmin:
+        m_items[current].data.alwaysRunAsAdmin = !m_items[current].data.alwaysRunAsAdmin;
+        emit launchPreferenceChanged();
+        break;
+    case IconActions::RunAsAdmin:
+        IconActions::launch(this, path, true);
+        break;
+    case IconActions::Remove:
+        emit removeRequested(path);
+        break;
+    case IconActions::Properties:
+        IconActions::showProperties(this, path);
+        break;
+    case IconActions::NoChoice:
+        break;
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef ICONGRIDVIEW_H
+#define ICONGRIDVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QHash>
+#include <QVector>
+#include "iconwidget.h"
+
+/**
+ * @brief 虚拟化图标网格
+ * 用一个控件代替每个图标一个 IconWidget：图标只作为数据保存，绘制时只画可见行，
+ * 命中测试和插入位置都按固定网格直接计算，图标数量很大时仍可滚动浏览。
+ * 格子尺寸、间距和外观与 IconWidget + FlowLayout 一致，点击打开、拖拽、右键菜单行为相同。
+ */
+class IconGridView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    // 与 IconWidget 尺寸和 FlowLayout(8, 6, 6) 一致
+    static const int kTileWidth = 80;
+    static const int kTileHeight = 90;
+    static const int kMargin = 8;
+    static const int kSpacing = 6;
+
+    explicit IconGridView(QWidget *parent = nullptr);
+
+    int count() const { return m_items.size(); }
+    const IconWidget::IconData &iconAt(int index) const { return m_items.at(index).data; }
+    bool isLoading(int index) const { return m_items.at(index).loading; }
+
+    // 每个图标有一个在视图生命周期内不变的 id，供异步加载结果定位
+    quint64 idAt(int index) const { return m_items.at(index).id; }
+    int indexOfId(quint64 id) const { return m_indexById.value(id, -1); }
+    // 路径比较与 FenceWindow 去重规则一致：归一化后不区分大小写
+    int indexOfPath(const QString &path) const;
+
+    quint64 insertIcon(int index, const IconWidget::IconData &data, bool loading = false);
+    // 替换图标数据并结束加载状态
+    void setIconData(int index, const IconWidget::IconData &data);
+    void removeAt(int index);
+    void moveIcon(int from, int to);
+
+    void setTextVisible(bool visible);
+    bool isTextVisible() const { return m_textVisible; }
+
+    // 视口坐标下的命中测试，未命中返回 -1
+    int indexAt(const QPoint &pos) const;
+    // 拖放插入位置（0..count），indicatorRect 返回视口坐标下的插入符矩形
+    int insertionIndexAt(const QPoint &pos, QRect *indicatorRect) const;
+    // 拖拽经过视口上下边缘时滚动
+    void autoScrollForDrag(const QPoint &pos);
+
+signals:
+    void removeRequested(const QString &path);
+    void launchPreferenceChanged();
+
+protected:
+    bool viewportEvent(QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+private:
+    struct Item {
+        quint64 id = 0;
+        IconWidget::IconData data;
+        QString pathKey;
+        QString elidedName;
+        bool loading = false;
+    };
+
+    static QString pathKey(const QString &path);
+    void prepareItem(Item &item) const;
+    void reindexFrom(int first);
+    int columnCount() const;
+    // 内容坐标（未减去滚动偏移）下的格子矩形
+    QRect tileRect(int index) const;
+    void updateScrollRange();
+    void setHoverIndex(int index);
+    void startDrag(int index);
+
+    QVector<Item> m_items;
+    QHash<QString, int> m_indexByPath;
+    QHash<quint64, int> m_indexById;
+    quint64 m_nextId = 1;
+
+    QFont m_textFont;
+    QPixmap m_fallbackIcon;
+    bool m_textVisible = true;
+
+    int m_hoverIndex = -1;
+    int m_pressIndex = -1;
+    QPoint m_pressPos;
+};
+
+#endif // ICONGRIDVIEW_H
@@ -1,29 +1,31 @@
 #include "iconwidget.h"
 #include "fencewindow.h"
+#include "scalediconcache.h"
+#include "iconactions.h"
+#include "src/core/iconhelper.h"
 #include <QPainter>
 #include <QPainterPath>
 #include <QMouseEvent>
 #include <QDrag>
 #include <QMimeData>
-#include <QDesktopServices>
-#include <QUrl>
-#include <QMenu>
 #include <QStyle>
-#include <QDir>
 #include <QDebug>
 #include <QTimer>
 #include <QToolTip>
 #include <QHelpEvent>
-#include "../platform/blurhelper.h"
 
-#ifdef Q_OS_WIN
-#include <windows.h>
-#include <shellapi.h>
-#endif
+namespace {
+quint64 nextIconId()
+{
+    static quint64 next = 0;
+    return ++next;
+}
+}
 
 IconWidget::IconWidget(const IconData &data, QWidget *parent)
     : QWidget(parent)
     , m_data(data)
+    , m_id(nextIconId())
 {
     m_tooltipTimer = new QTimer(this);
     m_tooltipTimer->setSingleShot(true);
@@ -53,18 +55,7 @@ void IconWidget::setupUi()
     m_iconLabel->setScaledContents(false);
     m_iconLabel->setAttribute(Qt::WA_TransparentForMouseEvents);
 
-    if (!m_data.icon.isNull()) {
-        qreal dpr = devicePixelRatio();
-        int size = 48 * dpr;
-        QPixmap scaled = m_data.icon.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        scaled.setDevicePixelRatio(dpr);
-        m_iconLabel->setPixmap(scaled);
-    } else {
-        // 图标加载失败时的后备显示：使用系统标准文件图标
-        QIcon fallbackIcon = style()->standardIcon(QStyle::SP_FileIcon);
-        // AA_UseHighDpiPixmaps 启用时，QIcon::pixmap(48, 48) 会自动返回高分屏 Pixmap
-        m_iconLabel->setPixmap(fallbackIcon.pixmap(48, 48));
-    }
+    updateIconPixmap();
     layout->addWidget(m_iconLabel, 0, Qt::AlignCenter);
 
     // 名称
@@ -96,7 +87,7 @@ void IconWidget::setupUi()
     m_nameLabel->setToolTip(tip);
 }
 
-IconWidget::IconData IconWidget::data() const
+const IconWidget::IconData &IconWidget::data() const
 {
     return m_data;
 }
@@ -116,15 +107,34 @@ void IconWidget::setData(const IconData &data)
     m_iconLabel->setToolTip(tip);
     m_nameLabel->setToolTip(tip);
     
-    if (!data.icon.isNull()) {
-        qreal dpr = devicePixelRatio();
-        int size = 48 * dpr;
-        QPixmap scaled = data.icon.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        scaled.setDevicePixelRatio(dpr);
-        m_iconLabel->setPixmap(scaled);
+    updateIconPixmap();
+}
+
+void IconWidget::setLoading(bool loading)
+{
+    if (m_loading == loading) {
+        return;
+    }
+    m_loading = loading;
+    setEnabled(!loading);
+    setCursor(loading ? Qt::ArrowCursor : Qt::PointingHandCursor);
+    updateIconPixmap();
+    update();
+}
+
+void IconWidget::updateIconPixmap()
+{
+    if (m_loading) {
+        m_iconLabel->clear();
+    } else if (!m_data.icon.isNull()) {
+        // 只保留共享缓存中显示尺寸的句柄，原始大图标随之释放
+        m_data.icon = ScaledIconCache::instance()->scaled(m_data.icon, IconHelper::kIconDisplaySize,
+                                                          devicePixelRatio());
+        m_iconLabel->setPixmap(m_data.icon);
     } else {
-        // 图标加载失败时的后备显示
+        // 图标加载失败时的后备显示：使用系统标准文件图标
         QIcon fallbackIcon = style()->standardIcon(QStyle::SP_FileIcon);
+        // AA_UseHighDpiPixmaps 启用时，QIcon::pixmap(48, 48) 会自动返回高分屏 Pixmap
         m_iconLabel->setPixmap(fallbackIcon.pixmap(48, 48));
     }
 }
@@ -151,83 +161,7 @@ QString IconWidget::path() const
 
 bool IconWidget::openPath(bool runAsAdmin)
 {
-    if (m_data.path.isEmpty()) {
-        return false;
-    }
-
-#ifdef Q_OS_WIN
-    if (runAsAdmin) {
-        SHELLEXECUTEINFOW sei = {};
-        sei.cbSize = sizeof(SHELLEXECUTEINFOW);
-        sei.fMask = SEE_MASK_NOASYNC;
-        sei.hwnd = (HWND)window()->winId();
-        sei.lpVerb = L"runas";
-
-        const QString nativePath = QDir::toNativeSeparators(m_data.path);
-        const std::wstring wPath = nativePath.toStdWString();
-        sei.lpFile = wPath.c_str();
-        sei.nShow = SW_SHOWNORMAL;
-
-        if (!ShellExecuteExW(&sei)) {
-            const DWORD error = GetLastError();
-            qWarning() << "[IconWidget] Failed to launch as admin:" << nativePath
-                       << "error:" << error;
-            return false;
-        }
-
-        resetParentWindowZOrder();
-        return true;
-    }
-#endif
-
-    if (!QDesktopServices::openUrl(QUrl::fromLocalFile(m_data.path))) {
-        qWarning() << "[IconWidget] Failed to open path:" << m_data.path;
-        return false;
-    }
-
-    resetParentWindowZOrder();
-    return true;
-}
-
-void IconWidget::resetParentWindowZOrder()
-{
-#ifdef Q_OS_WIN
-    QWidget *parentWidget = window();
-    if (!parentWidget) {
-        return;
-    }
-
-    QTimer::singleShot(10, parentWidget, [parentWidget]() {
-        HWND hWnd = (HWND)parentWidget->winId();
-
-        HWND hProgman = FindWindow(L"Progman", NULL);
-        HWND hDefView = FindWindowEx(hProgman, NULL, L"SHELLDLL_DefView", NULL);
-
-        if (!hDefView) {
-            HWND hWorkerW = NULL;
-            while ((hWorkerW = FindWindowEx(NULL, hWorkerW, L"WorkerW", NULL)) != NULL) {
-                hDefView = FindWindowEx(hWorkerW, NULL, L"SHELLDLL_DefView", NULL);
-                if (hDefView) {
-                    break;
-                }
-            }
-        }
-
-        HWND hListView = NULL;
-        if (hDefView) {
-            hListView = FindWindowEx(hDefView, NULL, L"SysListView32", NULL);
-        }
-
-        if (hListView) {
-            SetWindowPos(hWnd, HWND_BOTTOM, 0, 0, 0, 0,
-                         SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
-            SetWindowPos(hWnd, hListView, 0, 0, 0, 0,
-                         SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
-
-            qDebug() << "[IconWidget] Z-order reset after opening file";
-        }
-    });
-#endif
+    return IconActions::launch(this, m_data.path, runAsAdmin);
 }
 
 void IconWidget::paintEvent(QPaintEvent *event)
@@ -237,6 +171,13 @@ void IconWidget::paintEvent(QPaintEvent *event)
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
 
+    if (m_loading) {
+        QPainterPath path;
+        path.addRoundedRect(m_iconLabel->geometry().adjusted(4, 4, -4, -4), 8, 8);
+        painter.fillPath(path, QColor(255, 255, 255, 20));
+        return;
+    }
+
     if (m_hovered || m_pressed) {
         QPainterPath path;
         path.addRoundedRect(rect().adjusted(2, 2, -2, -2), 6, 6);
@@ -275,14 +216,12 @@ void IconWidget::mouseMoveEvent(QMouseEvent *event)
         QDrag *drag = new QDrag(this);
         QMimeData *mimeData = new QMimeData();
         mimeData->setData("application/x-deskgo-icon", m_data.path.toUtf8());
+        mimeData->setData(idMimeType(), QByteArray::number(m_id));
         drag->setMimeData(mimeData);
 
         if (!m_data.icon.isNull()) {
-            qreal dpr = devicePixelRatio();
-            int size = 48 * dpr;
-            QPixmap scaled = m_data.icon.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            scaled.setDevicePixelRatio(dpr);
-            drag->setPixmap(scaled);
+            drag->setPixmap(ScaledIconCache::instance()->scaled(m_data.icon, IconHelper::kIconDisplaySize,
+                                                                devicePixelRatio()));
         }
 
         emit dragStarted();
@@ -351,134 +290,21 @@ void IconWidget::leaveEvent(QEvent *event)
 
 void IconWidget::contextMenuEvent(QContextMenuEvent *event)
 {
-    QMenu menu(this);
-    menu.setAttribute(Qt::WA_TranslucentBackground);
-    menu.setAttribute(Qt::WA_NoSystemBackground);
-    // 给边框留出 1px 的边距，防止边缘毛刺
-    menu.setContentsMargins(1, 1, 1, 1);
-    
-    menu.setWindowFlags(Qt::Popup | Qt::FramelessWindowHint | Qt::NoDropShadowWindowHint);
-
-    const QPixmap checkedPixmap = []() {
-        QPixmap pixmap(16, 16);
-        pixmap.fill(Qt::transparent);
-
-        QPainter painter(&pixmap);
-        painter.setRenderHint(QPainter::Antialiasing);
-        painter.setPen(QPen(QColor("#4CAF50"), 2.2, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
-        painter.drawLine(QPointF(3.0, 8.5), QPointF(6.5, 12.0));
-        painter.drawLine(QPointF(6.5, 12.0), QPointF(13.0, 4.0));
-        return pixmap;
-    }();
-    const QPixmap emptyPixmap = []() {
-        QPixmap pixmap(16, 16);
-        pixmap.fill(Qt::transparent);
-        return pixmap;
-    }();
-    
-    menu.setStyleSheet(R"(
-        QMenu {
-            background-color: rgba(45, 45, 50, 240);
-            border: 1px solid rgba(255, 255, 255, 0.1);
-            border-radius: 12px;
-            padding: 8px;
-            font-family: "Microsoft YaHei", "Segoe UI", sans-serif;
-            font-size: 13px;
-            icon-size: 14px;
-        }
-        QMenu::item {
-            background: transparent;
-            color: #ffffff;
-            padding: 4px 36px 4px 4px;
-            min-height: 22px;
-            border: 1px solid transparent;
-            border-radius: 6px;
-            margin: 1px 4px;
-        }
-        QMenu::item:selected {
-            background-color: rgba(255, 255, 255, 0.1);
-            border: 1px solid rgba(255, 255, 255, 0.15);
-        }
-        QMenu::right-arrow {
-            width: 12px;
-            height: 12px;
-            right: 8px;
-        }
-        QMenu::separator {
-            height: 1px;
-            background: rgba(255, 255, 255, 0.15);
-            margin: 4px 8px;
-        }
-    )");
-
-#ifdef Q_OS_WIN
-    connect(&menu, &QMenu::aboutToShow, this, [this, &menu]() {
-        QTimer::singleShot(10, this, [this, &menu]() {
-            HWND hMenu = (HWND)menu.winId();
-            HWND hFence = (HWND)window()->winId();
-            
-            // 1. 移除 TOPMOST
-            LONG_PTR exStyle = GetWindowLongPtr(hMenu, GWL_EXSTYLE);
-            if (exStyle & WS_EX_TOPMOST) {
-                SetWindowLongPtr(hMenu, GWL_EXSTYLE, exStyle & ~WS_EX_TOPMOST);
-            }
-            
-            // 2. 物理裁剪圆角 (解决黑点问题)
-            BlurHelper::enableRoundedCorners(&menu, 8);
-            
-            // 3. 确保能点击外部关闭
-            SetForegroundWindow(hMenu);
-
-            // 4. 调整 Z-order 到围栏上方
-            HWND hPrev = GetWindow(hFence, GW_HWNDPREV);
-            UINT flags = SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_FRAMECHANGED;
-            
-            if (hPrev) {
-                SetWindowPos(hMenu, hPrev, 0, 0, 0, 0, flags);
-            } else {
-                SetWindowPos(hMenu, HWND_TOP, 0, 0, 0, 0, flags);
-            }
-        });
-    });
-#endif
-
-    QAction *alwaysRunAsAdminAction = menu.addAction("总是以管理员身份运行");
-    alwaysRunAsAdminAction->setIcon(QIcon(m_data.alwaysRunAsAdmin ? checkedPixmap : emptyPixmap));
-    alwaysRunAsAdminAction->setIconVisibleInMenu(true);
-
-    QAction *runAsAdminAction = menu.addAction("以管理员身份运行");
-    runAsAdminAction->setIcon(QIcon(emptyPixmap));
-    runAsAdminAction->setIconVisibleInMenu(true);
-    menu.addSeparator();
-    QAction *deleteAction = menu.addAction("删除");
-    deleteAction->setIcon(QIcon(emptyPixmap));
-    deleteAction->setIconVisibleInMenu(true);
-    QAction *propertiesAction = menu.addAction("属性");
-    propertiesAction->setIcon(QIcon(emptyPixmap));
-    propertiesAction->setIconVisibleInMenu(true);
-    QAction *selected = menu.exec(event->globalPos());
-
-    if (selected == alwaysRunAsAdminAction) {
-        const bool newValue = !m_data.alwaysRunAsAdmin;
-        if (m_data.alwaysRunAsAdmin != newValue) {
-            m_data.alwaysRunAsAdmin = newValue;
-            emit launchPreferenceChanged();
-        }
-    } else if (selected == runAsAdminAction) {
+    switch (IconActions::execContextMenu(this, event->globalPos(), m_data.alwaysRunAsAdmin)) {
+    case IconActions::ToggleAlwaysRunAsAdmin:
+        m_data.alwaysRunAsAdmin = !m_data.alwaysRunAsAdmin;
+        emit launchPreferenceChanged();
+        break;
+    case IconActions::RunAsAdmin:
         openPath(true);
-    } else if (selected == deleteAction) {
+        break;
+    case IconActions::Remove:
         emit removeRequested();
-    } else if (selected == propertiesAction) {
-#ifdef Q_OS_WIN
-        SHELLEXECUTEINFOW sei = {};
-        sei.cbSize = sizeof(SHELLEXECUTEINFOW);
-        sei.fMask = SEE_MASK_INVOKEIDLIST;
-        sei.hwnd = (HWND)window()->winId();
-        sei.lpVerb = L"properties";
-        std::wstring wPath = m_data.path.toStdWString();
-        sei.lpFile = wPath.c_str();
-        sei.nShow = SW_SHOWNORMAL;
-        ShellExecuteExW(&sei);
-#endif
+        break;
+    case IconActions::Properties:
+        IconActions::showProperties(this, m_data.path);
+        break;
+    case IconActions::NoChoice:
+        break;
     }
 }
@@ -19,7 +19,7 @@ public:
         QString path;        // 快捷方式/文件路径
         QString targetPath;  // 目标路径
         QString originalSourcePath; // 原始来源路径（用户桌面/公用桌面）
-        QPixmap icon;        // 图标
+        QPixmap icon;        // 图标（IconWidget 内部替换为显示尺寸的共享句柄）
         QPoint originalPosition = QPoint(-1, -1); // 原始桌面坐标
         bool isFromDesktop = false; // 是否来自桌面
         bool alwaysRunAsAdmin = false; // 是否默认以管理员身份启动
@@ -28,15 +28,23 @@ public:
     explicit IconWidget(const IconData &data, QWidget *parent = nullptr);
     ~IconWidget() = default;
 
-    IconData data() const;
+    const IconData &data() const;
     void setData(const IconData &data);
 
     void setTextVisible(bool visible);
     bool isTextVisible() const;
 
+    // 加载中的占位状态：只显示名称和淡色图标底框，不响应鼠标
+    void setLoading(bool loading);
+    bool isLoading() const { return m_loading; }
+
     QString name() const;
     QString path() const;
 
+    // 进程内唯一且不变的标识，拖拽时随 MIME 数据一起传递
+    quint64 id() const { return m_id; }
+    static const char *idMimeType() { return "application/x-deskgo-icon-id"; }
+
 signals:
     void doubleClicked();
     void dragStarted();
@@ -55,15 +63,17 @@ protected:
 
 private:
     void setupUi();
+    void updateIconPixmap();
     bool openPath(bool runAsAdmin);
-    void resetParentWindowZOrder();
 
     QLabel *m_iconLabel;
     QLabel *m_nameLabel;
     IconData m_data;
+    const quint64 m_id;
 
     bool m_hovered = false;
     bool m_pressed = false;
+    bool m_loading = false;
     QPoint m_pressPos;
 
     QTimer *m_tooltipTimer;
@@ -0,0 +1,55 @@
+#include "scalediconcache.h"
+#include <QHash>
+#include <QtMath>
+
+namespace {
+const int kDefaultBudgetKB = 16 * 1024;
+}
+
+uint qHash(const ScaledIconCache::Key &key, uint seed)
+{
+    return qHash(key.sourceKey, seed) ^ qHash((key.logicalSize << 16) | key.dprPercent, seed);
+}
+
+ScaledIconCache *ScaledIconCache::instance()
+{
+    static ScaledIconCache cache;
+    return &cache;
+}
+
+ScaledIconCache::ScaledIconCache()
+    : m_cache(kDefaultBudgetKB)
+{
+}
+
+void ScaledIconCache::setBudget(int kilobytes)
+{
+    m_cache.setMaxCost(qMax(0, kilobytes));
+}
+
+QPixmap ScaledIconCache::scaled(const QPixmap &source, int logicalSize, qreal dpr)
+{
+    if (source.isNull()) {
+        return source;
+    }
+
+    // 已是目标尺寸的图标（例如来自 IconCache 的预缩放图标）无需缩放，也不占用缓存
+    const int size = qRound(logicalSize * dpr);
+    if (qFuzzyCompare(source.devicePixelRatio(), dpr)
+        && source.size().scaled(size, size, Qt::KeepAspectRatio) == source.size()) {
+        return source;
+    }
+
+    const Key key{source.cacheKey(), logicalSize, qRound(dpr * 100)};
+    if (const QPixmap *cached = m_cache.object(key)) {
+        return *cached;
+    }
+
+    QPixmap result = source.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    result.setDevicePixelRatio(dpr);
+
+    // 以 KB 计费；单个条目超过预算时 QCache 不会保存，调用方仍拿到结果
+    const int cost = qMax(1, result.width() * result.height() * result.depth() / 8 / 1024);
+    m_cache.insert(key, new QPixmap(result), cost);
+    return result;
+}
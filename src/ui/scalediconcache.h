@@ -0,0 +1,47 @@
+#ifndef SCALEDICONCACHE_H
+#define SCALEDICONCACHE_H
+
+#include <QCache>
+#include <QPixmap>
+
+/**
+ * @brief 缩放图标共享缓存（仅限 GUI 线程）
+ * 以 源图标标识(cacheKey) + 逻辑尺寸 + 设备像素比 为键缓存平滑缩放后的图标，
+ * 同一来源的图标在标签、拖拽预览等处只缩放一次。返回的 QPixmap 为隐式共享句柄，
+ * IconWidget 只持有该句柄而不再保留原始大图标。
+ * 缓存按像素字节数计费，超出预算时按最近最少使用淘汰。
+ */
+class ScaledIconCache
+{
+public:
+    static ScaledIconCache *instance();
+
+    // 返回按 KeepAspectRatio 平滑缩放到 logicalSize * dpr 的图标，并设置好 devicePixelRatio
+    QPixmap scaled(const QPixmap &source, int logicalSize, qreal dpr);
+
+    // 内存预算（KB），缩小时立即淘汰多余条目
+    void setBudget(int kilobytes);
+    int budget() const { return m_cache.maxCost(); }
+    int usage() const { return m_cache.totalCost(); }
+
+    void clear() { m_cache.clear(); }
+
+private:
+    ScaledIconCache();
+
+    struct Key {
+        qint64 sourceKey;
+        int logicalSize;
+        int dprPercent;
+        bool operator==(const Key &other) const
+        {
+            return sourceKey == other.sourceKey && logicalSize == other.logicalSize
+                && dprPercent == other.dprPercent;
+        }
+    };
+    friend uint qHash(const Key &key, uint seed);
+
+    QCache<Key, QPixmap> m_cache;
+};
+
+#endif // SCALEDICONCACHE_H
@@ -0,0 +1,293 @@
+#include "snapedgeindex.h"
+#include <algorithm>
+
+namespace {
+void sortUnique(QVector<int> &values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+}
+
+void SnapEdgeIndex::clear()
+{
+    m_xEdges.clear();
+    m_yEdges.clear();
+    m_obstacleBottoms.clear();
+    m_obstacles.clear();
+    m_maxObstacleWidth = 0;
+    m_gridOrigin = QPoint();
+    m_gridStep = 0;
+}
+
+void SnapEdgeIndex::addObstacle(const QRect &rect)
+{
+    if (!rect.isValid()) {
+        return;
+    }
+    m_obstacles.append(rect);
+    m_maxObstacleWidth = qMax(m_maxObstacleWidth, rect.width());
+    m_obstacleBottoms.append(rect.bottom() + 1);
+    m_xEdges << rect.left() << rect.right() + 1;
+    m_yEdges << rect.top() << rect.bottom() + 1;
+}
+
+void SnapEdgeIndex::addWorkArea(const QRect &rect)
+{
+    if (!rect.isValid()) {
+        return;
+    }
+    m_xEdges << rect.left() << rect.right() + 1;
+    m_yEdges << rect.top() << rect.bottom() + 1;
+}
+
+void SnapEdgeIndex::setGrid(const QPoint &origin, int step)
+{
+    m_gridOrigin = origin;
+    m_gridStep = qMax(0, step);
+}
+
+void SnapEdgeIndex::build()
+{
+    sortUnique(m_xEdges);
+    sortUnique(m_yEdges);
+    sortUnique(m_obstacleBottoms);
+    std::sort(m_obstacles.begin(), m_obstacles.end(), [](const QRect &a, const QRect &b) {
+        return a.left() < b.left();
+    });
+}
+
+bool SnapEdgeIndex::nearestIn(const QVector<int> &sorted, int value, int threshold, int *edge, int *distance)
+{
+    // 最近的边只可能是第一个 >= value 的元素或它的前一个
+    const auto it = std::lower_bound(sorted.cbegin(), sorted.cend(), value);
+    int bestDistance = threshold + 1;
+    int best = value;
+    if (it != sorted.cend() && *it - value < bestDistance) {
+        bestDistance = *it - value;
+        best = *it;
+    }
+    if (it != sorted.cbegin() && value - *(it - 1) < bestDistance) {
+        bestDistance = value - *(it - 1);
+        best = *(it - 1);
+    }
+    if (bestDistance > threshold) {
+        return false;
+    }
+    *edge = best;
+    *distance = bestDistance;
+    return true;
+}
+
+bool SnapEdgeIndex::nearestGrid(int value, int origin, int threshold, int *edge, int *distance) const
+{
+    if (m_gridStep <= 0) {
+        return false;
+    }
+    // 向下取整到网格线，再比较相邻两条
+    const int offset = value - origin;
+    int line = origin + (offset / m_gridStep) * m_gridStep;
+    if (offset < 0 && offset % m_gridStep != 0) {
+        line -= m_gridStep;
+    }
+    if (value - line > line + m_gridStep - value) {
+        line += m_gridStep;
+    }
+    const int d = qAbs(value - line);
+    if (d > threshold) {
+        return false;
+    }
+    *edge = line;
+    *distance = d;
+    return true;
+}
+
+bool SnapEdgeIndex::nearestX(int value, int threshold, int *edge, int *distance) const
+{
+    int bestEdge = 0;
+    int bestDistance = threshold + 1;
+    int e = 0;
+    int d = 0;
+    if (nearestIn(m_xEdges, value, threshold, &e, &d) && d < bestDistance) {
+        bestEdge = e;
+        bestDistance = d;
+    }
+    if (nearestGrid(value, m_gridOrigin.x(), threshold, &e, &d) && d < bestDistance) {
+        bestEdge = e;
+        bestDistance = d;
+    }
+    if (bestDistance > threshold) {
+        return false;
+    }
+    *edge = bestEdge;
+    if (distance) {
+        *distance = bestDistance;
+    }
+    return true;
+}
+
+bool SnapEdgeIndex::nearestY(int value, int threshold, int *edge, int *distance) const
+{
+    int bestEdge = 0;
+    int bestDistance = threshold + 1;
+    int e = 0;
+    int d = 0;
+    if (nearestIn(m_yEdges, value, threshold, &e, &d) && d < bestDistance) {
+        bestEdge = e;
+        bestDistance = d;
+    }
+    if (nearestGrid(value, m_gridOrigin.y(), threshold, &e, &d) && d < bestDistance) {
+        bestEdge = e;
+        bestDistance = d;
+    }
+    if (bestDistance > threshold) {
+        return false;
+    }
+    *edge = bestEdge;
+    if (distance) {
+        *distance = bestDistance;
+    }
+    return true;
+}
+
+bool SnapEdgeIndex::nearestObstacleBottom(int value, int threshold, int *edge) const
+{
+    int distance = 0;
+    return nearestIn(m_obstacleBottoms, value, threshold, edge, &distance);
+}
+
+QVector<int> SnapEdgeIndex::candidates(const QRect &area) const
+{
+    QVector<int> result;
+    if (m_obstacles.isEmpty() || !area.isValid()) {
+        return result;
+    }
+    // left < area.left - 最大宽度 + 1 的障碍物不可能伸到 area 内，从这里开始扫描，越过 area 右边即停止
+    const int minLeft = area.left() - m_maxObstacleWidth + 1;
+    auto it = std::lower_bound(m_obstacles.cbegin(), m_obstacles.cend(), minLeft,
+                               [](const QRect &rect, int left) { return rect.left() < left; });
+    for (; it != m_obstacles.cend() && it->left() <= area.right(); ++it) {
+        if (it->intersects(area)) {
+            result.append(int(it - m_obstacles.cbegin()));
+        }
+    }
+    return result;
+}
+
+QRect SnapEdgeIndex::resolveMove(const QRect &start, const QRect &target) const
+{
+    QRect result = target;
+    if (m_obstacles.isEmpty()) {
+        return result;
+    }
+
+    // 只有目标位置与障碍物重叠时才推回：按起始位置判断碰撞面，贴到该障碍物的边上。
+    // 推回后可能与另一个障碍物重叠，重新取候选，每个障碍物最多处理一次
+    QVector<bool> handled(m_obstacles.size(), false);
+    for (bool moved = true; moved;) {
+        moved = false;
+        for (int i : candidates(result)) {
+            const QRect &other = m_obstacles.at(i);
+            // 起始时已与本围栏重叠的障碍物不参与限制，避免卡死
+            if (handled.at(i) || other.intersects(start)) {
+                continue;
+            }
+            handled[i] = true;
+
+            const QRect before = result;
+            if (start.right() < other.left()) {
+                result.moveRight(other.left() - 1);
+            } else if (start.left() > other.right()) {
+                result.moveLeft(other.right() + 1);
+            }
+            // 水平推回后仍重叠（对角方向或已水平对齐）时再处理垂直方向
+            if (result.intersects(other)) {
+                if (start.bottom() < other.top()) {
+                    result.moveBottom(other.top() - 1);
+                } else if (start.top() > other.bottom()) {
+                    result.moveTop(other.bottom() + 1);
+                }
+            }
+            if (result != before) {
+                moved = true;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+QRect SnapEdgeIndex::resolveResize(const QRect &start, const QRect &target, int edges) const
+{
+    if (m_obstacles.isEmpty()) {
+        return target;
+    }
+
+    int left = target.left();
+    int right = target.right();
+    int top = target.top();
+    int bottom = target.bottom();
+    QVector<int> diagonal;
+
+    // 调整大小只会让移动的边扫过 start 与 target 的并集
+    for (int i : candidates(target.united(start))) {
+        const QRect &other = m_obstacles.at(i);
+        const bool onLeft = other.right() < start.left();
+        const bool onRight = other.left() > start.right();
+        const bool above = other.bottom() < start.top();
+        const bool below = other.top() > start.bottom();
+
+        if ((onLeft || onRight) && (above || below)) {
+            diagonal.append(i);
+            continue;
+        }
+        if (onLeft && (edges & LeftEdge)) left = qMax(left, other.right() + 1);
+        if (onRight && (edges & RightEdge)) right = qMin(right, other.left() - 1);
+        if (above && (edges & TopEdge)) top = qMax(top, other.bottom() + 1);
+        if (below && (edges & BottomEdge)) bottom = qMin(bottom, other.top() - 1);
+    }
+
+    QRect result(QPoint(left, top), QPoint(right, bottom));
+
+    // 斜角方向的障碍物只收缩嵌入较浅的一边；收缩只会让矩形变小，不会产生新的重叠
+    for (int i : qAsConst(diagonal)) {
+        const QRect &other = m_obstacles.at(i);
+        if (!result.intersects(other)) {
+            continue;
+        }
+        const bool onLeft = other.right() < start.left();
+        const bool above = other.bottom() < start.top();
+        const int overlapX = onLeft ? other.right() + 1 - result.left() : result.right() + 1 - other.left();
+        const int overlapY = above ? other.bottom() + 1 - result.top() : result.bottom() + 1 - other.top();
+        const bool canX = edges & (onLeft ? LeftEdge : RightEdge);
+        const bool canY = edges & (above ? TopEdge : BottomEdge);
+        if (canX && (!canY || overlapX <= overlapY)) {
+            if (onLeft) {
+                result.setLeft(other.right() + 1);
+            } else {
+                result.setRight(other.left() - 1);
+            }
+        } else if (canY) {
+            if (above) {
+                result.setTop(other.bottom() + 1);
+            } else {
+                result.setBottom(other.top() - 1);
+            }
+        }
+    }
+
+    return result;
+}
+
+QVector<QRect> SnapEdgeIndex::contacts(const QRect &rect) const
+{
+    QVector<QRect> result;
+    const QRect ring = rect.adjusted(-1, -1, 1, 1);
+    for (int i : candidates(ring)) {
+        const QRect &other = m_obstacles.at(i);
+        if (!other.intersects(rect)) {
+            result.append(ring.intersected(other));
+        }
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+#ifndef SNAPEDGEINDEX_H
+#define SNAPEDGEINDEX_H
+
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+/**
+ * @brief 吸附边缘索引
+ * 在开始拖动/调整大小时构建一次：其他围栏的边缘、显示器工作区边缘各自排序保存，
+ * 之后每次鼠标移动只需二分查找最近的边缘，网格吸附直接按步长取整。
+ * 其他围栏同时作为碰撞障碍物，按左边缘排序，碰撞处理只扫描与目标矩形相交的候选。
+ * 右/下边缘坐标统一使用 right()+1 / bottom()+1（即不含边界的坐标）。
+ */
+class SnapEdgeIndex
+{
+public:
+    // 与 FenceWindow::ResizeEdge 取值一致
+    enum Edge {
+        LeftEdge = 1,
+        TopEdge = 2,
+        RightEdge = 4,
+        BottomEdge = 8
+    };
+
+    void clear();
+    // 其他围栏：边缘可吸附，并参与碰撞
+    void addObstacle(const QRect &rect);
+    // 显示器工作区：边缘只用于吸附
+    void addWorkArea(const QRect &rect);
+    // 网格吸附，step <= 0 时关闭
+    void setGrid(const QPoint &origin, int step);
+    // 添加完成后调用一次，对边缘和障碍物排序
+    void build();
+
+    int obstacleCount() const { return m_obstacles.size(); }
+
+    // 距离 value 最近且不超过 threshold 的竖直边（x）/ 水平边（y），含网格线
+    bool nearestX(int value, int threshold, int *edge, int *distance = nullptr) const;
+    bool nearestY(int value, int threshold, int *edge, int *distance = nullptr) const;
+    // 只在其他围栏的下边缘中查找，用于底边对齐参考线
+    bool nearestObstacleBottom(int value, int threshold, int *edge) const;
+
+    // 拖动：target 与障碍物重叠时按起始位置所在一侧推回到障碍物边上（起始时已重叠的障碍物除外）
+    QRect resolveMove(const QRect &start, const QRect &target) const;
+    // 调整大小：只限制 edges 中正在移动的边
+    QRect resolveResize(const QRect &start, const QRect &target, int edges) const;
+    // 与 rect 边对边接触的障碍物上的接触条（1 像素宽），用于显示碰撞提示
+    QVector<QRect> contacts(const QRect &rect) const;
+
+private:
+    static bool nearestIn(const QVector<int> &sorted, int value, int threshold, int *edge, int *distance);
+    bool nearestGrid(int value, int origin, int threshold, int *edge, int *distance) const;
+    // 返回与 area 相交的障碍物下标
+    QVector<int> candidates(const QRect &area) const;
+
+    QVector<int> m_xEdges;
+    QVector<int> m_yEdges;
+    QVector<int> m_obstacleBottoms;
+    // 按 left 排序，配合最大宽度确定扫描起点
+    QVector<QRect> m_obstacles;
+    int m_maxObstacleWidth = 0;
+
+    QPoint m_gridOrigin;
+    int m_gridStep = 0;
+};
+
+#endif // SNAPEDGEINDEX_H